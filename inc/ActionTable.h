@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ACTIONTABLE_H_
+#define ACTIONTABLE_H_
+
+#include <FBase.h>
+#include <FUi.h>
+
+using namespace Osp::Base;
+using namespace Osp::Ui;
+
+class BaseForm;
+typedef result (BaseForm::*EventDelegate)(const Control &src);
+
+//Action handlers of a form kept in a flat array sorted by action ID; handlers of one action stay in registration order.
+//Lookups go through an array indexed directly by action ID, which is rebuilt after registrations change.
+//Forms only use a few small IDs, so the index stays tiny; tables with IDs spread too far apart fall back to binary search.
+class ActionTable {
+public:
+	ActionTable(void);
+	~ActionTable(void);
+
+	//same handler can't be registered twice for one action
+	result Add(int actionId, EventDelegate handler);
+	//removes every handler of the action
+	result Remove(int actionId);
+	result Remove(int actionId, EventDelegate handler);
+
+	bool Contains(int actionId, EventDelegate handler);
+	//copies at most 'max' handlers of the action in registration order and returns their total number
+	int Find(int actionId, EventDelegate *pHandlers, int max);
+
+	//changes with every registration change, so a dispatch in progress can tell its copy of handlers is stale
+	unsigned int GetGeneration(void) const { return __generation; }
+	int GetCount(void) const { return __count; }
+
+	static const int MAX_DIRECT_SPAN = 1024;
+	static const int MAX_HANDLERS_PER_ACTION = 8;
+
+private:
+	ActionTable(const ActionTable &);
+	ActionTable &operator =(const ActionTable &);
+
+	struct Entry {
+		int actionId;
+		EventDelegate handler;
+	};
+
+	//index of the first entry with 'actionId' or above
+	int LowerBound(int actionId);
+	void RebuildIndex(void);
+	void RemoveRange(int from, int to);
+
+	Entry *__pEntries;
+	int __count;
+	int __capacity;
+
+	short *__pIndex;
+	int __indexBase;
+	int __indexSpan;
+	bool __indexValid;
+
+	unsigned int __generation;
+};
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ATTACHMENTSTORE_H_
+#define ATTACHMENTSTORE_H_
+
+#include <FIo.h>
+
+using namespace Osp::Io;
+
+//Content-addressed storage for media of photo and audio notes, kept in '<store>.media/' next to the database.
+//Every file is stored once under '<first 2 hash digits>/<SHA-1 hex><extension>', so identical media added twice share one copy.
+//Reference counts live in the database; this class only deals with the files.
+class AttachmentStore {
+public:
+	AttachmentStore(void);
+	~AttachmentStore(void);
+
+	result Construct(const String &dataPath);
+
+	const String &GetRoot(void) const { return __root; }
+
+	//tells whether the path points into this store; 'relative' and 'hash' are only set if it does
+	bool ParsePath(const String &path, String &relative, String &hash) const;
+	String GetAbsolutePath(const String &relative) const;
+
+	//copies the file into the store unless a file with the same content is there already
+	result Ingest(const String &srcPath, String &relative, String &hash, long long &size) const;
+	result Delete(const String &relative) const;
+
+	static result HashFile(const String &path, String &hash, long long &size);
+
+	static const int HASH_READ_CHUNK = 8192;
+
+private:
+	String __root;
+};
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AUDIOINFOEXTRACTOR_H_
+#define AUDIOINFOEXTRACTOR_H_
+
+#include <FBase.h>
+#include <FIo.h>
+
+using namespace Osp::Base;
+using namespace Osp::Io;
+
+static const int AUDIO_ENVELOPE_POINTS = 256;
+
+//Summary of an audio note kept in the database, so lists never have to open the media itself.
+struct AudioInfo {
+	//milliseconds, negative if unknown
+	int duration;
+	long long size;
+	//levels 0-255 of consecutive equal slices of the recording; empty if format could not be scanned
+	int envelopeLength;
+	byte envelope[AUDIO_ENVELOPE_POINTS];
+};
+
+//Reads duration, size and a coarse level envelope out of an audio file in one pass.
+//AMR recordings are scanned by frame headers without decoding: speech frames count as loud, DTX ones as silent.
+//PCM WAV files get real sample peaks; everything else only gets duration from content metadata.
+class AudioInfoExtractor {
+public:
+	static result Extract(const String &path, AudioInfo &info);
+
+	static const int READ_CHUNK = 8192;
+	//both AMR frames and envelope slices of PCM files are 20 ms long
+	static const int BLOCK_DURATION = 20;
+
+private:
+	static result ScanAmr(File &file, bool wideband, AudioInfo &info);
+	static result ScanWav(File &file, AudioInfo &info);
+};
+
+#endif
@@ -22,7 +22,9 @@
 #include <FUi.h>
 #include <FLocales.h>
 #include <FGraphics.h>
-#include <map>
+
+#include "ActionTable.h"
+#include "ResourceIds.h"
 
 using namespace Osp::Base;
 using namespace Osp::Ui;
@@ -35,9 +37,6 @@ enum DialogResult {
 	DIALOG_RESULT_CANCEL
 };
 
-class BaseForm;
-typedef result (BaseForm::*EventDelegate)(const Control &src);
-
 struct CallbackInfo {
 	int taskID;
 	BaseForm *callbackHandler;
@@ -60,8 +59,11 @@ public:
 
 protected:
 	result RegisterButtonPressEvent(Button *pCtrl, int actionId, EventDelegate handler);
+	//several handlers may be registered for one action, they run in registration order
 	result RegisterAction(int actionId, EventDelegate handler);
+	//safe to call from a handler; handlers removed that way are skipped by the dispatch in progress
 	void UnregisterAction(int actionId);
+	void UnregisterAction(int actionId, EventDelegate handler);
 
 	result ShowInputBox(CallbackInfo cbInfo, KeypadInputModeCategory inputMode, const String &title, const String &msg, const String &acceptButton, const String &cancelButton);
 
@@ -79,6 +81,10 @@ protected:
 	virtual void OnRemovedFromFormManager(void) {}
 	virtual void OnBecameInactive(void) {}
 	virtual void OnBecameActive(void) {}
+	//should drop anything that can be rebuilt later
+	virtual void OnLowMemory(void) {}
+	//form which can be reset for another use is kept by FormManager after release instead of being destroyed
+	virtual bool IsReusable(void) const { return false; }
 
 	static DateTime GetLocalDatetimeObject(long long ticks);
 	static long long GetCurrentTimeInUTCUnixTicks(void);
@@ -86,7 +92,9 @@ protected:
 	static MessageBoxModalResult ShowMessageBox(const String &title, const String &msg, MessageBoxStyle style);
 
 	static result Localize(Container *pCont);
+	//for IDs only known at run time; the rest should use generated StringId
 	static String GetString(const String &id);
+	static String GetString(StringId id);
 	static Bitmap* GetBitmapN(const String &name);
 
 private:
@@ -101,10 +109,12 @@ private:
 
 	void OnActionPerformed(const Control &source, int actionId);
 
+	static bool SetControlText(Control *pCtrl, const String &text);
+
 	Popup *__pCurrentPopup;
 	CallbackInfo __popupCallbackInfo;
 
-	std::map<int, EventDelegate> *__pEventMap;
+	ActionTable *__pActions;
 	bool __initialized;
 
 	DateTime __epoch;
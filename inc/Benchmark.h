@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#ifdef ALLNOTES_BENCHMARK
+
+#include "BufferedFileWriter.h"
+#include "CachingNotesManager.h"
+
+//Produces synthetic notes with titles in both shipped languages, mixed types and timestamps spread over decades.
+class SyntheticNoteEnumerator: public IEnumeratorT<Note *> {
+public:
+	SyntheticNoteEnumerator(int count, int textLength);
+	virtual ~SyntheticNoteEnumerator(void);
+
+	virtual result MoveNext(void);
+	virtual result GetCurrent(Note *&obj) const;
+	virtual result Reset(void);
+
+	static Note *CreateNoteN(int index, int textLength);
+
+private:
+	int __count;
+	int __textLength;
+	int __index;
+	Note *__pCurrent;
+};
+
+//Times storage and cache paths on a generated store and writes results as JSON.
+//Only built when ALLNOTES_BENCHMARK is defined; runs instead of the regular UI start-up.
+class Benchmark {
+public:
+	Benchmark(void);
+	~Benchmark(void);
+
+	result Construct(const String &workDir, const String &resultPath);
+
+	result Run(int noteCount, int textLength);
+
+private:
+	result RunStorageSuite(void);
+	result RunCacheSuite(void);
+	result RunCollationSuite(void);
+	result RunSortKernelSuite(void);
+	result RunDispatchSuite(void);
+	result RunStringSuite(void);
+	result RunTextSuite(void);
+
+	result GenerateStore(void);
+	void Report(const String &name, int iterations, long long elapsedMs);
+
+	static long long Now(void);
+	static void DeleteNotes(LinkedListT<Note *> *pNotes);
+	static String SortTypeName(SortType type);
+	static String FilterTypeName(FilterType type);
+
+	String __workDir;
+	String __storePath;
+	String __resultPath;
+	int __noteCount;
+	int __textLength;
+	int __reported;
+
+	BufferedFileWriter *__pOut;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BUFFEREDFILEWRITER_H_
+#define BUFFEREDFILEWRITER_H_
+
+#include <FBase.h>
+#include <FIo.h>
+
+using namespace Osp::Base;
+using namespace Osp::Io;
+
+//Accumulates small writes in a fixed buffer and hands them to File in large chunks.
+//Strings are encoded to UTF-8 straight into the buffer, so writing them allocates nothing.
+class BufferedFileWriter {
+public:
+	BufferedFileWriter(void);
+	~BufferedFileWriter(void);
+
+	result Construct(const String &path, bool append = false, int bufferSize = DEFAULT_BUFFER_SIZE);
+
+	result Write(const void *pData, int length);
+	result WriteByte(byte val);
+	result WriteUtf8(const mchar *pStr, int length);
+	result WriteUtf8(const String &str) { return WriteUtf8(str.GetPointer(), str.GetLength()); }
+
+	//writes out buffered data; 'sync' additionally asks file system to commit it to the media
+	result Flush(bool sync = false);
+	result Close(void);
+
+	long long GetBytesWritten(void) const { return __written; }
+
+	static int GetUtf8Length(const mchar *pStr, int length);
+
+	static const int DEFAULT_BUFFER_SIZE = 32 * 1024;
+
+private:
+	result Drain(void);
+
+	File *__pFile;
+	byte *__pBuffer;
+	int __capacity;
+	int __used;
+	long long __written;
+};
+
+#endif
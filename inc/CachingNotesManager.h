@@ -18,7 +18,11 @@
 #ifndef CACHINGNOTESMANAGER_H_
 #define CACHINGNOTESMANAGER_H_
 
+#include "NotesJournal.h"
 #include "NotesManager.h"
+#include "NoteSorter.h"
+#include "ResultSetCache.h"
+#include "StoreBackup.h"
 
 using namespace Osp::Base::Runtime;
 
@@ -31,7 +35,13 @@ public:
 	result Construct(CachingNotesManager *pS);
 
 	static const long REQUEST_SERIALIZATION = 150;
+	static const long REQUEST_AUDIO_INFO = 151;
+
+	//audio notes handled per pass, so a large backlog doesn't hold up flushes
+	static const int AUDIO_INFO_BATCH = 16;
 private:
+	void ExtractAudioInfo(void);
+
 	bool OnStart(void);
 	void OnStop(void);
 
@@ -42,17 +52,16 @@ private:
 	CachingNotesManager *__pSerializer;
 };
 
-#define DEF_COMPARER(x) class x: public IComparerT<Note *> {												\
-						public:																				\
-							x(bool ascending): __asc(ascending) { }											\
-						private:																			\
-							virtual result Compare(Note* const &obj1, Note* const &obj2, int &cmp) const;	\
-							bool __asc;																		\
-						}
-
-DEF_COMPARER(NoteTitleComparer);
-DEF_COMPARER(NoteDateComparer);
-DEF_COMPARER(NoteTypeComparer);
+//Notes of a single type with a sorted view over them; the view is only rebuilt when
+//the partition changed or a different order is requested.
+struct NotePartition {
+	ArrayListT<Note *> *pNotes;
+	NoteSortKey *pKeys;
+	int capacity;
+	bool sorted;
+	SortType sorting;
+	SortOrder order;
+};
 
 class CachingNotesManager: public NotesManager {
 public:
@@ -60,22 +69,78 @@ public:
 	virtual ~CachingNotesManager();
 
 	virtual result Construct(const String &path);
+	//'pListener' is told how loading of the cache goes, it's called on the constructing thread
+	result Construct(const String &path, ILoadProgressListener *pListener);
+
+	//makes serializer thread write an incremental backup after every flush
+	result EnableBackup(const String &backupRoot);
 
 	virtual result AddNote(Note *val);
 
+	//cache is only locked while a batch is written, notes already cached are kept and committed ones are added to them
+	virtual result ImportNotes(IEnumeratorT<Note *> &notes, int batchSize = DEFAULT_IMPORT_BATCH_SIZE, IImportProgressListener *pListener = null);
+
 	virtual result UpdateNote(Note *val);
 
 	virtual result RemoveNote(Note *val);
 	virtual result RemoveNote(int entry_id);
 
 	virtual LinkedListT<Note *> *GetNotesN(SortType sorting = SORT_BY_DATE, SortOrder order = SORT_ORDER_DESCENDING, NoteType type_filter = NOTE_TYPE_ALL, FilterType filter_mode = FILTER_BY_TITLE, const String &filter = L"");
+	virtual LinkedListT<Note *> *GetNotesPageN(int offset, int limit, bool &hasMore, SortType sorting = SORT_BY_DATE, SortOrder order = SORT_ORDER_DESCENDING, NoteType type_filter = NOTE_TYPE_ALL, FilterType filter_mode = FILTER_BY_TITLE, const String &filter = L"");
+	virtual LinkedListT<Note *> *GetNotesAfterN(NotesCursor &cursor, int limit, bool &hasMore, SortType sorting = SORT_BY_DATE, SortOrder order = SORT_ORDER_DESCENDING, NoteType type_filter = NOTE_TYPE_ALL, FilterType filter_mode = FILTER_BY_TITLE, const String &filter = L"");
+
+	//writes pending changes to the database and drops the journal
+	result Flush(void);
+
+	//drops memoized query results, they are rebuilt on demand
+	void ReleaseCachedResults(void);
+
+	static const int MAX_RESULT_SETS = 8;
+	static const int MAX_RESULT_SET_KEYS = 32768;
+
+	//one partition per concrete note type, including the reserved ones
+	static const int PARTITION_COUNT = NOTE_TYPE_MAP - NOTE_TYPE_TEXT + 1;
 
-	Note *GetNote(int index) const;
+protected:
+	//keeps durations of cached notes up to date as serializer thread extracts them
+	virtual void OnAudioInfoExtracted(int entry_id, const AudioInfo &info) const;
 
 private:
-	LinkedListT<Note *> *__pNotes;
+	result FlushLocked(void);
+	//tells whether audio notes were added or changed since the last call, so their metadata is worth extracting
+	bool TakeAudioChanged(void);
+	//moves media of changed notes into the attachment store while the cache stays unlocked
+	void IngestResources(void);
+	//starts the journal over at the current database generation
+	void ResetJournalLocked(void);
+	static int GetPartitionIndex(NoteType type);
+	result RebuildPartitionsLocked(void);
+	void InvalidatePartition(Note *val);
+	result EnsureSortBuffers(int count);
+	//brings the sorted view of a partition up to date, reordering its list the same way
+	result SortPartitionLocked(int index, SortType sorting, SortOrder order);
+	//index of the first key past the cursor in the sorted keys
+	static int FindCursor(const NoteSortKey *pKeys, int count, const NotesCursor &cursor, SortType sorting, SortOrder order);
+	//sorts the partitions involved and filters them; 'pKeys' points into a partition or one of the sort buffers
+	result FilterLocked(SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter, const NoteSortKey *&pKeys, int &count);
+	LinkedListT<Note *> *QueryCacheN(SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter,
+									const NotesCursor *pAfter, int offset, int limit, bool &hasMore);
+
+	ArrayListT<Note *> *__pNotes;
+	NotePartition __partitions[PARTITION_COUNT];
+	NoteSortKey *__pSortKeys;
+	NoteSortKey *__pSortTemp;
+	int __sortKeysCapacity;
+	ResultSetCache *__pResults;
+	//bumped by every mutation of the cache, so memoized results built before it are never served
+	unsigned int __epoch;
 	SerializerThread *__pSerializer;
+	StoreBackup *__pBackup;
+	NotesJournal *__pJournal;
+	ArrayListT<int> *__pRemovedIds;
+	Mutex *__pLock;
 	bool __smtChanged;
+	bool __audioChanged;
 	bool __12APIAvailable;
 
 	friend class SerializerThread;
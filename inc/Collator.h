@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef COLLATOR_H_
+#define COLLATOR_H_
+
+#include <FBase.h>
+#include <string.h>
+
+using namespace Osp::Base;
+
+//Builds binary sort keys that order titles the way a reader of the given language expects,
+//so comparing two titles is a single memcmp. Same keys are stored in the database,
+//which makes SQL 'ORDER BY title_key' and the in-memory cache agree.
+//
+//Key layout is three levels separated by 0x00 0x01, every weight being two big-endian bytes
+//not less than 0x0002: base letters (case and accents folded), accents, then case.
+class Collator {
+public:
+	Collator(void);
+
+	//language is an ISO 639 code, like the one returned by GetSystemLanguage()
+	result Construct(const String &language);
+
+	const String &GetLanguage(void) const { return __language; }
+	//language tagged with RULES_VERSION; stored keys built under a different one must be rebuilt
+	String GetRulesId(void) const;
+
+	ByteBuffer *CreateKeyN(const String &str) const;
+
+	static inline int CompareKeys(const byte *pKey1, int length1, const byte *pKey2, int length2) {
+		int length = length1 < length2 ? length1 : length2;
+		int ret = length > 0 ? memcmp(pKey1, pKey2, length) : 0;
+		return ret != 0 ? ret : length1 - length2;
+	}
+	static inline int CompareKeys(const ByteBuffer &key1, const ByteBuffer &key2) {
+		return CompareKeys(key1.GetPointer(), key1.GetLimit(), key2.GetPointer(), key2.GetLimit());
+	}
+
+	static String GetSystemLanguage(void);
+
+	//bumped whenever keys of the same string change, e.g. when case folding covers more scripts
+	static const int RULES_VERSION = 2;
+
+private:
+	//returns number of primary weights written, base letters of expansions like 'æ' go to pExpansion
+	int GetPrimaryWeights(mchar lower, int *pWeights) const;
+
+	static mchar FoldAccent(mchar lower, const char *&pExpansion);
+
+	String __language;
+	int __latinBase;
+	int __cyrillicBase;
+};
+
+#endif
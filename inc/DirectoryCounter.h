@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DIRECTORYCOUNTER_H_
+#define DIRECTORYCOUNTER_H_
+
+#include <FBase.h>
+#include <FIo.h>
+#include <FUi.h>
+
+using namespace Osp::Base;
+using namespace Osp::Base::Collection;
+using namespace Osp::Base::Runtime;
+using namespace Osp::Io;
+using namespace Osp::Ui;
+
+//Element counts of directories, enumerated on a worker thread.
+//Counts are remembered together with modification time of the directory and enumerated again only once it changes.
+//Whenever a fresh count is known, 'pTarget' receives a COUNT_READY user event with the directory path
+//and an Integer count, which is negative if the directory could not be read.
+class DirectoryCounter: public Thread {
+public:
+	DirectoryCounter(void);
+	virtual ~DirectoryCounter(void);
+
+	result Construct(int maxEntries, Control *pTarget);
+
+	//never blocks: returns last known count or -1 and queues a check of the directory
+	int GetCount(const String &dir);
+
+	//drops checks queued so far, e.g. when the listing they were requested for is gone
+	void CancelPending(void);
+
+	static int CountElements(const String &dir);
+
+	static const RequestId COUNT_READY = 170;
+	static const int DEFAULT_MAX_ENTRIES = 256;
+
+private:
+	struct Entry {
+		String path;
+		DateTime modified;
+		int count;
+	};
+
+	static const RequestId REQUEST_COUNT = 171;
+
+	bool OnStart(void);
+	void OnStop(void);
+	virtual void OnUserEventReceivedN(RequestId requestId, IList *pArgs);
+
+	//caller holds the lock
+	Entry *FindLocked(const String &path, bool touch);
+
+	int __maxEntries;
+	Control *__pTarget;
+
+	//most recently used first; accessed from both UI and worker thread
+	ArrayListT<Entry *> *__pEntries;
+	Mutex *__pLock;
+	//requests carry the generation they were queued in, older ones are skipped
+	int __generation;
+};
+
+#endif
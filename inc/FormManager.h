@@ -30,9 +30,25 @@ public:
 	static BaseForm *GetActiveForm(void);
 	static BaseForm *GetPreviousForm(void);
 
+	//lets forms held by the manager release their caches
+	static void NotifyLowMemory(void);
+
+	//returns an idle reusable form constructed from the given resource or null; it stays attached to the frame,
+	//so SetActiveForm() skips adding it and caller must not delete it
+	static BaseForm *TakePooledForm(const String &name);
+	static void ReleasePooledForms(void);
+
+	static const int MAX_POOLED_FORMS = 2;
+
 private:
+	//keeps reusable forms in the pool while there's room, removes the rest from the frame
+	static result ReleaseForm(Frame *pFrame, BaseForm *pForm);
+
 	static BaseForm *__pActiveForm;
 	static BaseForm *__pPrevForm;
+
+	static BaseForm *__pPool[MAX_POOLED_FORMS];
+	static int __pooledCount;
 };
 
 #endif
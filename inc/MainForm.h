@@ -19,7 +19,9 @@
 #define _MAINFORM_H_
 
 #include "BaseForm.h"
-#include "CachingNotesManager.h"
+#include "StoreOpener.h"
+#include "StoreRegistry.h"
+#include "ThumbnailCache.h"
 
 class MainForm: public BaseForm, public IScrollPanelEventListener, public ICustomItemEventListener {
 public:
@@ -41,17 +43,35 @@ private:
 	static const int ID_CREATE_TEXT_NOTE = 506;
 	static const int ID_EDIT_TEXT_NOTE = 507;
 
+	//list item IDs: header is 1, notes start from 2
+	static const int ID_LIST_ITEM_SHOW_MORE = 0;
+	static const int NOTES_PAGE_SIZE = 50;
+	//matches the bitmap element of the note item format
+	static const int THUMBNAIL_SIZE = 32;
+
 	bool CheckControls(void) const;
 	String SortTypeToString(SortType type) const;
 	result LoadNotes(void);
+	result LoadNextNotesPage(void);
+	CustomListItem *CreateNoteItemN(Note *pNote);
 	result UpdateOptionMenu(void);
 	result SwitchTab(void);
+	//opens the store in background; the current one is replaced once it's ready
+	result SwitchStorage(const String &path);
+	void OnStoreOpened(void);
+	result ShowStoreProgress(void);
+	void HideStoreProgress(void);
+	//reuses pooled editor when there is one; null note opens it in create mode
+	result OpenTextNoteForm(int taskId, Note *pNote);
 
 	virtual result Initialize(void);
 	virtual result Terminate(void);
 
 	virtual void DialogCallback(int taskId, BaseForm *sender, DialogResult ret, void *dataN);
 
+	virtual void OnLowMemory(void);
+	virtual void OnUserEventReceivedN(RequestId requestId, IList *pArgs);
+
 	result OnKeypadSearchClicked(const Control &src);
 	result OnKeypadClearClicked(const Control &src);
 
@@ -62,6 +82,7 @@ private:
 	result OnOptionSearchByTitleClicked(const Control &src);
 	result OnOptionSearchByTextClicked(const Control &src);
 	result OnOptionChangeStorageClicked(const Control &src);
+	result OnOptionDiagnosticsClicked(const Control &src);
 
 	result OnTabAllClicked(const Control &src);
 	result OnTabTextClicked(const Control &src);
@@ -98,6 +119,8 @@ private:
 	DEF_ACTION(ID_SOFTKEY0_CLICKED, 113);
 	DEF_ACTION(ID_SOFTKEY1_CLICKED, 114);
 
+	DEF_ACTION(ID_OPTION_DIAGNOSTICS_CLICKED, 115);
+
 	ScrollPanel *__pMainPanel;
 	EditField *__pSearchField;
 	CustomList *__pNotesList;
@@ -106,11 +129,22 @@ private:
 
 	CustomListItemFormat *__pNotesListItemFormat;
 	CustomListItemFormat *__pNotesListSortingHeaderFormat;
-	CachingNotesManager *__pNotesManager;
+	StoreRegistry *__pStores;
+	//store new notes go to and the storage dialog starts at
+	int __storeId;
+	ArrayListT<Note *> *__pShownNotes;
+	MergedNotesCursor __notesCursor;
+	bool __hasMoreNotes;
+	ThumbnailCache *__pThumbnails;
+	StoreOpener *__pStoreOpener;
+	Popup *__pStorePopup;
+	Progress *__pStoreProgress;
+	String __backupRoot;
 	NoteType __currentTab;
 	SortType __currentSorting;
 	SortOrder __currentSortOrder;
 	FilterType __currentFilterMode;
+	bool __diagnosticsEnabled;
 
 	Bitmap *__pHeaderIconAsc;
 	Bitmap *__pHeaderIconDesc;
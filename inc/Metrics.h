@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <FBase.h>
+#include <FBaseRuntime.h>
+
+using namespace Osp::Base;
+using namespace Osp::Base::Runtime;
+
+enum MetricCounter {
+	METRIC_DB_OPENS = 0,
+	METRIC_STATEMENTS_PREPARED,
+	METRIC_ROWS_READ,
+	METRIC_TEXT_BYTES_LOADED,
+	METRIC_CACHE_HITS,
+	METRIC_CACHE_MISSES,
+	METRIC_RESULT_SET_HITS,
+	METRIC_RESULT_SET_MISSES,
+	METRIC_COUNTER_COUNT
+};
+
+enum MetricHistogram {
+	METRIC_FLUSH_DURATION = 0,
+	METRIC_LIST_REFRESH,
+	METRIC_EDITOR_OPEN_COLD,
+	METRIC_EDITOR_OPEN_WARM,
+	METRIC_HISTOGRAM_COUNT
+};
+
+//Always-on process-wide counters and millisecond latency histograms.
+//Callers should aggregate locally and report once per operation, not per row.
+class Metrics {
+public:
+	static const int HISTOGRAM_BUCKETS = 11;
+
+	static result Initialize(void);
+	static void Shutdown(void);
+
+	static void Add(MetricCounter counter, long long value = 1);
+	static void Observe(MetricHistogram histogram, long long ms);
+
+	static long long GetCounter(MetricCounter counter);
+	static String FormatReport(void);
+	static result DumpToFile(const String &path);
+
+	//upper bounds of every bucket but the last one, which catches the rest
+	static const int BUCKET_BOUNDS[HISTOGRAM_BUCKETS - 1];
+
+private:
+	struct Histogram {
+		long long buckets[HISTOGRAM_BUCKETS];
+		long long count;
+		long long sum;
+		long long max;
+	};
+
+	static long long __counters[METRIC_COUNTER_COUNT];
+	static Histogram __histograms[METRIC_HISTOGRAM_COUNT];
+	static Mutex *__pLock;
+};
+
+//Measures the enclosing scope into a histogram.
+class MetricsTimer {
+public:
+	MetricsTimer(MetricHistogram histogram);
+	~MetricsTimer(void);
+
+	//for scopes which only find out along the way what they are measuring
+	void SetHistogram(MetricHistogram histogram) { __histogram = histogram; }
+
+private:
+	MetricHistogram __histogram;
+	long long __start;
+};
+
+#endif
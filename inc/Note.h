@@ -35,6 +35,7 @@ enum NoteType {
 class Note {
 public:
 	Note(void);
+	~Note(void);
 
 	result Construct(NoteType type);
 
@@ -65,24 +66,51 @@ public:
 	void SetText(const String &text) {
 		__text = text;
 	}
-	String GetText(void) const {
+	const String &GetText(void) const {
 		return __text;
 	}
 
 	void SetTitle(const String &title) {
 		__title = title;
+		SetTitleKey(null);
 	}
-	String GetTitle(void) const {
+	const String &GetTitle(void) const {
 		return __title;
 	}
 
 	void SetResourcePath(const String &resPath) {
 		__resPath = resPath;
 	}
-	String GetResourcePath(void) const {
+	const String &GetResourcePath(void) const {
 		return __resPath;
 	}
 
+	//milliseconds, negative until audio metadata of the note is extracted
+	int GetAudioDuration(void) const {
+		return __audioDuration;
+	}
+	void SetAudioDuration(int duration) {
+		__audioDuration = duration;
+	}
+
+	//slot of the store the note came from when read through StoreRegistry, -1 otherwise
+	int GetStoreId(void) const {
+		return __storeId;
+	}
+	void SetStoreId(int storeId) {
+		__storeId = storeId;
+	}
+
+	//collation key of the title, null until NotesManager builds or loads one
+	const ByteBuffer *GetTitleKey(void) const {
+		return __pTitleKey;
+	}
+	//takes ownership of the key
+	void SetTitleKey(ByteBuffer *pKey) {
+		if (__pTitleKey) delete __pTitleKey;
+		__pTitleKey = pKey;
+	}
+
 private:
 	bool __serialized;
 
@@ -94,6 +122,13 @@ private:
 	String __text;
 	String __title;
 	String __resPath;
+	int __audioDuration;
+	int __storeId;
+
+	ByteBuffer *__pTitleKey;
+
+	Note(const Note &);
+	Note &operator =(const Note &);
 
 	void SetEntryID(int id) {
 		__entryId = id;
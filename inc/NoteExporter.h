@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef NOTEEXPORTER_H_
+#define NOTEEXPORTER_H_
+
+#include <FIo.h>
+
+#include "BufferedFileWriter.h"
+#include "Note.h"
+
+using namespace Osp::Base::Runtime;
+using namespace Osp::Io;
+
+enum ExportFormat {
+	EXPORT_FORMAT_JSON_LINES,
+	EXPORT_FORMAT_TEXT_FOLDER
+};
+
+class IExportProgressListener {
+public:
+	virtual ~IExportProgressListener(void) {}
+
+	//both are called from the thread export is running on
+	virtual void OnExportProgress(int exported, int total) = 0;
+	virtual void OnExportFinished(result res) {}
+};
+
+//Streams note store contents to a file or a folder, reading the database row by row, so memory usage does not depend on store size.
+//Export can be run synchronously through Export() or on its own worker thread through Start().
+//Database is read directly, so pending changes of a CachingNotesManager should be serialized beforehand.
+class NoteExporter: public Thread {
+public:
+	NoteExporter(void);
+	virtual ~NoteExporter(void);
+
+	result Construct(const String &dataPath, ExportFormat format, const String &destPath, IExportProgressListener *pListener = null);
+
+	result Export(void);
+	void Cancel(void) { __canceled = true; }
+
+	static const int PROGRESS_STEP = 100;
+
+private:
+	virtual Object *Run(void);
+
+	result ExportJsonLines(DbEnumerator *pEnum, int total);
+	result ExportTextFolder(DbEnumerator *pEnum, int total);
+
+	static result WriteJsonString(BufferedFileWriter &writer, const String &str);
+	static result WriteNumber(BufferedFileWriter &writer, long long val);
+
+	String __dataPath;
+	String __destPath;
+	ExportFormat __format;
+	IExportProgressListener *__pListener;
+	volatile bool __canceled;
+};
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef NOTESORTER_H_
+#define NOTESORTER_H_
+
+#include "Collator.h"
+#include "NotesManager.h"
+
+//Everything a comparison needs, laid out contiguously so sorting never touches Note or copies strings.
+//Title key points into the note's collation key and is only valid while the cache lock is held.
+struct NoteSortKey {
+	long long primary;
+	const byte *pTitleKey;
+	int titleKeyLength;
+	bool marked;
+	Note *pNote;
+};
+
+//marked notes always go first, the rest follows requested order
+class NoteSortKeyLess {
+public:
+	NoteSortKeyLess(bool byTitle, bool ascending): __byTitle(byTitle), __asc(ascending) { }
+
+	inline bool operator()(const NoteSortKey &a, const NoteSortKey &b) const {
+		if (a.marked != b.marked) {
+			return a.marked;
+		}
+
+		int cmp = 0;
+		if (__byTitle) {
+			cmp = Collator::CompareKeys(a.pTitleKey, a.titleKeyLength, b.pTitleKey, b.titleKeyLength);
+		} else if (a.primary != b.primary) {
+			//64-bit values are compared directly, their difference may not fit into int
+			cmp = a.primary < b.primary ? -1 : 1;
+		}
+		return __asc ? cmp < 0 : cmp > 0;
+	}
+
+private:
+	bool __byTitle;
+	bool __asc;
+};
+
+//Sort kernels for the notes cache. Dates and types are plain integers, so they are
+//sorted without comparisons: LSD radix on (marked, timestamp), counting sort on (marked, type).
+//All kernels are stable, equal keys keep their previous relative order.
+class NoteSorter {
+public:
+	//below this many keys radix passes cost more than a comparison sort
+	static const int RADIX_THRESHOLD = 64;
+	//from this many keys on, chunks are sorted on worker threads and merged
+	static const int PARALLEL_THRESHOLD = 50000;
+	static const int PARALLEL_WORKERS = 2;
+
+	//picks a kernel by sort type and list size; pTemp must hold 'count' keys, result ends up in pKeys
+	static result Sort(NoteSortKey *pKeys, NoteSortKey *pTemp, int count, SortType sorting, bool ascending);
+
+	static void SortSequential(NoteSortKey *pKeys, NoteSortKey *pTemp, int count, SortType sorting, bool ascending);
+	static void RadixSortByDate(NoteSortKey *pKeys, NoteSortKey *pTemp, int count, bool ascending);
+	static void CountingSortByType(NoteSortKey *pKeys, NoteSortKey *pTemp, int count, bool ascending);
+	static result SortParallel(NoteSortKey *pKeys, NoteSortKey *pTemp, int count, SortType sorting, bool ascending, int workers);
+
+	static const int MAX_MERGE_RUNS = 8;
+	//merges up to MAX_MERGE_RUNS sorted runs into pDst; on equal keys earlier runs go first
+	static void MergeRuns(const NoteSortKey *const *ppRuns, const int *pCounts, int runs, NoteSortKey *pDst, SortType sorting, bool ascending);
+};
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef NOTESJOURNAL_H_
+#define NOTESJOURNAL_H_
+
+#include <FIo.h>
+#include <map>
+
+#include "Note.h"
+
+using namespace Osp::Base::Collection;
+using namespace Osp::Io;
+
+enum JournalOperation {
+	JOURNAL_OP_ADD = 1,
+	JOURNAL_OP_UPDATE,
+	JOURNAL_OP_REMOVE,
+	//header record only, written by Reset()
+	JOURNAL_OP_BEGIN
+};
+
+//Append-only log of cache mutations which were not serialized to the database yet.
+//Every record is written and flushed synchronously, so it survives a crash of the application.
+//Record layout: varint payload length, payload, 1 byte checksum; payload is op, varint note key and, for add/update, note fields.
+//Notes already in the database are keyed by entry ID, new ones by a temporary journal ID.
+//The file starts with a header record holding the database generation the logged changes are based on,
+//so records already committed by a flush which crashed before Reset() are not applied twice.
+class NotesJournal {
+public:
+	NotesJournal(void);
+	~NotesJournal(void);
+
+	result Construct(const String &dataPath);
+
+	result Append(JournalOperation op, const Note *pNote);
+	//logs removal of a stored note by its entry ID, for when its Note object is already gone
+	result AppendRemove(int entryId);
+
+	//applies logged mutations to the freshly loaded cache; removed entry IDs are appended to 'pRemovedIds';
+	//'generation' is the current database generation, negative if unknown
+	result Replay(IListT<Note *> *pNotes, ArrayListT<int> *pRemovedIds, long long generation, bool &changed);
+
+	//must only be called once everything logged so far is committed to the database at 'generation'
+	result Reset(long long generation);
+
+private:
+	int GetKey(const Note *pNote);
+	result Grow(int required);
+	//frames payload written at 'header' up to 'end' and flushes it to the file
+	result WriteRecord(int header, int end);
+
+	int PutVarint(int pos, unsigned long long val);
+	int PutString(int pos, const String &str);
+
+	static bool GetVarint(const byte *pData, int len, int &pos, unsigned long long &val);
+	static bool GetString(const byte *pData, int len, int &pos, String &str);
+
+	String __path;
+	File *__pFile;
+
+	byte *__pScratch;
+	int __scratchSize;
+
+	std::map<const Note *, int> __tempIds;
+	int __nextTempId;
+};
+
+#endif
@@ -18,9 +18,15 @@
 #ifndef NOTESMANAGER_H_
 #define NOTESMANAGER_H_
 
+#include <FIo.h>
+
+#include "AttachmentStore.h"
+#include "AudioInfoExtractor.h"
+#include "Collator.h"
 #include "Note.h"
 
 using namespace Osp::Base::Collection;
+using namespace Osp::Io;
 
 enum SortType {
 	SORT_BY_DATE,
@@ -33,11 +39,63 @@ enum FilterType {
 	FILTER_BY_TEXT
 };
 
+class IImportProgressListener {
+public:
+	virtual ~IImportProgressListener(void) {}
+
+	//called after every committed batch with the total number of notes imported so far
+	virtual void OnImportProgress(int imported) = 0;
+};
+
+class ILoadProgressListener {
+public:
+	virtual ~ILoadProgressListener(void) {}
+
+	//called every LOAD_PROGRESS_STEP rows and once at the end; 'total' is counted before reading starts
+	virtual void OnLoadProgress(int loaded, int total) = 0;
+};
+
+//position right after the last note of a page; only valid for the ordering it was taken with
+class NotesCursor {
+public:
+	NotesCursor(void);
+	~NotesCursor(void);
+
+	void Reset(void);
+	void Set(SortType sorting, SortOrder order, bool marked, long long primary, const ByteBuffer *pTitleKey, int entryId);
+
+	bool IsAtStart(void) const { return !__valid; }
+	bool Matches(SortType sorting, SortOrder order) const { return !__valid || (__sorting == sorting && __order == order); }
+
+	bool GetMarked(void) const { return __marked; }
+	long long GetPrimary(void) const { return __primary; }
+	const ByteBuffer *GetTitleKey(void) const { return __pTitleKey; }
+	int GetEntryId(void) const { return __entryId; }
+
+private:
+	NotesCursor(const NotesCursor &);
+	NotesCursor &operator =(const NotesCursor &);
+
+	bool __valid;
+	SortType __sorting;
+	SortOrder __order;
+	bool __marked;
+	long long __primary;
+	ByteBuffer *__pTitleKey;
+	int __entryId;
+};
+
 class NotesManager {
 public:
 	NotesManager(void) {
 		__dataPath = L"";
 		__lastEntryId = 0;
+		__pCollator = null;
+		__pAttachments = null;
+	}
+	virtual ~NotesManager(void) {
+		if (__pCollator) delete __pCollator;
+		if (__pAttachments) delete __pAttachments;
 	}
 	virtual result Construct(const String &path);
 
@@ -47,6 +105,10 @@ public:
 
 	virtual result SerializeNotes(const ICollectionT<Note *> &pNotes);
 
+	//inserts every note yielded by the enumerator, committing a transaction each 'batchSize' notes;
+	//notes are not retained or modified, so enumerator may free each one once it advances; their IDs live only in the database
+	virtual result ImportNotes(IEnumeratorT<Note *> &notes, int batchSize = DEFAULT_IMPORT_BATCH_SIZE, IImportProgressListener *pListener = null);
+
 	virtual result UpdateNote(Note *val) const;
 
 	virtual result RemoveAll(void) const;
@@ -56,11 +118,62 @@ public:
 
 	virtual LinkedListT<Note *> *GetNotesN(SortType sorting = SORT_BY_DATE, SortOrder order = SORT_ORDER_DESCENDING, NoteType type_filter = NOTE_TYPE_ALL, FilterType filter_mode = FILTER_BY_TITLE, const String &filter = L"") const;
 
+	//returns at most 'limit' notes starting at 'offset' in the same order as GetNotesN
+	virtual LinkedListT<Note *> *GetNotesPageN(int offset, int limit, bool &hasMore, SortType sorting = SORT_BY_DATE, SortOrder order = SORT_ORDER_DESCENDING, NoteType type_filter = NOTE_TYPE_ALL, FilterType filter_mode = FILTER_BY_TITLE, const String &filter = L"") const;
+	//returns at most 'limit' notes following the cursor and moves it past them; cursor taken with different ordering is reset
+	virtual LinkedListT<Note *> *GetNotesAfterN(NotesCursor &cursor, int limit, bool &hasMore, SortType sorting = SORT_BY_DATE, SortOrder order = SORT_ORDER_DESCENDING, NoteType type_filter = NOTE_TYPE_ALL, FilterType filter_mode = FILTER_BY_TITLE, const String &filter = L"") const;
+
+	//extracts metadata of at most 'maxNotes' audio notes which have none yet; 'extracted' tells how many were processed
+	result ExtractAudioInfo(int maxNotes, int &extracted) const;
+	result GetAudioInfo(int entry_id, AudioInfo &info) const;
+
+	static const int DEFAULT_IMPORT_BATCH_SIZE = 500;
+	static const int LOAD_PROGRESS_STEP = 256;
+
+protected:
+	//called for every note ExtractAudioInfo() stored metadata for
+	virtual void OnAudioInfoExtracted(int entry_id, const AudioInfo &info) const {}
+
+	//builds the key on first use, so notes created outside of the store get one too
+	const ByteBuffer *GetTitleKey(Note *val) const;
+	void AdvanceCursor(NotesCursor &cursor, Note *pLast, SortType sorting, SortOrder order) const;
+	//modification generation of the database, advanced by every committed write
+	result GetGeneration(long long &generation) const;
+	//same as GetNotesN() with default arguments, reporting rows read to 'pListener'
+	LinkedListT<Note *> *LoadNotesN(ILoadProgressListener *pListener) const;
+	//copies media at 'path' into the attachment store and registers it there, so saving a note pointing
+	//at 'storedPath' later only has to bind it; 'storedPath' is 'path' itself if there's nothing to copy
+	result IngestResource(const String &path, String &storedPath) const;
+	//inserts notes owned by the caller in one transaction; they only get entry IDs and are marked serialized once it commits
+	result ImportBatch(const IListT<Note *> &notes);
+
 private:
 	result Load(void);
+	result Upgrade(Database *pDb, int fromVersion) const;
+	result BumpGeneration(Database *pDb) const;
+	//rebuilds stored keys when system language changed or some rows lack a key
+	result RefreshTitleKeys(Database *pDb) const;
+	//only binds the key the note already has, so serializing shared notes never modifies them
+	result BindTitleKey(DbStatement *pStmt, int index, Note *val) const;
+	//points the note at its copy in the attachment store, making one if needed
+	void IngestResource(Note *val) const;
+	//binds path and hash at 'index' and 'index + 1'; media outside of the attachment store is bound without hash
+	result BindResource(DbStatement *pStmt, int index, Note *val) const;
+	//fixes paths after the store was moved and counts references of rows restored without hash
+	result RelinkAttachments(Database *pDb) const;
+	//deletes media which no note references anymore
+	result CollectAttachments(Database *pDb) const;
+	//negative 'limit' fetches everything; 'pAfter' switches from offset to keyset paging
+	LinkedListT<Note *> *QueryNotesN(SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter,
+									const NotesCursor *pAfter, int offset, int limit, bool &hasMore, ILoadProgressListener *pListener = null, int total = 0) const;
+
+	int AllocateEntryIds(int count);
+	result InsertNote(Database *pDb, DbStatement *pEntries, DbStatement *pResources, Note *val, int entry_id) const;
 
 	String __dataPath;
 	int __lastEntryId;
+	Collator *__pCollator;
+	AttachmentStore *__pAttachments;
 };
 
 #endif
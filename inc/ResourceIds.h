@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+//Generated by tools/gen_resources.py from Res/*.xml, do not edit by hand.
+
+#ifndef RESOURCEIDS_H_
+#define RESOURCEIDS_H_
+
+#include <FBase.h>
+
+enum StringId {
+	STR_MAINFORM_DIAGNOSTICS_DUMP_FAILED,
+	STR_MAINFORM_DIAGNOSTICS_DUMP_SAVED,
+	STR_MAINFORM_DIAGNOSTICS_TITLE,
+	STR_MAINFORM_NOTES_LIST_HEADER_TITLE,
+	STR_MAINFORM_NOTES_LIST_SHOW_MORE,
+	STR_MAINFORM_OPTIONMENU_DIAGNOSTICS,
+	STR_MAINFORM_OPTIONMENU_SEARCH_BY,
+	STR_MAINFORM_OPTIONMENU_SEARCH_BY_TEXT,
+	STR_MAINFORM_OPTIONMENU_SEARCH_BY_TITLE,
+	STR_MAINFORM_OPTIONMENU_SORT_BY,
+	STR_MAINFORM_OPTIONMENU_SORT_BY_DATE,
+	STR_MAINFORM_OPTIONMENU_SORT_BY_TITLE,
+	STR_MAINFORM_OPTIONMENU_SORT_BY_TYPE,
+	STR_MAINFORM_OPTIONMENU_SOURCE,
+	STR_MAINFORM_SEARCH_FIELD_GUIDE,
+	STR_MAINFORM_SEARCH_FIELD_GUIDE_BY_TEXT,
+	STR_MAINFORM_SEARCH_FIELD_GUIDE_BY_TITLE,
+	STR_MAINFORM_SEARCH_KEYPAD_CLEAR,
+	STR_MAINFORM_SEARCH_KEYPAD_SEARCH,
+	STR_MAINFORM_SOFTKEY_ADD,
+	STR_MAINFORM_STORE_OPENING_MSG,
+	STR_MAINFORM_STORE_OPENING_TITLE,
+	STR_MAINFORM_STORE_OPEN_FAILED_MSG,
+	STR_MAINFORM_STORE_OPEN_FAILED_TITLE,
+	STR_MAINFORM_TAB_TITLE_ALL,
+	STR_MAINFORM_TAB_TITLE_AUDIO,
+	STR_MAINFORM_TAB_TITLE_PHOTO,
+	STR_MAINFORM_TAB_TITLE_TEXT,
+	STR_SAVEFORM_ACCEPT_BUTTON,
+	STR_SAVEFORM_CANCEL_BUTTON,
+	STR_SAVEFORM_DIRLIST_TITLE,
+	STR_SAVEFORM_DIR_ENTRY_APPFOLDER,
+	STR_SAVEFORM_DIR_ENTRY_INFO,
+	STR_SAVEFORM_DIR_ENTRY_INFO_COUNTING,
+	STR_SAVEFORM_DIR_ENTRY_INFO_EMPTY,
+	STR_SAVEFORM_DIR_ENTRY_INTMEM,
+	STR_SAVEFORM_DIR_ENTRY_STORAGECARD,
+	STR_SAVEFORM_FILENAME_FIELD_TITLE,
+	STR_SAVEFORM_FILE_ENTRY_INFO_FORMAT,
+	STR_SAVEFORM_INPUT_DIRNAME_ACCEPT_BUTTON,
+	STR_SAVEFORM_INPUT_DIRNAME_MSG,
+	STR_SAVEFORM_INPUT_DIRNAME_TITLE,
+	STR_SAVEFORM_MBOX_DIR_MSG,
+	STR_SAVEFORM_MBOX_DIR_TITLE,
+	STR_SAVEFORM_MBOX_FILE_MSG,
+	STR_SAVEFORM_MBOX_TEXT,
+	STR_SAVEFORM_MBOX_TITLE,
+	STR_SAVEFORM_NAVIGATE_BACK,
+	STR_SAVEFORM_OPTIONMENU_CREATE_FOLDER,
+	STR_SAVEFORM_TITLE,
+	STR_SORT_TYPE_DATE,
+	STR_SORT_TYPE_TITLE,
+	STR_SORT_TYPE_TYPE,
+	STR_TEXTNOTE_FORM_MBOX_MSG,
+	STR_TEXTNOTE_FORM_SOFTKEY_ACCEPT_EDIT,
+	STR_TEXTNOTE_FORM_SOFTKEY_ACCEPT_NEW,
+	STR_TEXTNOTE_FORM_SOFTKEY_CANCEL,
+	STR_TEXTNOTE_FORM_TEXT_CAPTION,
+	STR_TEXTNOTE_FORM_TIME_CAPTION,
+	STR_TEXTNOTE_FORM_TITLEFIELD_TITLE,
+	STR_TEXTNOTE_FORM_TITLE_EDIT,
+	STR_TEXTNOTE_FORM_TITLE_NEW,
+	STRING_COUNT
+};
+
+enum ResourceLanguage {
+	RES_LANGUAGE_ENG,
+	RES_LANGUAGE_RUS,
+	RES_LANGUAGE_COUNT
+};
+
+//control with the text it gets from BaseForm::Localize()
+struct ResControlString {
+	const mchar *pControl;
+	StringId text;
+};
+
+//strings of a form or popup; missing title or softkey strings are -1
+struct ResContainerStrings {
+	const mchar *pName;
+	int title;
+	int softkeys[2];
+	int controlCount;
+	const ResControlString *pControls;
+};
+
+//ISO 639 codes in ResourceLanguage order
+extern const mchar *const RES_LANGUAGE_CODES[RES_LANGUAGE_COUNT];
+//resource IDs in StringId order
+extern const mchar *const RES_STRING_IDS[STRING_COUNT];
+extern const mchar *const RES_STRINGS[RES_LANGUAGE_COUNT][STRING_COUNT];
+
+static const int RES_CONTAINER_COUNT = 4;
+extern const ResContainerStrings RES_CONTAINERS[RES_CONTAINER_COUNT];
+
+static const mchar IDF_MAINFORM[] = L"IDF_MAINFORM";
+static const mchar IDC_MAINFORM_MAIN_SCROLLPANEL[] = L"IDC_MAINFORM_MAIN_SCROLLPANEL";
+static const mchar IDPC_MAINFORM_SEARCH_FIELD[] = L"IDPC_MAINFORM_SEARCH_FIELD";
+static const mchar IDPC_MAINFORM_LIST[] = L"IDPC_MAINFORM_LIST";
+static const mchar IDPC_MAINFORM_SEARCH_ICON[] = L"IDPC_MAINFORM_SEARCH_ICON";
+
+static const mchar IDF_SAVEFORM[] = L"IDF_SAVEFORM";
+static const mchar IDC_SAVEFORM_FILENAME_FIELD[] = L"IDC_SAVEFORM_FILENAME_FIELD";
+static const mchar IDC_SAVEFORM_DIRLIST[] = L"IDC_SAVEFORM_DIRLIST";
+static const mchar IDC_SAVEFORM_DIRLIST_CAPTION[] = L"IDC_SAVEFORM_DIRLIST_CAPTION";
+
+static const mchar IDF_TEXTNOTE_FORM[] = L"IDF_TEXTNOTE_FORM";
+static const mchar IDC_TEXTNOTE_FORM_TITLEFIELD[] = L"IDC_TEXTNOTE_FORM_TITLEFIELD";
+static const mchar IDC_TEXTNOTE_FORM_MARK_BUTTON[] = L"IDC_TEXTNOTE_FORM_MARK_BUTTON";
+static const mchar IDC_TEXTNOTE_FORM_EDITAREA[] = L"IDC_TEXTNOTE_FORM_EDITAREA";
+static const mchar IDC_TEXTNOTE_FORM_CAPTION[] = L"IDC_TEXTNOTE_FORM_CAPTION";
+static const mchar IDC_TEXTNOTE_FORM_TIMECAPTION[] = L"IDC_TEXTNOTE_FORM_TIMECAPTION";
+static const mchar IDC_TEXTNOTE_FORM_TIMELABEL[] = L"IDC_TEXTNOTE_FORM_TIMELABEL";
+
+static const mchar IDP_INPUT_POPUP[] = L"IDP_INPUT_POPUP";
+static const mchar IDC_INPUT_POPUP_FIELD[] = L"IDC_INPUT_POPUP_FIELD";
+static const mchar IDC_INPUT_POPUP_TEXT[] = L"IDC_INPUT_POPUP_TEXT";
+static const mchar IDC_INPUT_POPUP_CANCEL_BUTTON[] = L"IDC_INPUT_POPUP_CANCEL_BUTTON";
+static const mchar IDC_INPUT_POPUP_ACCEPT_BUTTON[] = L"IDC_INPUT_POPUP_ACCEPT_BUTTON";
+
+#endif
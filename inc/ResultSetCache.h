@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef RESULTSETCACHE_H_
+#define RESULTSETCACHE_H_
+
+#include "NoteSorter.h"
+
+//Arguments of a notes query; two queries with equal keys yield the same notes in the same order.
+struct ResultSetKey {
+	SortType sorting;
+	SortOrder order;
+	NoteType typeFilter;
+	FilterType filterMode;
+	String filter;
+
+	bool Equals(const ResultSetKey &other) const;
+};
+
+//Small LRU of filtered and sorted query results over the notes cache.
+//Every entry is tagged with the mutation epoch it was built at and is dropped on lookup once the epoch moves on.
+//Entry count and total number of stored keys are both bounded.
+class ResultSetCache {
+public:
+	ResultSetCache(void);
+	~ResultSetCache(void);
+
+	result Construct(int maxEntries, int maxKeys);
+
+	//returns stored keys or null; 'count' receives their number
+	const NoteSortKey *Find(const ResultSetKey &key, unsigned int epoch, int &count);
+	//copies the keys, evicting least recently used entries to stay within bounds; too large sets are not stored
+	result Put(const ResultSetKey &key, unsigned int epoch, const NoteSortKey *pKeys, int count);
+
+	void Clear(void);
+
+	int GetKeyCount(void) const { return __keyCount; }
+
+private:
+	struct Entry {
+		ResultSetKey key;
+		unsigned int epoch;
+		NoteSortKey *pKeys;
+		int count;
+	};
+
+	void RemoveAt(int index);
+
+	//most recently used first
+	ArrayListT<Entry *> *__pEntries;
+	int __maxEntries;
+	int __maxKeys;
+	int __keyCount;
+};
+
+#endif
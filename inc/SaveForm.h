@@ -19,6 +19,7 @@
 #define _SAVEFORM_H_
 
 #include "BaseForm.h"
+#include "DirectoryCounter.h"
 
 using namespace Osp::Base::Collection;
 
@@ -37,8 +38,36 @@ private:
 
 	static const int ID_INPUT_DIRECTORY_NAME = 503;
 
+	//listings of recently visited directories kept to be shown again without enumerating
+	static const int MAX_CACHED_LISTINGS = 8;
+
+	struct DirListing {
+		String path;
+		DateTime modified;
+		bool hasParent;
+		//full paths of subdirectories
+		LinkedList dirs;
+		LinkedList fileNames;
+		LinkedList fileInfos;
+	};
+
+	enum DirIcon {
+		ICON_FOLDER,
+		ICON_FOLDER_INTM,
+		ICON_FOLDER_MC,
+		ICON_FILE,
+		ICON_BACK,
+		ICON_COUNT
+	};
+
 	bool CheckControls(void) const;
-	int GetDirectoryElementsCount(const String &dir) const;
+	String GetElementsInfo(int count, bool counted);
+	//'counted' tells a negative count is final rather than pending
+	CustomListItem *CreateDirItemN(int itemId, const String &path, int count, bool counted);
+	//cached listing if directory hasn't changed since, otherwise a freshly enumerated one; owned by the form
+	DirListing *GetListing(const String &dir);
+	void DropListing(const String &dir);
+	static void DeleteListing(DirListing *pListing);
 	result FillRootDirList(void);
 	result FillDirList(const String &dir);
 	result NavigateToPath(const String &path);
@@ -57,6 +86,8 @@ private:
 	virtual void OnItemStateChanged(const Control &source, int index, int itemId, ItemStatus status);
 	virtual void OnItemStateChanged(const Control &source, int index, int itemId, int elementId, ItemStatus status) {}
 
+	virtual void OnUserEventReceivedN(RequestId requestId, IList *pArgs);
+
 	DEF_ACTION(ID_SOFTKEY0_CLICKED, 100);
 	DEF_ACTION(ID_SOFTKEY1_CLICKED, 101);
 
@@ -73,6 +104,13 @@ private:
 	LinkedList *__pCurrentDirList;
 	LinkedList *__pCurrentFileList;
 	Stack *__pNavigationHistory;
+	bool __rootListed;
+
+	//decoded once, rows copy them
+	Bitmap *__pIcons[ICON_COUNT];
+	DirectoryCounter *__pCounter;
+	//most recently used first
+	ArrayListT<DirListing *> *__pListings;
 
 	CallbackInfo __cbInfo;
 	String __startingPath;
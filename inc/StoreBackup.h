@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef STOREBACKUP_H_
+#define STOREBACKUP_H_
+
+#include <FIo.h>
+
+#include "AttachmentStore.h"
+#include "BufferedFileWriter.h"
+
+using namespace Osp::Base::Collection;
+using namespace Osp::Io;
+
+//Incremental backup of a note store.
+//Backup directory holds one full copy of the database ('base_<generation>.bin') and a chain of delta files
+//('delta_<from>_<to>.bin'), each containing notes modified and removed between two modification generations.
+//Files only get their final names once completely written, so an interrupted backup leaves previous state intact.
+//Media the backed up notes reference is mirrored to 'media/', so it survives being collected from the store itself.
+class StoreBackup {
+public:
+	StoreBackup(void);
+	~StoreBackup(void);
+
+	//backups of every store go to a separate subdirectory of 'backupRoot'
+	result Construct(const String &dataPath, const String &backupRoot);
+
+	//writes notes changed since the previous backup to a new delta; takes a new base instead if there is none yet or chain is too long
+	result Backup(void);
+
+	//reconstructs store from newest base and its deltas at 'destPath', which must not exist yet
+	result Restore(const String &destPath) const;
+
+	String GetBackupDirectory(void) const { return __dir; }
+
+	static const int MAX_DELTAS = 64;
+
+private:
+	result GetState(long long &baseGen, long long &lastGen, int &deltaCount) const;
+	result TakeBase(void);
+	result WriteDelta(Database *pDb, long long fromGen, long long toGen);
+	result ApplyDelta(Database *pDb, const String &path, long long expectedFrom, long long &toGen) const;
+	void Prune(long long baseGen) const;
+
+	String GetMediaDir(void) const;
+	//copies media listed by 'query' (relative paths in the attachment store) to the backup, unless it's there already
+	result SaveMedia(Database *pDb, const String &query) const;
+	//drops backed up media which the base at 'basePath' doesn't reference anymore
+	void PruneMedia(const String &basePath) const;
+	//copies backed up media into the attachment store of 'destPath' and registers it in the restored database
+	result RestoreMedia(Database *pDb, const String &destPath) const;
+	static result ListMedia(const String &root, ArrayListT<String> &relatives);
+
+	String GetBasePath(long long gen) const;
+	String GetDeltaPath(long long fromGen, long long toGen) const;
+
+	static bool ParseBaseName(const String &name, long long &gen);
+	static bool ParseDeltaName(const String &name, long long &fromGen, long long &toGen);
+	static result ReadGeneration(Database *pDb, long long &gen);
+
+	static result WriteInt32(BufferedFileWriter &writer, int val);
+	static result WriteInt64(BufferedFileWriter &writer, long long val);
+	static result WriteString(BufferedFileWriter &writer, const String &str);
+
+	static bool ReadInt32(const ByteBuffer &buf, int &pos, int &val);
+	static bool ReadInt64(const ByteBuffer &buf, int &pos, long long &val);
+	static bool ReadString(const ByteBuffer &buf, int &pos, String &str);
+
+	String __dataPath;
+	String __dir;
+};
+
+#endif
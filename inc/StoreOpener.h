@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef STOREOPENER_H_
+#define STOREOPENER_H_
+
+#include <FUi.h>
+
+#include "CachingNotesManager.h"
+
+using namespace Osp::Ui;
+
+//Opens a notes store on a worker thread, so the one in use keeps serving the UI meanwhile.
+//Opening validates the file, upgrades its schema and loads the whole cache; 'pTarget' receives STORE_OPEN_PROGRESS
+//with an Integer percentage of notes loaded so far and STORE_OPENED once done, after which the thread can be joined.
+class StoreOpener: public Thread, public ILoadProgressListener {
+public:
+	StoreOpener(void);
+	virtual ~StoreOpener(void);
+
+	//empty 'backupRoot' leaves backups of the new store off
+	result Construct(const String &path, const String &backupRoot, Control *pTarget);
+
+	const String &GetPath(void) const { return __path; }
+	//only meaningful once STORE_OPENED arrived
+	result GetResult(void) const { return __result; }
+	//hands the opened store over to the caller, null if it failed to open
+	CachingNotesManager *DetachManagerN(void);
+
+	static const RequestId STORE_OPEN_PROGRESS = 180;
+	static const RequestId STORE_OPENED = 181;
+
+private:
+	virtual Object *Run(void);
+	virtual void OnLoadProgress(int loaded, int total);
+	void ReportProgress(int percent);
+
+	String __path;
+	String __backupRoot;
+	Control *__pTarget;
+	CachingNotesManager *__pManager;
+	result __result;
+	int __lastPercent;
+};
+
+#endif
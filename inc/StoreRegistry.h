@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef STOREREGISTRY_H_
+#define STOREREGISTRY_H_
+
+#include "CachingNotesManager.h"
+
+//Position in the merged view: every store keeps its own cursor right after the last note taken from it.
+class MergedNotesCursor {
+public:
+	MergedNotesCursor(void) {}
+
+	void Reset(void);
+
+private:
+	MergedNotesCursor(const MergedNotesCursor &);
+	MergedNotesCursor &operator =(const MergedNotesCursor &);
+
+	NotesCursor __stores[NoteSorter::MAX_MERGE_RUNS];
+
+	friend class StoreRegistry;
+};
+
+//Several note stores mounted at once, each with its own cache and serializer thread.
+//Queries go to every mounted store and are merged into one list in the usual order; notes come back stamped
+//with the slot of their store. Entry IDs are only unique within a store, global IDs put the slot into the high bits.
+class StoreRegistry {
+public:
+	StoreRegistry(void);
+	~StoreRegistry(void);
+
+	//'backupRoot' applies to every store mounted afterwards, empty leaves backups off
+	result Construct(const String &backupRoot = L"");
+
+	//loads the store synchronously; mounting the same path twice returns the slot it already has
+	result Mount(const String &path, int &storeId);
+	//takes over a store constructed elsewhere, e.g. in background by StoreOpener; the store is deleted if it can't be mounted
+	//or its path is mounted already, in which case the slot of that one is returned
+	result Attach(CachingNotesManager *pStore, int &storeId);
+	//writes pending changes of the store and closes it; its slot may be reused by the next mount
+	result Unmount(int storeId);
+
+	CachingNotesManager *GetStore(int storeId) const;
+	int FindStore(const String &path) const;
+	int GetMountedCount(void) const;
+
+	result AddNote(int storeId, Note *val);
+	result UpdateNote(Note *val);
+	result RemoveNote(Note *val);
+
+	LinkedListT<Note *> *GetNotesN(SortType sorting = SORT_BY_DATE, SortOrder order = SORT_ORDER_DESCENDING, NoteType type_filter = NOTE_TYPE_ALL, FilterType filter_mode = FILTER_BY_TITLE, const String &filter = L"");
+	LinkedListT<Note *> *GetNotesPageN(int offset, int limit, bool &hasMore, SortType sorting = SORT_BY_DATE, SortOrder order = SORT_ORDER_DESCENDING, NoteType type_filter = NOTE_TYPE_ALL, FilterType filter_mode = FILTER_BY_TITLE, const String &filter = L"");
+	LinkedListT<Note *> *GetNotesAfterN(MergedNotesCursor &cursor, int limit, bool &hasMore, SortType sorting = SORT_BY_DATE, SortOrder order = SORT_ORDER_DESCENDING, NoteType type_filter = NOTE_TYPE_ALL, FilterType filter_mode = FILTER_BY_TITLE, const String &filter = L"");
+
+	result Flush(void);
+	void ReleaseCachedResults(void);
+
+	//-1 if either part doesn't fit, e.g. for notes which weren't saved yet
+	static int MakeGlobalId(int storeId, int entryId) {
+		if (storeId < 0 || storeId >= MAX_STORES || entryId < 0 || entryId >= (1 << ENTRY_ID_BITS)) {
+			return -1;
+		}
+		return (storeId << ENTRY_ID_BITS) | entryId;
+	}
+	static int GetStoreId(int globalId) { return globalId >> ENTRY_ID_BITS; }
+	static int GetLocalId(int globalId) { return globalId & ((1 << ENTRY_ID_BITS) - 1); }
+	static int GetGlobalId(const Note *val) { return MakeGlobalId(val->GetStoreId(), val->GetEntryId()); }
+
+	//one merge run per store
+	static const int MAX_STORES = NoteSorter::MAX_MERGE_RUNS;
+	static const int ENTRY_ID_BITS = 24;
+
+private:
+	//merges per-store results, which each must already be in requested order; takes ownership of the lists
+	LinkedListT<Note *> *MergeN(LinkedListT<Note *> **ppLists, int skip, int limit, bool &hasMore, Note **ppLastTaken, SortType sorting, SortOrder order) const;
+	static void FillSortKey(NoteSortKey &key, Note *val, SortType sorting);
+	static void SetCursor(NotesCursor &cursor, Note *val, SortType sorting, SortOrder order);
+
+	CachingNotesManager *__pStores[MAX_STORES];
+	String __backupRoot;
+};
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef STRINGTABLE_H_
+#define STRINGTABLE_H_
+
+#include <FBase.h>
+#include <FUi.h>
+
+#include "ResourceIds.h"
+
+using namespace Osp::Base;
+using namespace Osp::Base::Collection;
+using namespace Osp::Ui;
+
+//Resource keys for localizing one container, built once per container name.
+struct ContainerKeys {
+	String name;
+	int controlCount;
+	String titleKey;
+	String softkeyKeys[2];
+	//'<control name>_TEXT' for every control in order
+	String *pControlKeys;
+};
+
+//Strings known at build time come from tables generated by tools/gen_resources.py, picked by system language.
+//The rest is a memo over application resource strings. Resource language is picked at start-up and doesn't change
+//while the application runs, so every string is fetched from resources once, missing ones included.
+//Only meant for the UI thread.
+class StringTable {
+public:
+	static String Get(StringId id);
+	//same contract as AppResource::GetString: returns the ID itself and sets last result when there is no such string
+	static String Get(const String &id);
+
+	//generated table holding the same strings AppResource picked for the device, or the first one if none does
+	static ResourceLanguage GetLanguage(void);
+
+	//returns null if the container has no name to key the lists by
+	static const ContainerKeys *GetContainerKeys(const Container &cont);
+
+	static void Shutdown(void);
+
+	static const int INITIAL_CAPACITY = 128;
+	static const int MAX_CONTAINERS = 16;
+
+private:
+	struct Entry {
+		bool used;
+		int hash;
+		String id;
+		String value;
+		result res;
+	};
+
+	//slot holding the ID or the empty one it should go to
+	static int FindSlot(const String &id, int hash);
+	static void Grow(void);
+	static ContainerKeys *BuildContainerKeysN(const Container &cont);
+
+	//open addressing with linear probing, kept at most half full
+	static Entry *__pEntries;
+	static int __capacity;
+	static int __count;
+
+	static ArrayListT<ContainerKeys *> *__pContainers;
+	static int __language;
+};
+
+#endif
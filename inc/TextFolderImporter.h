@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TEXTFOLDERIMPORTER_H_
+#define TEXTFOLDERIMPORTER_H_
+
+#include <FIo.h>
+
+#include "Note.h"
+
+using namespace Osp::Base::Collection;
+using namespace Osp::Io;
+
+//Walks a folder (and its subfolders) and yields a text note for every .txt/.md file in it, one at a time.
+//Yielded note is owned by the importer and is freed when it advances, so it is meant to be passed to NotesManager::ImportNotes.
+class TextFolderImporter: public IEnumeratorT<Note *> {
+public:
+	TextFolderImporter(void);
+	virtual ~TextFolderImporter(void);
+
+	result Construct(const String &dir);
+
+	virtual result MoveNext(void);
+	virtual result GetCurrent(Note *&obj) const;
+	virtual result Reset(void);
+
+	static const int MAX_FILE_SIZE = 1024 * 1024;
+
+private:
+	result OpenNextDirectory(void);
+	Note *ReadNoteN(const String &path, bool markdown) const;
+
+	static String ExtractTitle(const String &text, bool markdown);
+	static long long ToUnixSeconds(const DateTime &dt);
+
+	String __rootDir;
+	String __currentDir;
+	Stack *__pPendingDirs;
+	Directory *__pDir;
+	DirEnumerator *__pDirEnum;
+	Note *__pCurrent;
+};
+
+#endif
@@ -29,9 +29,27 @@ public:
 
 	virtual result Construct(void);
 
+	//prepares pooled form for another note; null note switches it to create mode
+	result Reset(CallbackInfo cbInfo, Note *note = null);
+
+protected:
+	virtual bool IsReusable(void) const { return true; }
+
 private:
+	enum MarkBitmap {
+		MARK_BITMAP_MARKED_NORMAL,
+		MARK_BITMAP_MARKED_PRESSED,
+		MARK_BITMAP_UNMARKED_NORMAL,
+		MARK_BITMAP_UNMARKED_PRESSED,
+		MARK_BITMAP_COUNT
+	};
+
 	bool CheckControls(void) const;
+	//fills controls from the note or clears them for a new one
+	result ApplyNote(void);
 	result UpdateMarkButton(void);
+	//decoded on first use and kept for the form's lifetime
+	Bitmap *GetMarkBitmap(MarkBitmap index);
 
 	virtual result Initialize(void);
 	virtual result Terminate(void);
@@ -57,6 +75,9 @@ private:
 	Note *__pNote;
 	bool __isMarked;
 
+	Dimension __textAreaSize;
+	Bitmap *__pMarkBitmaps[MARK_BITMAP_COUNT];
+
 	CallbackInfo __cbInfo;
 };
 
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TEXTUTILS_H_
+#define TEXTUTILS_H_
+
+#include <FBase.h>
+
+using namespace Osp::Base;
+
+//Characters of a string or a part of it, borrowed without copying; only valid while the source is unchanged.
+struct TextView {
+	const mchar *pChars;
+	int length;
+
+	TextView(void): pChars(null), length(0) { }
+	TextView(const mchar *pStr, int len): pChars(pStr), length(len) { }
+	explicit TextView(const String &str): pChars(str.GetPointer()), length(str.GetLength()) { }
+};
+
+//Appends into a buffer on the stack and only goes to the heap once that is full.
+//Meant to be a local: build, take ToString() once, let it go. After a failed append every later one fails too,
+//so checking the result of the last one is enough.
+class TextBuilder {
+public:
+	TextBuilder(void);
+	~TextBuilder(void);
+
+	result Append(mchar ch);
+	result Append(const mchar *pStr);
+	result Append(const TextView &text);
+	result Append(const String &str) { return Append(TextView(str)); }
+	result Append(int value);
+
+	//folds case of everything appended so far in place
+	void FoldCase(void);
+
+	int GetLength(void) const { return __length; }
+	TextView GetView(void) const { return TextView(__pChars, __length); }
+	String ToString(void) const;
+
+	static const int STACK_CAPACITY = 512;
+
+private:
+	TextBuilder(const TextBuilder &);
+	TextBuilder &operator =(const TextBuilder &);
+
+	result Reserve(int extra);
+
+	mchar *__pChars;
+	int __length;
+	int __capacity;
+	bool __failed;
+	mchar __stack[STACK_CAPACITY];
+};
+
+class TextUtils {
+public:
+	//simple case folding; Latin-1, Latin Extended-A and basic Cyrillic are folded inline, other scripts by the platform;
+	//'upper' tells if the letter was folded
+	static mchar FoldCase(mchar ch, bool &upper);
+	static inline mchar FoldCase(mchar ch) {
+		bool upper = false;
+		return FoldCase(ch, upper);
+	}
+	static void FoldCaseInPlace(mchar *pChars, int length);
+
+	//'pFoldedNeedle' must be folded already, haystack is folded on the fly without copying it
+	static bool ContainsFolded(const TextView &haystack, const mchar *pFoldedNeedle, int needleLength);
+	static bool Contains(const TextView &haystack, const TextView &needle);
+
+	//largest cut not above 'maxLength' which doesn't split a surrogate pair or separate a combining mark from its base
+	static int GetSafeCut(const TextView &text, int maxLength);
+	//texts not shorter than 'maxLength' are cut at a safe position and get '...' appended
+	static String Truncate(const String &text, int maxLength);
+
+	static inline bool IsCombiningMark(mchar ch) {
+		return (ch >= 0x0300 && ch <= 0x036F) || (ch >= 0x0483 && ch <= 0x0489) || (ch >= 0x1DC0 && ch <= 0x1DFF)
+				|| (ch >= 0x20D0 && ch <= 0x20FF) || (ch >= 0xFE20 && ch <= 0xFE2F);
+	}
+	static inline bool IsLowSurrogate(mchar ch) { return ch >= 0xDC00 && ch <= 0xDFFF; }
+
+	//length automatic titles are cut to
+	static const int AUTO_TITLE_LENGTH = 57;
+};
+
+#endif
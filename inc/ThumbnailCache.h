@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef THUMBNAILCACHE_H_
+#define THUMBNAILCACHE_H_
+
+#include <FBase.h>
+#include <FGraphics.h>
+#include <FIo.h>
+#include <FUi.h>
+
+using namespace Osp::Base;
+using namespace Osp::Base::Collection;
+using namespace Osp::Base::Runtime;
+using namespace Osp::Graphics;
+using namespace Osp::Io;
+using namespace Osp::Ui;
+
+//Thumbnails of photo notes at list row size.
+//Photos are decoded on a worker thread straight to thumbnail size and saved as raw RGB565 files named after
+//the resource path and its modification time, so an edited photo gets a new thumbnail. Recently used thumbnails
+//are kept in a small in-memory LRU. Once a thumbnail becomes available, 'pTarget' receives a THUMBNAIL_READY
+//user event with the resource path as its only argument.
+class ThumbnailCache: public Thread {
+public:
+	ThumbnailCache(void);
+	virtual ~ThumbnailCache(void);
+
+	result Construct(const String &cacheDir, int size, int maxEntries, Control *pTarget);
+
+	//never blocks: returns null and queues a decode if thumbnail is not in memory yet; returned bitmap is owned by the cache
+	Bitmap *GetThumbnail(const String &path);
+
+	//drops in-memory thumbnails, files on disk are kept
+	void Clear(void);
+
+	static const RequestId THUMBNAIL_READY = 160;
+	static const int DEFAULT_MAX_ENTRIES = 64;
+
+private:
+	struct Entry {
+		String path;
+		//null while still decoding or after failing to decode; neither is requested again
+		Bitmap *pBitmap;
+	};
+
+	static const RequestId REQUEST_DECODE = 161;
+
+	bool OnStart(void);
+	void OnStop(void);
+	virtual void OnUserEventReceivedN(RequestId requestId, IList *pArgs);
+
+	Bitmap *LoadN(const String &path);
+	String GetCachePath(const String &path, const DateTime &modified) const;
+	Bitmap *ReadFileN(const String &cachePath) const;
+	result WriteFile(const String &cachePath, const Bitmap &bitmap) const;
+
+	void RemoveAt(int index);
+
+	String __dir;
+	int __size;
+	int __maxEntries;
+	Control *__pTarget;
+
+	//most recently used first; accessed from both UI and worker thread
+	ArrayListT<Entry *> *__pEntries;
+	Mutex *__pLock;
+};
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <FBase.h>
+
+using namespace Osp::Base;
+
+//Scoped timers for hot paths. Without ALLNOTES_TRACING every TRACE_SCOPE expands to nothing.
+#ifdef ALLNOTES_TRACING
+
+#include <FBaseRuntime.h>
+
+using namespace Osp::Base::Runtime;
+
+struct TraceEvent {
+	//must point to a string literal, events outlive the scope that recorded them
+	const char *name;
+	long long start;
+	long long duration;
+	int threadId;
+};
+
+class Tracer {
+public:
+	static const int DEFAULT_CAPACITY = 4096;
+
+	static result Initialize(int capacity = DEFAULT_CAPACITY);
+	static void Shutdown(void);
+
+	static void Record(const char *name, long long start, long long end);
+	static long long Now(void);
+
+	//writes buffered events in Chrome trace-event format, oldest first
+	static result DumpToFile(const String &path);
+
+private:
+	static TraceEvent *__pEvents;
+	static int __capacity;
+	static int __next;
+	static int __count;
+	static Mutex *__pLock;
+};
+
+class TraceScope {
+public:
+	TraceScope(const char *name) {
+		__name = name;
+		__start = Tracer::Now();
+	}
+	~TraceScope(void) {
+		Tracer::Record(__name, __start, Tracer::Now());
+	}
+
+private:
+	const char *__name;
+	long long __start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(__traceScope, __LINE__)(name)
+
+#else
+
+#define TRACE_SCOPE(name)
+
+#endif
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ActionTable.h"
+
+ActionTable::ActionTable(void) {
+	__pEntries = null;
+	__count = 0;
+	__capacity = 0;
+	__pIndex = null;
+	__indexBase = 0;
+	__indexSpan = 0;
+	__indexValid = false;
+	__generation = 0;
+}
+
+ActionTable::~ActionTable(void) {
+	if (__pEntries) delete[] __pEntries;
+	if (__pIndex) delete[] __pIndex;
+}
+
+int ActionTable::LowerBound(int actionId) {
+	if (!__indexValid) {
+		RebuildIndex();
+	}
+
+	if (__pIndex) {
+		int slot = actionId - __indexBase;
+		if (slot < 0) {
+			return 0;
+		}
+		if (slot > __indexSpan) {
+			return __count;
+		}
+		return __pIndex[slot];
+	}
+
+	int lo = 0, hi = __count;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (__pEntries[mid].actionId < actionId) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+void ActionTable::RebuildIndex(void) {
+	__indexValid = true;
+
+	int span = __count > 0 ? __pEntries[__count - 1].actionId - __pEntries[0].actionId : -1;
+	if (span < 0 || span >= MAX_DIRECT_SPAN) {
+		if (__pIndex) delete[] __pIndex;
+		__pIndex = null;
+		__indexSpan = 0;
+		return;
+	}
+
+	if (!__pIndex || span > __indexSpan) {
+		if (__pIndex) delete[] __pIndex;
+		__pIndex = new short[span + 1];
+	}
+	__indexBase = __pEntries[0].actionId;
+	__indexSpan = span;
+
+	//every slot points at the first entry with its ID or, for unused IDs, at the next used one
+	int entry = 0;
+	for (int slot = 0; slot <= span; slot++) {
+		while (entry < __count && __pEntries[entry].actionId < __indexBase + slot) {
+			entry++;
+		}
+		__pIndex[slot] = (short)entry;
+	}
+}
+
+result ActionTable::Add(int actionId, EventDelegate handler) {
+	if (!handler) {
+		return E_INVALID_ARG;
+	}
+	if (Contains(actionId, handler)) {
+		return E_ALREADY_CONNECTED;
+	}
+	if (__count >= 0x7fff) {
+		return E_OVERFLOW;
+	}
+
+	if (__count == __capacity) {
+		int capacity = __capacity > 0 ? __capacity * 2 : 16;
+		Entry *pEntries = new Entry[capacity];
+		for (int i = 0; i < __count; i++) {
+			pEntries[i] = __pEntries[i];
+		}
+		if (__pEntries) delete[] __pEntries;
+		__pEntries = pEntries;
+		__capacity = capacity;
+	}
+
+	//after the handlers already registered for the action
+	int pos = LowerBound(actionId + 1);
+	for (int i = __count; i > pos; i--) {
+		__pEntries[i] = __pEntries[i - 1];
+	}
+	__pEntries[pos].actionId = actionId;
+	__pEntries[pos].handler = handler;
+	__count++;
+
+	__indexValid = false;
+	__generation++;
+	return E_SUCCESS;
+}
+
+void ActionTable::RemoveRange(int from, int to) {
+	int removed = to - from;
+	for (int i = from; i + removed < __count; i++) {
+		__pEntries[i] = __pEntries[i + removed];
+	}
+	__count -= removed;
+
+	__indexValid = false;
+	__generation++;
+}
+
+result ActionTable::Remove(int actionId) {
+	int from = LowerBound(actionId);
+	int to = from;
+	while (to < __count && __pEntries[to].actionId == actionId) {
+		to++;
+	}
+	if (to == from) {
+		return E_OBJ_NOT_FOUND;
+	}
+
+	RemoveRange(from, to);
+	return E_SUCCESS;
+}
+
+result ActionTable::Remove(int actionId, EventDelegate handler) {
+	for (int i = LowerBound(actionId); i < __count && __pEntries[i].actionId == actionId; i++) {
+		if (__pEntries[i].handler == handler) {
+			RemoveRange(i, i + 1);
+			return E_SUCCESS;
+		}
+	}
+	return E_OBJ_NOT_FOUND;
+}
+
+bool ActionTable::Contains(int actionId, EventDelegate handler) {
+	for (int i = LowerBound(actionId); i < __count && __pEntries[i].actionId == actionId; i++) {
+		if (__pEntries[i].handler == handler) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int ActionTable::Find(int actionId, EventDelegate *pHandlers, int max) {
+	int found = 0;
+	for (int i = LowerBound(actionId); i < __count && __pEntries[i].actionId == actionId; i++) {
+		if (found < max) {
+			pHandlers[found] = __pEntries[i].handler;
+		}
+		found++;
+	}
+	return found;
+}
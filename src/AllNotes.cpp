@@ -16,13 +16,23 @@
  * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "AllNotes.h"
+#include "Benchmark.h"
 #include "FormManager.h"
 #include "MainForm.h"
+#include "Metrics.h"
+#include "StringTable.h"
+#include "Trace.h"
 
 AllNotes::AllNotes() {
 }
 
 AllNotes::~AllNotes() {
+	//forms and their worker threads are gone by now, so nothing can trace, count or look up strings anymore
+#ifdef ALLNOTES_TRACING
+	Tracer::Shutdown();
+#endif
+	Metrics::Shutdown();
+	StringTable::Shutdown();
 }
 
 Application *AllNotes::CreateInstance(void) {
@@ -32,6 +42,34 @@ Application *AllNotes::CreateInstance(void) {
 bool AllNotes::OnAppInitializing(AppRegistry &appRegistry) {
 	PowerManager::SetScreenEventListener(*this);
 
+	Metrics::Initialize();
+
+#ifdef ALLNOTES_TRACING
+	Tracer::Initialize();
+#endif
+
+#ifdef ALLNOTES_BENCHMARK
+	int bench_notes = 10000;
+	if (IsFailed(appRegistry.Get(L"BENCHMARK_NOTE_COUNT", bench_notes))) {
+		appRegistry.Add(L"BENCHMARK_NOTE_COUNT", bench_notes);
+	}
+	int bench_text = 256;
+	if (IsFailed(appRegistry.Get(L"BENCHMARK_TEXT_LENGTH", bench_text))) {
+		appRegistry.Add(L"BENCHMARK_TEXT_LENGTH", bench_text);
+	}
+	appRegistry.Save();
+
+	Benchmark bench;
+	result bench_res = bench.Construct(L"/Home/Benchmark/", L"/Home/benchmark_results.json");
+	if (!IsFailed(bench_res)) {
+		bench_res = bench.Run(bench_notes, bench_text);
+	}
+	if (IsFailed(bench_res)) {
+		AppLogException("Benchmark run failed, error: [%s]", GetErrorMessage(bench_res));
+	}
+	return false;
+#endif
+
 	MainForm *pMainForm = new MainForm();
 	result res = pMainForm->Construct();
 	if (IsFailed(res)) {
@@ -49,6 +87,10 @@ bool AllNotes::OnAppInitializing(AppRegistry &appRegistry) {
 }
 
 bool AllNotes::OnAppTerminating(AppRegistry &appRegistry, bool forcedTermination) {
+#ifdef ALLNOTES_TRACING
+	Tracer::DumpToFile(L"/Home/trace.json");
+#endif
+
 	// TODO:
 	// Deallocate resources allocated by this application for termination.
 	// The application's permanent data and context can be saved via appRegistry.
@@ -66,8 +108,7 @@ void AllNotes::OnBackground(void) {
 }
 
 void AllNotes::OnLowMemory(void) {
-	// TODO:
-	// Free unused resources or close the application.
+	FormManager::NotifyLowMemory();
 }
 
 void AllNotes::OnBatteryLevelChanged(BatteryLevel batteryLevel) {
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <FSecurity.h>
+
+#include "AttachmentStore.h"
+
+using namespace Osp::Security::Crypto;
+
+AttachmentStore::AttachmentStore(void) {
+	__root = L"";
+}
+
+AttachmentStore::~AttachmentStore(void) {
+}
+
+result AttachmentStore::Construct(const String &dataPath) {
+	__root = dataPath;
+	__root.Append(L".media/");
+
+	result res = Directory::Create(__root, true);
+	if (IsFailed(res) && res != E_FILE_ALREADY_EXIST) {
+		AppLogException("Failed to create attachment directory [%S], error: [%s]", __root.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+	return E_SUCCESS;
+}
+
+bool AttachmentStore::ParsePath(const String &path, String &relative, String &hash) const {
+	if (__root.IsEmpty() || !path.StartsWith(__root, 0)) {
+		return false;
+	}
+
+	String rel;
+	if (IsFailed(path.SubString(__root.GetLength(), rel))) {
+		return false;
+	}
+
+	int slash = -1, dot = -1;
+	if (IsFailed(rel.IndexOf('/', 0, slash))) {
+		return false;
+	}
+	if (IsFailed(rel.LastIndexOf('.', rel.GetLength() - 1, dot)) || dot < slash) {
+		dot = rel.GetLength();
+	}
+
+	String name;
+	if (IsFailed(rel.SubString(slash + 1, dot - slash - 1, name)) || name.IsEmpty()) {
+		return false;
+	}
+
+	relative = rel;
+	hash = name;
+	return true;
+}
+
+String AttachmentStore::GetAbsolutePath(const String &relative) const {
+	String path = __root;
+	path.Append(relative);
+	return path;
+}
+
+result AttachmentStore::Ingest(const String &srcPath, String &relative, String &hash, long long &size) const {
+	result res = HashFile(srcPath, hash, size);
+	if (IsFailed(res)) {
+		AppLogException("Failed to hash attachment [%S], error: [%s]", srcPath.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	//extension is kept, media decoders pick the codec by it
+	String ext = L"";
+	int slash = -1, dot = -1;
+	srcPath.LastIndexOf('/', srcPath.GetLength() - 1, slash);
+	if (!IsFailed(srcPath.LastIndexOf('.', srcPath.GetLength() - 1, dot)) && dot > slash) {
+		srcPath.SubString(dot, ext);
+		ext.ToLowerCase();
+	}
+
+	String dir;
+	hash.SubString(0, 2, dir);
+
+	relative = dir;
+	relative.Append('/');
+	relative.Append(hash);
+	relative.Append(ext);
+
+	String dest = GetAbsolutePath(relative);
+	if (File::IsFileExist(dest)) {
+		return E_SUCCESS;
+	}
+
+	res = Directory::Create(GetAbsolutePath(dir), true);
+	if (IsFailed(res) && res != E_FILE_ALREADY_EXIST) {
+		AppLogException("Failed to create attachment directory for [%S], error: [%s]", dest.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	//file only gets its final name once completely copied
+	String tmp = dest;
+	tmp.Append(L".tmp");
+	if (File::IsFileExist(tmp)) {
+		File::Remove(tmp);
+	}
+
+	res = File::Copy(srcPath, tmp, true);
+	if (IsFailed(res)) {
+		AppLogException("Failed to copy attachment [%S] to the store, error: [%s]", srcPath.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	res = File::Move(tmp, dest);
+	if (IsFailed(res)) {
+		AppLogException("Failed to finalize attachment [%S], error: [%s]", dest.GetPointer(), GetErrorMessage(res));
+		File::Remove(tmp);
+		return res;
+	}
+	return E_SUCCESS;
+}
+
+result AttachmentStore::Delete(const String &relative) const {
+	String path = GetAbsolutePath(relative);
+	if (!File::IsFileExist(path)) {
+		return E_SUCCESS;
+	}
+
+	result res = File::Remove(path);
+	if (IsFailed(res)) {
+		AppLogException("Failed to remove attachment [%S], error: [%s]", path.GetPointer(), GetErrorMessage(res));
+	}
+	return res;
+}
+
+result AttachmentStore::HashFile(const String &path, String &hash, long long &size) {
+	size = 0;
+
+	File file;
+	result res = file.Construct(path, L"r");
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	Sha1Hash sha;
+	res = sha.Initialize();
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	ByteBuffer chunk;
+	res = chunk.Construct(HASH_READ_CHUNK);
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	//media files can be large, so they are never read into memory whole
+	while (true) {
+		chunk.Clear();
+		res = file.Read(chunk);
+		if (res == E_END_OF_FILE) {
+			break;
+		} else if (IsFailed(res)) {
+			return res;
+		}
+		chunk.Flip();
+		if (chunk.GetLimit() == 0) {
+			break;
+		}
+
+		size += chunk.GetLimit();
+		res = sha.Update(chunk);
+		if (IsFailed(res)) {
+			return res;
+		}
+	}
+
+	ByteBuffer *pDigest = sha.FinalizeN();
+	res = GetLastResult();
+	if (!pDigest) {
+		return IsFailed(res) ? res : E_FAILURE;
+	}
+
+	static const mchar HEX[] = L"0123456789abcdef";
+	hash = L"";
+	for (int i = 0; i < pDigest->GetLimit(); i++) {
+		byte b = 0;
+		pDigest->GetByte(i, b);
+		hash.Append(HEX[b >> 4]);
+		hash.Append(HEX[b & 0x0F]);
+	}
+	delete pDigest;
+
+	return E_SUCCESS;
+}
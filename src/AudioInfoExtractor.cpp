@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <FContent.h>
+#include <cstring>
+
+#include "AudioInfoExtractor.h"
+
+using namespace Osp::Content;
+
+//frame payload sizes by frame type, 3GPP TS 26.101 and 26.201; unused types carry nothing
+static const int AMR_NB_FRAME_SIZES[16] = { 12, 13, 15, 17, 19, 20, 26, 31, 5, 0, 0, 0, 0, 0, 0, 0 };
+static const int AMR_WB_FRAME_SIZES[16] = { 17, 23, 32, 36, 40, 46, 50, 58, 60, 5, 0, 0, 0, 0, 0, 0 };
+static const int AMR_NB_SID = 8;
+static const int AMR_WB_SID = 9;
+
+//Collects one level per block; once all points are used, neighbours are averaged in pairs,
+//so the envelope always spans the whole recording without knowing its length up front.
+class EnvelopeBuilder {
+public:
+	EnvelopeBuilder(void) {
+		__count = 0;
+		__blocksPerPoint = 1;
+		__pending = 0;
+		__pendingSum = 0;
+		__blocks = 0;
+	}
+
+	void Add(int level) {
+		__blocks++;
+		__pendingSum += level;
+		if (++__pending < __blocksPerPoint) {
+			return;
+		}
+		__points[__count++] = __pendingSum / __pending;
+		__pending = 0;
+		__pendingSum = 0;
+
+		if (__count == AUDIO_ENVELOPE_POINTS) {
+			for (int i = 0; i < AUDIO_ENVELOPE_POINTS / 2; i++) {
+				__points[i] = (__points[2 * i] + __points[2 * i + 1]) / 2;
+			}
+			__count = AUDIO_ENVELOPE_POINTS / 2;
+			__blocksPerPoint *= 2;
+		}
+	}
+
+	void Finish(AudioInfo &info) {
+		if (__pending > 0) {
+			__points[__count++] = __pendingSum / __pending;
+			__pending = 0;
+			__pendingSum = 0;
+		}
+		info.envelopeLength = __count;
+		for (int i = 0; i < __count; i++) {
+			info.envelope[i] = (byte)(__points[i] > 255 ? 255 : __points[i]);
+		}
+	}
+
+	long long GetBlockCount(void) const { return __blocks; }
+
+private:
+	int __points[AUDIO_ENVELOPE_POINTS];
+	int __count;
+	int __blocksPerPoint;
+	int __pending;
+	int __pendingSum;
+	long long __blocks;
+};
+
+static inline int ReadLE16(const byte *p) {
+	return p[0] | (p[1] << 8);
+}
+
+static inline int ReadLE32(const byte *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+}
+
+result AudioInfoExtractor::Extract(const String &path, AudioInfo &info) {
+	info.duration = -1;
+	info.size = 0;
+	info.envelopeLength = 0;
+
+	FileAttributes attr;
+	result res = File::GetAttributes(path, attr);
+	if (IsFailed(res)) {
+		return res;
+	}
+	info.size = attr.GetFileSize();
+
+	File file;
+	res = file.Construct(path, L"r");
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	byte header[12];
+	int read = file.Read(header, sizeof(header));
+	if (IsFailed(GetLastResult())) {
+		read = 0;
+	}
+
+	if (read >= 9 && !memcmp(header, "#!AMR-WB\n", 9)) {
+		file.Seek(FILESEEKPOSITION_BEGIN, 9);
+		res = ScanAmr(file, true, info);
+	} else if (read >= 6 && !memcmp(header, "#!AMR\n", 6)) {
+		file.Seek(FILESEEKPOSITION_BEGIN, 6);
+		res = ScanAmr(file, false, info);
+	} else if (read == 12 && !memcmp(header, "RIFF", 4) && !memcmp(header + 8, "WAVE", 4)) {
+		res = ScanWav(file, info);
+	} else {
+		res = E_UNSUPPORTED_FORMAT;
+	}
+
+	if (IsFailed(res)) {
+		//container could not be scanned, but the platform may still know how long it is
+		AudioMetadata *pMeta = ContentManagerUtil::GetAudioMetaN(path);
+		if (pMeta) {
+			info.duration = pMeta->GetDuration();
+			delete pMeta;
+			res = E_SUCCESS;
+		}
+	}
+	return res;
+}
+
+result AudioInfoExtractor::ScanAmr(File &file, bool wideband, AudioInfo &info) {
+	const int *pSizes = wideband ? AMR_WB_FRAME_SIZES : AMR_NB_FRAME_SIZES;
+	int sid = wideband ? AMR_WB_SID : AMR_NB_SID;
+
+	EnvelopeBuilder envelope;
+	byte *pBuf = new byte[READ_CHUNK];
+	//payload bytes of the current frame still to be skipped, frames may span chunks
+	int skip = 0;
+	result res = E_SUCCESS;
+
+	while (true) {
+		int read = file.Read(pBuf, READ_CHUNK);
+		res = GetLastResult();
+		if (res == E_END_OF_FILE || (!IsFailed(res) && read <= 0)) {
+			res = E_SUCCESS;
+			break;
+		} else if (IsFailed(res)) {
+			break;
+		}
+
+		int pos = 0;
+		while (pos < read) {
+			if (skip > 0) {
+				int step = read - pos < skip ? read - pos : skip;
+				pos += step;
+				skip -= step;
+				continue;
+			}
+
+			int type = (pBuf[pos++] >> 3) & 0x0F;
+			skip = pSizes[type];
+			//comfort noise and dropped frames are only sent in silence
+			envelope.Add(type < sid ? 255 : 0);
+		}
+	}
+	delete[] pBuf;
+
+	if (IsFailed(res)) {
+		return res;
+	}
+	envelope.Finish(info);
+	info.duration = (int)(envelope.GetBlockCount() * BLOCK_DURATION);
+	return E_SUCCESS;
+}
+
+result AudioInfoExtractor::ScanWav(File &file, AudioInfo &info) {
+	int channels = 0, sampleRate = 0, byteRate = 0, blockAlign = 0, bits = 0;
+	int dataSize = -1;
+
+	//'fmt ' comes before 'data' in every valid file, other chunks are skipped
+	while (dataSize < 0) {
+		byte chunk[16];
+		int read = file.Read(chunk, 8);
+		if (IsFailed(GetLastResult()) || read < 8) {
+			return E_INVALID_FORMAT;
+		}
+		int size = ReadLE32(chunk + 4);
+		if (size < 0) {
+			return E_INVALID_FORMAT;
+		}
+
+		if (!memcmp(chunk, "fmt ", 4)) {
+			if (size < 16) {
+				return E_INVALID_FORMAT;
+			}
+			read = file.Read(chunk, 16);
+			if (IsFailed(GetLastResult()) || read < 16) {
+				return E_INVALID_FORMAT;
+			}
+			if (ReadLE16(chunk) != 1) {
+				//compressed payload, samples can't be read directly
+				return E_UNSUPPORTED_FORMAT;
+			}
+			channels = ReadLE16(chunk + 2);
+			sampleRate = ReadLE32(chunk + 4);
+			byteRate = ReadLE32(chunk + 8);
+			blockAlign = ReadLE16(chunk + 12);
+			bits = ReadLE16(chunk + 14);
+			size -= 16;
+		} else if (!memcmp(chunk, "data", 4)) {
+			dataSize = size;
+			break;
+		}
+
+		//chunks are word aligned
+		size += size & 1;
+		if (size > 0 && IsFailed(file.Seek(FILESEEKPOSITION_CURRENT, size))) {
+			return E_INVALID_FORMAT;
+		}
+	}
+
+	if (channels <= 0 || sampleRate <= 0 || byteRate <= 0 || (bits != 8 && bits != 16) || blockAlign != channels * bits / 8) {
+		return E_UNSUPPORTED_FORMAT;
+	}
+
+	EnvelopeBuilder envelope;
+	int blockFrames = sampleRate * BLOCK_DURATION / 1000;
+	if (blockFrames <= 0) blockFrames = 1;
+	int chunkSize = READ_CHUNK - READ_CHUNK % blockAlign;
+	byte *pBuf = new byte[chunkSize];
+
+	int left = dataSize;
+	int frames = 0;
+	int peak = 0;
+	result res = E_SUCCESS;
+
+	while (left > 0) {
+		int read = file.Read(pBuf, left < chunkSize ? left : chunkSize);
+		res = GetLastResult();
+		if (res == E_END_OF_FILE || (!IsFailed(res) && read <= 0)) {
+			//truncated recordings are summarized up to where they end
+			res = E_SUCCESS;
+			break;
+		} else if (IsFailed(res)) {
+			break;
+		}
+		left -= read;
+
+		for (int pos = 0; pos + blockAlign <= read; pos += blockAlign) {
+			for (int c = 0; c < channels; c++) {
+				int level;
+				if (bits == 16) {
+					int sample = (short)ReadLE16(pBuf + pos + c * 2);
+					level = (sample < 0 ? -sample : sample) >> 7;
+				} else {
+					int sample = pBuf[pos + c] - 128;
+					level = (sample < 0 ? -sample : sample) * 2;
+				}
+				if (level > peak) peak = level;
+			}
+			if (++frames == blockFrames) {
+				envelope.Add(peak);
+				frames = 0;
+				peak = 0;
+			}
+		}
+	}
+	delete[] pBuf;
+
+	if (IsFailed(res)) {
+		return res;
+	}
+	if (frames > 0) {
+		envelope.Add(peak);
+	}
+	envelope.Finish(info);
+	info.duration = (int)((long long)(dataSize - left) * 1000 / byteRate);
+	return E_SUCCESS;
+}
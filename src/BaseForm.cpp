@@ -21,6 +21,8 @@
 #include <typeinfo>
 
 #include "BaseForm.h"
+#include "StringTable.h"
+#include "Trace.h"
 
 using namespace Osp::App;
 using namespace Osp::System;
@@ -33,28 +35,28 @@ CallbackInfo CreateCallbackInfo(int taskID, BaseForm *handler) {
 
 BaseForm::BaseForm(void) {
 	__pCurrentPopup = null;
-	__pEventMap = new std::map<int, EventDelegate>;
+	__pActions = new ActionTable;
 	__initialized = false;
 	__pDTFormatter = null;
 }
 
 BaseForm::~BaseForm(void) {
 	if (__pCurrentPopup) delete __pCurrentPopup;
-	if (__pEventMap) delete __pEventMap;
+	if (__pActions) delete __pActions;
 	if (__pDTFormatter) delete __pDTFormatter;
 }
 
 result BaseForm::RegisterButtonPressEvent(Button *pCtrl, int actionId, EventDelegate handler) {
 	if (pCtrl && handler) {
-		std::map<int, EventDelegate>::iterator iter = (__pEventMap->insert(std::make_pair(actionId, handler))).first;
-		if (iter != __pEventMap->end()) {
-			pCtrl->SetActionId(actionId);
-			pCtrl->AddActionEventListener(*this);
-			return E_SUCCESS;
-		} else {
-			AppLogException("Handler for action [%d] is already registered", actionId);
-			return E_ALREADY_CONNECTED;
+		result res = __pActions->Add(actionId, handler);
+		if (IsFailed(res)) {
+			AppLogException("Failed to register handler for action [%d], error: [%s]", actionId, GetErrorMessage(res));
+			return res;
 		}
+
+		pCtrl->SetActionId(actionId);
+		pCtrl->AddActionEventListener(*this);
+		return E_SUCCESS;
 	} else {
 		AppLogException("Attempt to register action handler for null control or passed null handler");
 		return E_INVALID_ARG;
@@ -63,12 +65,11 @@ result BaseForm::RegisterButtonPressEvent(Button *pCtrl, int actionId, EventDele
 
 result BaseForm::RegisterAction(int actionId, EventDelegate handler) {
 	if (handler) {
-		std::map<int, EventDelegate>::iterator iter = (__pEventMap->insert(std::make_pair(actionId, handler))).first;
-		if (iter == __pEventMap->end()) {
-			AppLogException("Handler for action [%d] is already registered", actionId);
-			return E_ALREADY_CONNECTED;
+		result res = __pActions->Add(actionId, handler);
+		if (IsFailed(res)) {
+			AppLogException("Failed to register handler for action [%d], error: [%s]", actionId, GetErrorMessage(res));
 		}
-		return E_SUCCESS;
+		return res;
 	} else {
 		AppLogException("Attempt to register action handler for null control or passed null handler");
 		return E_INVALID_ARG;
@@ -76,14 +77,17 @@ result BaseForm::RegisterAction(int actionId, EventDelegate handler) {
 }
 
 void BaseForm::UnregisterAction(int actionId) {
-	std::map<int, EventDelegate>::iterator iter = __pEventMap->find(actionId);
-	if (iter != __pEventMap->end()) {
-		__pEventMap->erase(iter);
-	} else {
+	if (IsFailed(__pActions->Remove(actionId))) {
 		AppLogException("Event [%d] is not registered", actionId);
 	}
 }
 
+void BaseForm::UnregisterAction(int actionId, EventDelegate handler) {
+	if (IsFailed(__pActions->Remove(actionId, handler))) {
+		AppLogException("Handler for event [%d] is not registered", actionId);
+	}
+}
+
 result BaseForm::ShowInputBox(CallbackInfo cbInfo, KeypadInputModeCategory inputMode, const String &title, const String &msg, const String &acceptButton, const String &cancelButton) {
 	if (__pCurrentPopup) {
 		__pCurrentPopup->SetShowState(false);
@@ -96,7 +100,7 @@ result BaseForm::ShowInputBox(CallbackInfo cbInfo, KeypadInputModeCategory input
 	}
 
 	__pCurrentPopup = new Popup;
-	result res = __pCurrentPopup->Construct(L"IDP_INPUT_POPUP");
+	result res = __pCurrentPopup->Construct(IDP_INPUT_POPUP);
 	if (IsFailed(res)) {
 		AppLogException("Failed to construct input popup, error: [%s]", GetErrorMessage(res));
 
@@ -108,10 +112,10 @@ result BaseForm::ShowInputBox(CallbackInfo cbInfo, KeypadInputModeCategory input
 
 	__pCurrentPopup->SetTitleText(title);
 
-	Label *pLabel = static_cast<Label*>(__pCurrentPopup->GetControl(L"IDC_INPUT_POPUP_TEXT"));
-	Button *pAcceptButton = static_cast<Button*>(__pCurrentPopup->GetControl(L"IDC_INPUT_POPUP_ACCEPT_BUTTON"));
-	Button *pCancelButton = static_cast<Button*>(__pCurrentPopup->GetControl(L"IDC_INPUT_POPUP_CANCEL_BUTTON"));
-	EditField *pField = static_cast<EditField*>(__pCurrentPopup->GetControl(L"IDC_INPUT_POPUP_FIELD"));
+	Label *pLabel = static_cast<Label*>(__pCurrentPopup->GetControl(IDC_INPUT_POPUP_TEXT));
+	Button *pAcceptButton = static_cast<Button*>(__pCurrentPopup->GetControl(IDC_INPUT_POPUP_ACCEPT_BUTTON));
+	Button *pCancelButton = static_cast<Button*>(__pCurrentPopup->GetControl(IDC_INPUT_POPUP_CANCEL_BUTTON));
+	EditField *pField = static_cast<EditField*>(__pCurrentPopup->GetControl(IDC_INPUT_POPUP_FIELD));
 	if (!pLabel || !pAcceptButton || !pCancelButton || !pField) {
 		AppLogException("Failed to acquire controls from input popup");
 
@@ -233,7 +237,7 @@ result BaseForm::OnTerminating(void) {
 
 result BaseForm::OnPopupAccept(const Control &src) {
 	if (__pCurrentPopup && __popupCallbackInfo.callbackHandler) {
-		EditField *pField = static_cast<EditField*>(__pCurrentPopup->GetControl(L"IDC_INPUT_POPUP_FIELD"));
+		EditField *pField = static_cast<EditField*>(__pCurrentPopup->GetControl(IDC_INPUT_POPUP_FIELD));
 		if (!pField) {
 			AppLogException("Failed to acquire field control from popup");
 			return E_INVALID_STATE;
@@ -249,6 +253,10 @@ result BaseForm::OnPopupAccept(const Control &src) {
 		delete __pCurrentPopup;
 		__pCurrentPopup = null;
 
+		//buttons are gone with the popup, next one registers its own
+		UnregisterAction(ID_POPUP_ACCEPT_CLICKED);
+		UnregisterAction(ID_POPUP_CANCEL_CLICKED);
+
 		res = RefreshForm();
 		if (IsFailed(res)) {
 			AppLogException("Failed to redraw form after hiding popup, error: [%s]", GetErrorMessage(res));
@@ -268,6 +276,10 @@ result BaseForm::OnPopupCancel(const Control &src) {
 		delete __pCurrentPopup;
 		__pCurrentPopup = null;
 
+		//buttons are gone with the popup, next one registers its own
+		UnregisterAction(ID_POPUP_ACCEPT_CLICKED);
+		UnregisterAction(ID_POPUP_CANCEL_CLICKED);
+
 		res = RefreshForm();
 		if (IsFailed(res)) {
 			AppLogException("Failed to redraw form after hiding popup, error: [%s]", GetErrorMessage(res));
@@ -277,21 +289,42 @@ result BaseForm::OnPopupCancel(const Control &src) {
 }
 
 void BaseForm::OnActionPerformed(const Control &source, int actionId) {
-	bool triggered = false;
-	std::map<int, EventDelegate>::iterator iter = __pEventMap->begin();
-	for(; iter != __pEventMap->end(); iter++) {
-		if (iter->first == actionId) {
-			EventDelegate del = iter->second;
-			result res = (this->*del)(source);
-			if (IsFailed(res)) {
-				AppLogException("Event handler [%S] for [%d] failed with error: [%s]", source.GetName().GetPointer(), actionId, GetErrorMessage(res));
-			}
-			triggered = true;
+	//handlers may change registrations, so they are called from a copy
+	EventDelegate handlers[ActionTable::MAX_HANDLERS_PER_ACTION];
+	int count = __pActions->Find(actionId, handlers, ActionTable::MAX_HANDLERS_PER_ACTION);
+	if (!count) {
+		AppLogException("Event [%d] is not registered for [%S]", actionId, source.GetName().GetPointer());
+		return;
+	}
+	if (count > ActionTable::MAX_HANDLERS_PER_ACTION) {
+		AppLogException("Event [%d] has %d handlers, only first %d are called", actionId, count, ActionTable::MAX_HANDLERS_PER_ACTION);
+		count = ActionTable::MAX_HANDLERS_PER_ACTION;
+	}
+
+	unsigned int generation = __pActions->GetGeneration();
+	for (int i = 0; i < count; i++) {
+		if (__pActions->GetGeneration() != generation && !__pActions->Contains(actionId, handlers[i])) {
+			continue;
+		}
+
+		result res = (this->*handlers[i])(source);
+		if (IsFailed(res)) {
+			AppLogException("Event handler [%S] for [%d] failed with error: [%s]", source.GetName().GetPointer(), actionId, GetErrorMessage(res));
 		}
 	}
-	if (!triggered) {
-		AppLogException("Event [%d] is not registered for [%S]", actionId, source.GetName().GetPointer());
+}
+
+bool BaseForm::SetControlText(Control *pCtrl, const String &text) {
+	if (typeid(*pCtrl) == typeid(Button)) {
+		static_cast<Button *>(pCtrl)->SetText(text);
+	} else if (typeid(*pCtrl) == typeid(Label)) {
+		static_cast<Label *>(pCtrl)->SetText(text);
+	} else if (typeid(*pCtrl) == typeid(CheckButton)) {
+		static_cast<CheckButton *>(pCtrl)->SetText(text);
+	} else {
+		return false;
 	}
+	return true;
 }
 
 result BaseForm::Localize(Container *pCont) {
@@ -300,60 +333,91 @@ result BaseForm::Localize(Container *pCont) {
 		return E_INVALID_ARG;
 	}
 
+	String name = pCont->GetName();
+	const ResContainerStrings *pGenerated = null;
+	for (int i = 0; i < RES_CONTAINER_COUNT; i++) {
+		if (name.Equals(RES_CONTAINERS[i].pName, true)) {
+			pGenerated = &RES_CONTAINERS[i];
+			break;
+		}
+	}
+
 	result res = E_SUCCESS;
-	if (typeid(*pCont) == typeid(Form)) {
-		Form *pForm = static_cast<Form*>(pCont);
-		if (pForm->HasTitle()) {
-			pForm->SetTitleText(GetString(pForm->GetName() + L"_TITLE"), ALIGNMENT_CENTER);
+	if (pGenerated) {
+		//resource tells which controls have strings, nothing to look up by name
+		if (typeid(*pCont) == typeid(Form)) {
+			Form *pForm = static_cast<Form*>(pCont);
+			if (pForm->HasTitle() && pGenerated->title >= 0) {
+				pForm->SetTitleText(GetString((StringId)pGenerated->title), ALIGNMENT_CENTER);
+			}
+			if (pForm->HasSoftkey(SOFTKEY_0) && pGenerated->softkeys[0] >= 0) {
+				pForm->SetSoftkeyText(SOFTKEY_0, GetString((StringId)pGenerated->softkeys[0]));
+			}
+			if (pForm->HasSoftkey(SOFTKEY_1) && pGenerated->softkeys[1] >= 0) {
+				pForm->SetSoftkeyText(SOFTKEY_1, GetString((StringId)pGenerated->softkeys[1]));
+			}
 		}
 
-		if (pForm->HasSoftkey(SOFTKEY_0)) {
-			pForm->SetSoftkeyText(SOFTKEY_0, GetString(pForm->GetName() + L"_SOFTKEY0_TEXT"));
+		for (int i = 0; i < pGenerated->controlCount; i++) {
+			Control *pCtrl = pCont->GetControl(pGenerated->pControls[i].pControl);
+			if (!pCtrl || !SetControlText(pCtrl, GetString(pGenerated->pControls[i].text))) {
+				res = E_OBJ_NOT_FOUND;
+			}
+		}
+	} else {
+		//container built in code, keys are concatenated once per container name
+		const ContainerKeys *pKeys = StringTable::GetContainerKeys(*pCont);
+		if (!pKeys) {
+			AppLogException("Attempt to localize container without name");
+			return E_INVALID_ARG;
 		}
-		if (pForm->HasSoftkey(SOFTKEY_1)) {
 
-			pForm->SetSoftkeyText(SOFTKEY_1, GetString(pForm->GetName() + L"_SOFTKEY1_TEXT"));
+		if (typeid(*pCont) == typeid(Form)) {
+			Form *pForm = static_cast<Form*>(pCont);
+			if (pForm->HasTitle()) {
+				pForm->SetTitleText(GetString(pKeys->titleKey), ALIGNMENT_CENTER);
+			}
+
+			if (pForm->HasSoftkey(SOFTKEY_0)) {
+				pForm->SetSoftkeyText(SOFTKEY_0, GetString(pKeys->softkeyKeys[0]));
+			}
+			if (pForm->HasSoftkey(SOFTKEY_1)) {
+				pForm->SetSoftkeyText(SOFTKEY_1, GetString(pKeys->softkeyKeys[1]));
+			}
+
+			res = GetLastResult();
 		}
 
-		res = GetLastResult();
-	}
+		for (int i = 0; i < pKeys->controlCount; i++) {
+			Control *pCtrl = pCont->GetControl(i);
 
-	String str = L"";
-	for (int i = 0; i < pCont->GetControlCount(); i++) {
-		Control *pCtrl = pCont->GetControl(i);
-
-		bool is_button = typeid(*pCtrl) == typeid(Button);
-		bool is_label = typeid(*pCtrl) == typeid(Label);
-		bool is_checkbutton = typeid(*pCtrl) == typeid(CheckButton);
-
-		if (is_button || is_label || is_checkbutton) {
-			str = GetString(pCtrl->GetName() + String(L"_TEXT"));
-			if (!IsFailed(GetLastResult())) {
-				if (is_button) {
-					static_cast<Button *>(pCtrl)->SetText(str);
-				} else if (is_label) {
-					static_cast<Label *>(pCtrl)->SetText(str);
-				} else if (is_checkbutton) {
-					static_cast<CheckButton *>(pCtrl)->SetText(str);
+			bool is_button = typeid(*pCtrl) == typeid(Button);
+			bool is_label = typeid(*pCtrl) == typeid(Label);
+			bool is_checkbutton = typeid(*pCtrl) == typeid(CheckButton);
+
+			if (is_button || is_label || is_checkbutton) {
+				String str = GetString(pKeys->pControlKeys[i]);
+				if (!IsFailed(GetLastResult())) {
+					SetControlText(pCtrl, str);
+				} else {
+					res = GetLastResult();
 				}
-			} else {
-				res = GetLastResult();
 			}
 		}
 	}
 
-	AppLogException("Container [%S] was not fully localized. Last error: [%s]", pCont->GetName().GetPointer(), GetErrorMessage(res));
+	if (IsFailed(res)) {
+		AppLogException("Container [%S] was not fully localized. Last error: [%s]", name.GetPointer(), GetErrorMessage(res));
+	}
 	return res;
 }
 
 String BaseForm::GetString(const String &id) {
-	String str = id;
-	result res = Application::GetInstance()->GetAppResource()->GetString(id, str);
-	if (IsFailed(res)) {
-		AppLogDebug("Could not retrieve string by id [%S]", id.GetPointer());
-		SetLastResult(res);
-	}
-	return str;
+	return StringTable::Get(id);
+}
+
+String BaseForm::GetString(StringId id) {
+	return StringTable::Get(id);
 }
 
 DateTime BaseForm::GetLocalDatetimeObject(long long ticks) {
@@ -406,6 +470,8 @@ MessageBoxModalResult BaseForm::ShowMessageBox(const String &title, const String
 
 Bitmap *BaseForm::GetBitmapN(const String &name)
 {
+	TRACE_SCOPE("ui.decode_bitmap");
+
 	Image *pImage = new Image();
 	result res = pImage->Construct();
 	if (IsFailed(res)) {
@@ -0,0 +1,780 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef ALLNOTES_BENCHMARK
+
+#include <FApp.h>
+#include <FSystem.h>
+#include <algorithm>
+#include <map>
+#include <string.h>
+
+#include "BaseForm.h"
+#include "Benchmark.h"
+#include "Collator.h"
+#include "NoteSorter.h"
+#include "StringTable.h"
+#include "TextUtils.h"
+
+using namespace Osp::App;
+using namespace Osp::System;
+
+static const mchar *TITLE_WORDS[] = {
+	L"meeting", L"shopping", L"Ideas", L"travel", L"Zebra", L"apple", L"émigré", L"Ölfarbe",
+	L"встреча", L"Покупки", L"идеи", L"ёлка", L"Яблоко", L"работа", L"Отпуск", L"заметка"
+};
+static const int TITLE_WORD_COUNT = sizeof(TITLE_WORDS) / sizeof(TITLE_WORDS[0]);
+
+SyntheticNoteEnumerator::SyntheticNoteEnumerator(int count, int textLength) {
+	__count = count;
+	__textLength = textLength;
+	__index = -1;
+	__pCurrent = null;
+}
+
+SyntheticNoteEnumerator::~SyntheticNoteEnumerator(void) {
+	if (__pCurrent) delete __pCurrent;
+}
+
+Note *SyntheticNoteEnumerator::CreateNoteN(int index, int textLength) {
+	//cheap deterministic scramble, so every run produces the same store
+	unsigned int seed = (unsigned int)index * 2654435761u;
+
+	NoteType type = NOTE_TYPE_TEXT;
+	if (seed % 10 == 7) {
+		type = NOTE_TYPE_PHOTO;
+	} else if (seed % 10 == 8) {
+		type = NOTE_TYPE_AUDIO;
+	}
+
+	Note *pNote = new Note;
+	pNote->Construct(type);
+
+	String title = TITLE_WORDS[seed % TITLE_WORD_COUNT];
+	title.Append(' ');
+	title.Append(TITLE_WORDS[(seed >> 8) % TITLE_WORD_COUNT]);
+	title.Append(' ');
+	title.Append(index);
+	pNote->SetTitle(title);
+
+	String text;
+	text.EnsureCapacity(textLength + 16);
+	while (text.GetLength() < textLength) {
+		text.Append(TITLE_WORDS[(seed >> (text.GetLength() % 24)) % TITLE_WORD_COUNT]);
+		text.Append(' ');
+	}
+	pNote->SetText(text);
+
+	//timestamps span ~40 years, so their differences do not fit into int
+	pNote->SetDate(315532800LL + (long long)(seed % 1261440000u));
+	pNote->SetMarked(seed % 13 == 0);
+
+	if (type != NOTE_TYPE_TEXT) {
+		String res_path = L"/Media/Others/synthetic_";
+		res_path.Append(index);
+		res_path.Append(type == NOTE_TYPE_PHOTO ? L".jpg" : L".amr");
+		pNote->SetResourcePath(res_path);
+	}
+	return pNote;
+}
+
+result SyntheticNoteEnumerator::MoveNext(void) {
+	if (__pCurrent) {
+		delete __pCurrent;
+		__pCurrent = null;
+	}
+	if (__index + 1 >= __count) {
+		return E_OUT_OF_RANGE;
+	}
+	__pCurrent = CreateNoteN(++__index, __textLength);
+	return E_SUCCESS;
+}
+
+result SyntheticNoteEnumerator::GetCurrent(Note *&obj) const {
+	if (!__pCurrent) {
+		return E_INVALID_STATE;
+	}
+	obj = __pCurrent;
+	return E_SUCCESS;
+}
+
+result SyntheticNoteEnumerator::Reset(void) {
+	if (__pCurrent) {
+		delete __pCurrent;
+		__pCurrent = null;
+	}
+	__index = -1;
+	return E_SUCCESS;
+}
+
+//Never shown; only its action table is used. IDs mirror a real form: a run of small ones plus the popup pair.
+class DispatchBenchForm: public BaseForm {
+public:
+	DispatchBenchForm(void) {
+		__hits = 0;
+	}
+
+	virtual result Construct(void) { return E_SUCCESS; }
+
+	result RegisterActions(void) {
+		for (int i = 0; i < ACTION_COUNT; i++) {
+			int action_id = GetActionId(i);
+			result res = RegisterAction(action_id, HANDLER(DispatchBenchForm::OnAction));
+			if (IsFailed(res)) {
+				return res;
+			}
+			__legacyMap.insert(std::make_pair(action_id, HANDLER(DispatchBenchForm::OnAction)));
+		}
+		return E_SUCCESS;
+	}
+
+	void Dispatch(int actionId) {
+		static_cast<IActionEventListener *>(this)->OnActionPerformed(*this, actionId);
+	}
+
+	//what BaseForm did before: walks the whole map for every action
+	void DispatchByScan(int actionId) {
+		std::map<int, EventDelegate>::iterator iter = __legacyMap.begin();
+		for (; iter != __legacyMap.end(); iter++) {
+			if (iter->first == actionId) {
+				(this->*(iter->second))(*this);
+			}
+		}
+	}
+
+	void DispatchByFind(int actionId) {
+		std::map<int, EventDelegate>::iterator iter = __legacyMap.find(actionId);
+		if (iter != __legacyMap.end()) {
+			(this->*(iter->second))(*this);
+		}
+	}
+
+	int GetHits(void) const { return __hits; }
+
+	static int GetActionId(int index) { return index < ACTION_COUNT - 2 ? 100 + index : 998 + index - (ACTION_COUNT - 2); }
+
+	static const int ACTION_COUNT = 18;
+
+protected:
+	virtual result Initialize(void) { return E_SUCCESS; }
+	virtual result Terminate(void) { return E_SUCCESS; }
+
+private:
+	result OnAction(const Control &src) {
+		__hits++;
+		return E_SUCCESS;
+	}
+
+	std::map<int, EventDelegate> __legacyMap;
+	int __hits;
+};
+
+Benchmark::Benchmark(void) {
+	__workDir = L"";
+	__storePath = L"";
+	__resultPath = L"";
+	__noteCount = 0;
+	__textLength = 0;
+	__reported = 0;
+	__pOut = null;
+}
+
+Benchmark::~Benchmark(void) {
+	if (__pOut) delete __pOut;
+}
+
+result Benchmark::Construct(const String &workDir, const String &resultPath) {
+	__workDir = workDir;
+	if (!__workDir.EndsWith(L"/")) {
+		__workDir.Append('/');
+	}
+	__storePath = __workDir;
+	__storePath.Append(L"benchmark.bin");
+	__resultPath = resultPath;
+
+	result res = Directory::Create(__workDir, true);
+	if (IsFailed(res) && res != E_FILE_ALREADY_EXIST) {
+		AppLogException("Failed to create benchmark directory [%S], error: [%s]", __workDir.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+	return E_SUCCESS;
+}
+
+long long Benchmark::Now(void) {
+	long long ticks = 0;
+	SystemTime::GetTicks(ticks);
+	return ticks;
+}
+
+void Benchmark::DeleteNotes(LinkedListT<Note *> *pNotes) {
+	if (!pNotes) {
+		return;
+	}
+	IEnumeratorT<Note *> *pEnum = pNotes->GetEnumeratorN();
+	while (pEnum && !IsFailed(pEnum->MoveNext())) {
+		Note *pNote; pEnum->GetCurrent(pNote);
+		delete pNote;
+	}
+	if (pEnum) delete pEnum;
+	delete pNotes;
+}
+
+String Benchmark::SortTypeName(SortType type) {
+	if (type == SORT_BY_DATE) {
+		return L"date";
+	} else if (type == SORT_BY_TITLE) {
+		return L"title";
+	} else {
+		return L"type";
+	}
+}
+
+String Benchmark::FilterTypeName(FilterType type) {
+	return type == FILTER_BY_TITLE ? L"title" : L"text";
+}
+
+void Benchmark::Report(const String &name, int iterations, long long elapsedMs) {
+	//clock has millisecond resolution, so fast operations are timed over many iterations
+	long long per_op_us = iterations > 0 ? (elapsedMs * 1000) / iterations : 0;
+
+	String line = __reported > 0 ? L",\n" : L"\n";
+	line.Append(L"    {\"name\": \"");
+	line.Append(name);
+	line.Append(L"\", \"iterations\": ");
+	line.Append(iterations);
+	line.Append(L", \"total_ms\": ");
+	line.Append(elapsedMs);
+	line.Append(L", \"per_op_us\": ");
+	line.Append(per_op_us);
+	line.Append(L"}");
+
+	__pOut->WriteUtf8(line);
+	__reported++;
+
+	AppLog("Benchmark [%S]: %lld ms over %d iterations", name.GetPointer(), elapsedMs, iterations);
+}
+
+result Benchmark::GenerateStore(void) {
+	if (File::IsFileExist(__storePath)) {
+		File::Remove(__storePath);
+	}
+
+	NotesManager manager;
+	result res = manager.Construct(__storePath);
+	if (IsFailed(res)) {
+		AppLogException("Failed to create benchmark store, error: [%s]", GetErrorMessage(res));
+		return res;
+	}
+
+	SyntheticNoteEnumerator notes(__noteCount, __textLength);
+
+	long long start = Now();
+	res = manager.ImportNotes(notes);
+	Report(L"store.generate", __noteCount, Now() - start);
+
+	return res;
+}
+
+result Benchmark::Run(int noteCount, int textLength) {
+	__noteCount = noteCount;
+	__textLength = textLength;
+	__reported = 0;
+
+	__pOut = new BufferedFileWriter;
+	result res = __pOut->Construct(__resultPath);
+	if (IsFailed(res)) {
+		delete __pOut;
+		__pOut = null;
+		return res;
+	}
+
+	String header = L"{\n  \"notes\": ";
+	header.Append(noteCount);
+	header.Append(L",\n  \"text_length\": ");
+	header.Append(textLength);
+	header.Append(L",\n  \"results\": [");
+	__pOut->WriteUtf8(header);
+
+	res = GenerateStore();
+	if (!IsFailed(res)) {
+		res = RunStorageSuite();
+	}
+	if (!IsFailed(res)) {
+		res = RunCacheSuite();
+	}
+	if (!IsFailed(res)) {
+		res = RunCollationSuite();
+	}
+	if (!IsFailed(res)) {
+		res = RunSortKernelSuite();
+	}
+	if (!IsFailed(res)) {
+		res = RunDispatchSuite();
+	}
+	if (!IsFailed(res)) {
+		res = RunStringSuite();
+	}
+	if (!IsFailed(res)) {
+		res = RunTextSuite();
+	}
+
+	__pOut->WriteUtf8(L"\n  ]\n}\n", 7);
+	__pOut->Flush(true);
+	__pOut->Close();
+
+	File::Remove(__storePath);
+	String journal = __storePath;
+	journal.Append(L".journal");
+	File::Remove(journal);
+
+	return res;
+}
+
+result Benchmark::RunStorageSuite(void) {
+	const int ITERATIONS = 50;
+
+	long long start = Now();
+	for (int i = 0; i < ITERATIONS; i++) {
+		NotesManager manager;
+		result res = manager.Construct(__storePath);
+		if (IsFailed(res)) {
+			return res;
+		}
+	}
+	Report(L"notes_manager.load", ITERATIONS, Now() - start);
+
+	NotesManager manager;
+	result res = manager.Construct(__storePath);
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	for (int sorting = SORT_BY_DATE; sorting <= SORT_BY_TYPE; sorting++) {
+		for (int mode = FILTER_BY_TITLE; mode <= FILTER_BY_TEXT; mode++) {
+			for (int filtered = 0; filtered < 2; filtered++) {
+				String name = L"notes_manager.get_notes.";
+				name.Append(SortTypeName((SortType)sorting));
+				name.Append('.');
+				name.Append(FilterTypeName((FilterType)mode));
+				name.Append(filtered ? L".filtered" : L".unfiltered");
+
+				start = Now();
+				LinkedListT<Note *> *pNotes = manager.GetNotesN((SortType)sorting, SORT_ORDER_DESCENDING, NOTE_TYPE_ALL, (FilterType)mode, filtered ? L"ide" : L"");
+				Report(name, 1, Now() - start);
+
+				DeleteNotes(pNotes);
+			}
+		}
+	}
+
+	const int OPS = 100;
+	Note *notes[OPS];
+
+	start = Now();
+	for (int i = 0; i < OPS; i++) {
+		notes[i] = SyntheticNoteEnumerator::CreateNoteN(__noteCount + i, __textLength);
+		manager.AddNote(notes[i]);
+	}
+	Report(L"notes_manager.add_note", OPS, Now() - start);
+
+	start = Now();
+	for (int i = 0; i < OPS; i++) {
+		notes[i]->SetMarked(!notes[i]->GetMarked());
+		notes[i]->SetSerialized(false);
+		manager.UpdateNote(notes[i]);
+	}
+	Report(L"notes_manager.update_note", OPS, Now() - start);
+
+	LinkedListT<Note *> batch;
+	for (int i = 0; i < OPS; i++) {
+		notes[i]->SetSerialized(false);
+		batch.Add(notes[i]);
+	}
+	start = Now();
+	manager.SerializeNotes(batch);
+	Report(L"notes_manager.serialize_notes", OPS, Now() - start);
+
+	start = Now();
+	for (int i = 0; i < OPS; i++) {
+		manager.RemoveNote(notes[i]);
+	}
+	Report(L"notes_manager.remove_note", OPS, Now() - start);
+
+	for (int i = 0; i < OPS; i++) {
+		delete notes[i];
+	}
+	return E_SUCCESS;
+}
+
+class KeyLess {
+public:
+	inline bool operator()(const ByteBuffer *pKey1, const ByteBuffer *pKey2) const {
+		return Collator::CompareKeys(*pKey1, *pKey2) < 0;
+	}
+};
+
+class TitleLess {
+public:
+	inline bool operator()(const String *pTitle1, const String *pTitle2) const {
+		return pTitle1->CompareTo(*pTitle2) < 0;
+	}
+};
+
+result Benchmark::RunCollationSuite(void) {
+	//fixed size regardless of store size, this is what title sort has to cope with on large stores
+	const int COUNT = 100000;
+
+	Collator collator;
+	result res = collator.Construct(L"rus");
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	String *pTitles = new String[COUNT];
+	ByteBuffer **ppKeys = new ByteBuffer *[COUNT];
+	for (int i = 0; i < COUNT; i++) {
+		Note *pNote = SyntheticNoteEnumerator::CreateNoteN(i, 0);
+		pTitles[i] = pNote->GetTitle();
+		delete pNote;
+	}
+
+	long long start = Now();
+	for (int i = 0; i < COUNT; i++) {
+		ppKeys[i] = collator.CreateKeyN(pTitles[i]);
+	}
+	Report(L"collation.build_keys.100k", COUNT, Now() - start);
+
+	ByteBuffer **ppSorted = new ByteBuffer *[COUNT];
+	for (int i = 0; i < COUNT; i++) {
+		ppSorted[i] = ppKeys[i];
+	}
+	start = Now();
+	std::stable_sort(ppSorted, ppSorted + COUNT, KeyLess());
+	Report(L"collation.sort_keys.100k", 1, Now() - start);
+
+	//baseline: plain code unit comparison, still without copying strings
+	const String **ppTitles = new const String *[COUNT];
+	for (int i = 0; i < COUNT; i++) {
+		ppTitles[i] = &pTitles[i];
+	}
+	start = Now();
+	std::stable_sort(ppTitles, ppTitles + COUNT, TitleLess());
+	Report(L"collation.sort_compareto.100k", 1, Now() - start);
+
+	for (int i = 0; i < COUNT; i++) {
+		delete ppKeys[i];
+	}
+	delete[] ppTitles;
+	delete[] ppSorted;
+	delete[] ppKeys;
+	delete[] pTitles;
+
+	return E_SUCCESS;
+}
+
+result Benchmark::RunSortKernelSuite(void) {
+	const int COUNT = 100000;
+
+	NoteSortKey *pSource = new NoteSortKey[COUNT];
+	NoteSortKey *pKeys = new NoteSortKey[COUNT];
+	NoteSortKey *pTemp = new NoteSortKey[COUNT];
+
+	for (int i = 0; i < COUNT; i++) {
+		Note *pNote = SyntheticNoteEnumerator::CreateNoteN(i, 0);
+		pSource[i].marked = pNote->GetMarked();
+		pSource[i].pTitleKey = null;
+		pSource[i].titleKeyLength = 0;
+		pSource[i].pNote = null;
+		pSource[i].primary = pNote->GetDate();
+		delete pNote;
+	}
+
+	long long start;
+
+	memcpy(pKeys, pSource, COUNT * sizeof(NoteSortKey));
+	start = Now();
+	std::stable_sort(pKeys, pKeys + COUNT, NoteSortKeyLess(false, false));
+	Report(L"sort.date.comparison.100k", 1, Now() - start);
+
+	memcpy(pKeys, pSource, COUNT * sizeof(NoteSortKey));
+	start = Now();
+	NoteSorter::RadixSortByDate(pKeys, pTemp, COUNT, false);
+	Report(L"sort.date.radix.100k", 1, Now() - start);
+
+	memcpy(pKeys, pSource, COUNT * sizeof(NoteSortKey));
+	start = Now();
+	NoteSorter::SortParallel(pKeys, pTemp, COUNT, SORT_BY_DATE, false, NoteSorter::PARALLEL_WORKERS);
+	Report(L"sort.date.parallel.100k", 1, Now() - start);
+
+	for (int i = 0; i < COUNT; i++) {
+		pSource[i].primary = (i * 2654435761u) % 3 + 1;
+	}
+
+	memcpy(pKeys, pSource, COUNT * sizeof(NoteSortKey));
+	start = Now();
+	std::stable_sort(pKeys, pKeys + COUNT, NoteSortKeyLess(false, true));
+	Report(L"sort.type.comparison.100k", 1, Now() - start);
+
+	memcpy(pKeys, pSource, COUNT * sizeof(NoteSortKey));
+	start = Now();
+	NoteSorter::CountingSortByType(pKeys, pTemp, COUNT, true);
+	Report(L"sort.type.counting.100k", 1, Now() - start);
+
+	delete[] pSource;
+	delete[] pKeys;
+	delete[] pTemp;
+
+	return E_SUCCESS;
+}
+
+result Benchmark::RunDispatchSuite(void) {
+	const int COUNT = 100000;
+
+	DispatchBenchForm form;
+	result res = form.RegisterActions();
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	long long start = Now();
+	for (int i = 0; i < COUNT; i++) {
+		form.Dispatch(DispatchBenchForm::GetActionId(i % DispatchBenchForm::ACTION_COUNT));
+	}
+	Report(L"dispatch.table.100k", COUNT, Now() - start);
+
+	start = Now();
+	for (int i = 0; i < COUNT; i++) {
+		form.DispatchByScan(DispatchBenchForm::GetActionId(i % DispatchBenchForm::ACTION_COUNT));
+	}
+	Report(L"dispatch.map_scan.100k", COUNT, Now() - start);
+
+	start = Now();
+	for (int i = 0; i < COUNT; i++) {
+		form.DispatchByFind(DispatchBenchForm::GetActionId(i % DispatchBenchForm::ACTION_COUNT));
+	}
+	Report(L"dispatch.map_find.100k", COUNT, Now() - start);
+
+	if (form.GetHits() != 3 * COUNT) {
+		AppLogException("Dispatch benchmark called %d handlers instead of %d", form.GetHits(), 3 * COUNT);
+		return E_INVALID_STATE;
+	}
+	return E_SUCCESS;
+}
+
+result Benchmark::RunStringSuite(void) {
+	const int COUNT = 100000;
+	static const mchar *KEYS[] = {
+		L"MAINFORM_NOTES_LIST_HEADER_TITLE", L"SORT_TYPE_DATE", L"SORT_TYPE_TITLE", L"SORT_TYPE_TYPE",
+		L"TEXTNOTE_FORM_TITLEFIELD_TITLE", L"TEXTNOTE_FORM_TEXT_CAPTION", L"TEXTNOTE_FORM_TIME_CAPTION", L"TEXTNOTE_FORM_SOFTKEY_CANCEL"
+	};
+	const int KEY_COUNT = sizeof(KEYS) / sizeof(KEYS[0]);
+
+	String *pKeys = new String[KEY_COUNT];
+	for (int i = 0; i < KEY_COUNT; i++) {
+		pKeys[i] = KEYS[i];
+	}
+
+	AppResource *pRes = Application::GetInstance()->GetAppResource();
+	String str;
+	long long start = Now();
+	for (int i = 0; i < COUNT; i++) {
+		pRes->GetString(pKeys[i % KEY_COUNT], str);
+	}
+	Report(L"strings.app_resource.100k", COUNT, Now() - start);
+
+	start = Now();
+	for (int i = 0; i < COUNT; i++) {
+		str = StringTable::Get(pKeys[i % KEY_COUNT]);
+	}
+	Report(L"strings.table.100k", COUNT, Now() - start);
+
+	start = Now();
+	for (int i = 0; i < COUNT; i++) {
+		str = StringTable::Get((StringId)(i % STRING_COUNT));
+	}
+	Report(L"strings.generated.100k", COUNT, Now() - start);
+
+	delete[] pKeys;
+	return E_SUCCESS;
+}
+
+result Benchmark::RunTextSuite(void) {
+	const int COUNT = 100000;
+
+	String *pTitles = new String[COUNT];
+	for (int i = 0; i < COUNT; i++) {
+		Note *pNote = SyntheticNoteEnumerator::CreateNoteN(i, 0);
+		pTitles[i] = pNote->GetTitle();
+		delete pNote;
+	}
+
+	//what the cache filter did per keystroke: copy and lower every title
+	String filter = L"ПоКуп";
+	String lower_filter;
+	filter.ToLowerCase(lower_filter);
+	int found = 0;
+	long long start = Now();
+	for (int i = 0; i < COUNT; i++) {
+		String tmp = pTitles[i];
+		tmp.ToLowerCase();
+		int index = -1;
+		if (!IsFailed(tmp.IndexOf(lower_filter, 0, index))) {
+			found++;
+		}
+	}
+	Report(L"text.filter.lowercase_copy.100k", COUNT, Now() - start);
+
+	TextBuilder needle;
+	needle.Append(filter);
+	needle.FoldCase();
+	TextView folded = needle.GetView();
+	int found_folded = 0;
+	start = Now();
+	for (int i = 0; i < COUNT; i++) {
+		if (TextUtils::ContainsFolded(TextView(pTitles[i]), folded.pChars, folded.length)) {
+			found_folded++;
+		}
+	}
+	Report(L"text.filter.folded_view.100k", COUNT, Now() - start);
+
+	start = Now();
+	for (int i = 0; i < COUNT; i++) {
+		if (pTitles[i].GetLength() >= TextUtils::AUTO_TITLE_LENGTH) {
+			String title;
+			pTitles[i].SubString(0, TextUtils::AUTO_TITLE_LENGTH, title);
+			title.Append(L"...");
+		}
+	}
+	Report(L"text.auto_title.substring.100k", COUNT, Now() - start);
+
+	start = Now();
+	for (int i = 0; i < COUNT; i++) {
+		String title = TextUtils::Truncate(pTitles[i], TextUtils::AUTO_TITLE_LENGTH);
+	}
+	Report(L"text.auto_title.truncate.100k", COUNT, Now() - start);
+
+	//same shape as the keyset query in NotesManager
+	const int QUERIES = 10000;
+	start = Now();
+	for (int i = 0; i < QUERIES; i++) {
+		String query = L"SELECT entries.entry_id,entries.type,entries.timestamp,entries.marked,entries.title FROM entries WHERE 1 ";
+		query.Append(L"AND (entries.type = ");
+		query.Append(i % 3 + 1);
+		query.Append(L") AND ((entries.marked < ?) OR (entries.marked = ? AND ((entries.title_key > ?) OR (entries.title_key = ? AND entries.entry_id > ?)))) ");
+		query.Append(L"ORDER BY entries.marked DESC, entries.title_key ASC, entries.entry_id ASC LIMIT ? OFFSET ?");
+	}
+	Report(L"text.query.string_append.10k", QUERIES, Now() - start);
+
+	start = Now();
+	for (int i = 0; i < QUERIES; i++) {
+		TextBuilder query;
+		query.Append(L"SELECT entries.entry_id,entries.type,entries.timestamp,entries.marked,entries.title FROM entries WHERE 1 ");
+		query.Append(L"AND (entries.type = ");
+		query.Append(i % 3 + 1);
+		query.Append(L") AND ((entries.marked < ?) OR (entries.marked = ? AND ((entries.title_key > ?) OR (entries.title_key = ? AND entries.entry_id > ?)))) ");
+		query.Append(L"ORDER BY entries.marked DESC, entries.title_key ASC, entries.entry_id ASC LIMIT ? OFFSET ?");
+		String str = query.ToString();
+	}
+	Report(L"text.query.builder.10k", QUERIES, Now() - start);
+
+	delete[] pTitles;
+
+	if (found != found_folded) {
+		AppLogException("Folded filter matched %d titles, lowercase copy matched %d", found_folded, found);
+		return E_INVALID_STATE;
+	}
+	return E_SUCCESS;
+}
+
+result Benchmark::RunCacheSuite(void) {
+	CachingNotesManager *pManager = new CachingNotesManager;
+
+	long long start = Now();
+	result res = pManager->Construct(__storePath);
+	Report(L"caching.startup", 1, Now() - start);
+
+	if (IsFailed(res)) {
+		delete pManager;
+		return res;
+	}
+
+	const int QUERY_ITERATIONS = 10;
+	for (int sorting = SORT_BY_DATE; sorting <= SORT_BY_TYPE; sorting++) {
+		for (int mode = FILTER_BY_TITLE; mode <= FILTER_BY_TEXT; mode++) {
+			for (int filtered = 0; filtered < 2; filtered++) {
+				String name = L"caching.get_notes.";
+				name.Append(SortTypeName((SortType)sorting));
+				name.Append('.');
+				name.Append(FilterTypeName((FilterType)mode));
+				name.Append(filtered ? L".filtered" : L".unfiltered");
+
+				//cold runs drop memoized result sets first, so they measure the actual sort and filter
+				for (int warm = 0; warm < 2; warm++) {
+					start = Now();
+					for (int i = 0; i < QUERY_ITERATIONS; i++) {
+						if (!warm) {
+							pManager->ReleaseCachedResults();
+						}
+						//alternating order defeats any shortcut for already sorted input
+						LinkedListT<Note *> *pNotes = pManager->GetNotesN((SortType)sorting, (i % 2) ? SORT_ORDER_ASCENDING : SORT_ORDER_DESCENDING,
+																		   NOTE_TYPE_ALL, (FilterType)mode, filtered ? L"ide" : L"");
+						delete pNotes;
+					}
+					Report(name + (warm ? L".warm" : L".cold"), QUERY_ITERATIONS, Now() - start);
+				}
+			}
+		}
+	}
+
+	const int OPS = 100;
+	Note *notes[OPS];
+
+	start = Now();
+	for (int i = 0; i < OPS; i++) {
+		notes[i] = SyntheticNoteEnumerator::CreateNoteN(__noteCount + i, __textLength);
+		pManager->AddNote(notes[i]);
+	}
+	Report(L"caching.add_note", OPS, Now() - start);
+
+	start = Now();
+	pManager->Flush();
+	Report(L"caching.serialize_notes", OPS, Now() - start);
+
+	start = Now();
+	for (int i = 0; i < OPS; i++) {
+		notes[i]->SetMarked(!notes[i]->GetMarked());
+		notes[i]->SetSerialized(false);
+		pManager->UpdateNote(notes[i]);
+	}
+	Report(L"caching.update_note", OPS, Now() - start);
+
+	start = Now();
+	for (int i = 0; i < OPS; i++) {
+		pManager->RemoveNote(notes[i]);
+	}
+	Report(L"caching.remove_note", OPS, Now() - start);
+
+	pManager->Flush();
+	delete pManager;
+
+	for (int i = 0; i < OPS; i++) {
+		delete notes[i];
+	}
+	return E_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string.h>
+
+#include "BufferedFileWriter.h"
+
+BufferedFileWriter::BufferedFileWriter(void) {
+	__pFile = null;
+	__pBuffer = null;
+	__capacity = 0;
+	__used = 0;
+	__written = 0;
+}
+
+BufferedFileWriter::~BufferedFileWriter(void) {
+	Close();
+}
+
+result BufferedFileWriter::Construct(const String &path, bool append, int bufferSize) {
+	//a whole UTF-8 sequence has to fit after draining
+	if (bufferSize < 4) {
+		return E_INVALID_ARG;
+	}
+
+	__pFile = new File;
+	result res = __pFile->Construct(path, append ? L"a" : L"w", true);
+	if (IsFailed(res)) {
+		AppLogException("Failed to open file [%S] for writing, error: [%s]", path.GetPointer(), GetErrorMessage(res));
+
+		delete __pFile;
+		__pFile = null;
+		return res;
+	}
+
+	__pBuffer = new byte[bufferSize];
+	__capacity = bufferSize;
+	__used = 0;
+	__written = 0;
+
+	return E_SUCCESS;
+}
+
+result BufferedFileWriter::Drain(void) {
+	if (__used > 0) {
+		result res = __pFile->Write(__pBuffer, __used);
+		if (IsFailed(res)) {
+			AppLogException("Failed to write buffered data to file, error: [%s]", GetErrorMessage(res));
+			return res;
+		}
+		__used = 0;
+	}
+	return E_SUCCESS;
+}
+
+result BufferedFileWriter::Write(const void *pData, int length) {
+	if (!__pFile) {
+		return E_INVALID_STATE;
+	}
+
+	const byte *pSrc = static_cast<const byte*>(pData);
+	if (length >= __capacity) {
+		//chunk would not fit anyway, so there is no point in copying it
+		result res = Drain();
+		if (IsFailed(res)) return res;
+
+		res = __pFile->Write(pSrc, length);
+		if (IsFailed(res)) {
+			AppLogException("Failed to write data to file, error: [%s]", GetErrorMessage(res));
+			return res;
+		}
+		__written += length;
+		return E_SUCCESS;
+	}
+
+	if (__used + length > __capacity) {
+		result res = Drain();
+		if (IsFailed(res)) return res;
+	}
+	memcpy(__pBuffer + __used, pSrc, length);
+	__used += length;
+	__written += length;
+
+	return E_SUCCESS;
+}
+
+result BufferedFileWriter::WriteByte(byte val) {
+	if (!__pFile) {
+		return E_INVALID_STATE;
+	}
+	if (__used == __capacity) {
+		result res = Drain();
+		if (IsFailed(res)) return res;
+	}
+	__pBuffer[__used++] = val;
+	__written++;
+
+	return E_SUCCESS;
+}
+
+result BufferedFileWriter::WriteUtf8(const mchar *pStr, int length) {
+	if (!__pFile) {
+		return E_INVALID_STATE;
+	}
+
+	for (int i = 0; i < length; i++) {
+		//worst case of a single code point is 4 bytes
+		if (__capacity - __used < 4) {
+			result res = Drain();
+			if (IsFailed(res)) return res;
+		}
+
+		unsigned int cp = (unsigned int)pStr[i];
+		if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < length) {
+			unsigned int low = (unsigned int)pStr[i + 1];
+			if (low >= 0xDC00 && low <= 0xDFFF) {
+				cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+				i++;
+			}
+		}
+
+		byte *pDst = __pBuffer + __used;
+		int len = 0;
+		if (cp < 0x80) {
+			pDst[len++] = (byte)cp;
+		} else if (cp < 0x800) {
+			pDst[len++] = (byte)(0xC0 | (cp >> 6));
+			pDst[len++] = (byte)(0x80 | (cp & 0x3F));
+		} else if (cp < 0x10000) {
+			pDst[len++] = (byte)(0xE0 | (cp >> 12));
+			pDst[len++] = (byte)(0x80 | ((cp >> 6) & 0x3F));
+			pDst[len++] = (byte)(0x80 | (cp & 0x3F));
+		} else {
+			pDst[len++] = (byte)(0xF0 | (cp >> 18));
+			pDst[len++] = (byte)(0x80 | ((cp >> 12) & 0x3F));
+			pDst[len++] = (byte)(0x80 | ((cp >> 6) & 0x3F));
+			pDst[len++] = (byte)(0x80 | (cp & 0x3F));
+		}
+		__used += len;
+		__written += len;
+	}
+	return E_SUCCESS;
+}
+
+int BufferedFileWriter::GetUtf8Length(const mchar *pStr, int length) {
+	int len = 0;
+	for (int i = 0; i < length; i++) {
+		unsigned int cp = (unsigned int)pStr[i];
+		if (cp < 0x80) {
+			len += 1;
+		} else if (cp < 0x800) {
+			len += 2;
+		} else if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < length && pStr[i + 1] >= 0xDC00 && pStr[i + 1] <= 0xDFFF) {
+			len += 4;
+			i++;
+		} else {
+			len += 3;
+		}
+	}
+	return len;
+}
+
+result BufferedFileWriter::Flush(bool sync) {
+	if (!__pFile) {
+		return E_INVALID_STATE;
+	}
+
+	result res = Drain();
+	if (IsFailed(res)) return res;
+
+	if (sync) {
+		res = __pFile->Flush();
+		if (IsFailed(res)) {
+			AppLogException("Failed to flush file to storage, error: [%s]", GetErrorMessage(res));
+		}
+	}
+	return res;
+}
+
+result BufferedFileWriter::Close(void) {
+	result res = E_SUCCESS;
+	if (__pFile) {
+		res = Drain();
+		delete __pFile;
+		__pFile = null;
+	}
+	if (__pBuffer) {
+		delete[] __pBuffer;
+		__pBuffer = null;
+	}
+	__capacity = __used = 0;
+
+	return res;
+}
@@ -16,8 +16,12 @@
  * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <FSystem.h>
+#include <algorithm>
 
 #include "CachingNotesManager.h"
+#include "Metrics.h"
+#include "TextUtils.h"
+#include "Trace.h"
 
 using namespace Osp::System;
 
@@ -60,11 +64,17 @@ void SerializerThread::OnStop(void) {
 
 void SerializerThread::OnTimerExpired(Timer& timer) {
 	AppLogDebug("OnTimerExpired event!");
-	if (__pSerializer->__smtChanged) {
-		__pSerializer->SerializeNotes(*__pSerializer->__pNotes);
+	result res = E_SUCCESS;
+	{
+		TRACE_SCOPE("serializer.flush");
+		res = __pSerializer->Flush();
+	}
+	//extraction scans the store, so it only runs when there may be something new to extract
+	if (!IsFailed(res) && __pSerializer->TakeAudioChanged()) {
+		ExtractAudioInfo();
 	}
 
-	result res = __pTimer->Start(60*1000);
+	res = __pTimer->Start(60*1000);
 	if (IsFailed(res)) {
 		AppLogException("Failed to restart timer in serializer thread, error: [%s]", GetErrorMessage(res));
 		SetLastResult(res);
@@ -76,61 +86,83 @@ void SerializerThread::OnUserEventReceivedN(RequestId requestId, IList *pArgs) {
 	if (requestId == REQUEST_SERIALIZATION) {
 		__pTimer->Cancel();
 		OnTimerExpired(*__pTimer);
+	} else if (requestId == REQUEST_AUDIO_INFO) {
+		ExtractAudioInfo();
 	}
 }
 
-result NoteTitleComparer::Compare(Note* const &obj1, Note* const &obj2, int &cmp) const {
-	if (obj1->GetMarked() && !obj2->GetMarked()) {
-		cmp = -1;
-	} else if (!obj1->GetMarked() && obj2->GetMarked()) {
-		cmp = 1;
-	} else {
-		int ret = obj1->GetTitle().CompareTo(obj2->GetTitle());
-		cmp = __asc ? -ret : ret;
-	}
-	return E_SUCCESS;
-}
-
-result NoteDateComparer::Compare(Note* const &obj1, Note* const &obj2, int &cmp) const {
-	if (obj1->GetMarked() && !obj2->GetMarked()) {
-		cmp = -1;
-	} else if (!obj1->GetMarked() && obj2->GetMarked()) {
-		cmp = 1;
-	} else {
-		int ret = obj2->GetDate() - obj1->GetDate();
-		cmp = __asc ? -ret : ret;
-	}
-	return E_SUCCESS;
-}
-
-result NoteTypeComparer::Compare(Note* const &obj1, Note* const &obj2, int &cmp) const {
-	if (obj1->GetMarked() && !obj2->GetMarked()) {
-		cmp = -1;
-	} else if (!obj1->GetMarked() && obj2->GetMarked()) {
-		cmp = 1;
-	} else {
-		int ret = (int) obj2->GetType() - (int) obj1->GetType();
-		cmp = __asc ? -ret : ret;
+void SerializerThread::ExtractAudioInfo(void) {
+	int extracted = 0;
+	result res = __pSerializer->ExtractAudioInfo(AUDIO_INFO_BATCH, extracted);
+	if (IsFailed(res)) {
+		AppLogException("Failed to extract audio metadata, error: [%s]", GetErrorMessage(res));
+	} else if (extracted == AUDIO_INFO_BATCH) {
+		//more may be left, queued behind whatever else is pending
+		SendUserEvent(REQUEST_AUDIO_INFO, null);
 	}
-	return E_SUCCESS;
 }
 
 CachingNotesManager::CachingNotesManager() {
 	__pNotes = null;
+	__pSortKeys = null;
+	__pSortTemp = null;
+	__sortKeysCapacity = 0;
+	for (int p = 0; p < PARTITION_COUNT; p++) {
+		__partitions[p].pNotes = null;
+		__partitions[p].pKeys = null;
+		__partitions[p].capacity = 0;
+		__partitions[p].sorted = false;
+		__partitions[p].sorting = SORT_BY_DATE;
+		__partitions[p].order = SORT_ORDER_DESCENDING;
+	}
+	__pResults = null;
+	__epoch = 0;
 	__pSerializer = null;
+	__pBackup = null;
+	__pJournal = null;
+	__pRemovedIds = null;
+	__pLock = null;
 	__12APIAvailable = null;
 	__smtChanged = false;
+	//notes stored before metadata was extracted are picked up once after startup
+	__audioChanged = true;
 }
 
 CachingNotesManager::~CachingNotesManager() {
-	if (__pNotes) delete __pNotes;
+	//serializer works on the cache and the lock below, so it has to be finished before either goes away
 	if (__pSerializer) {
 		__pSerializer->Stop();
+		__pSerializer->Join();
 		delete __pSerializer;
 	}
+	if (__pNotes && __pLock) {
+		__pLock->Acquire();
+		result res = FlushLocked();
+		__pLock->Release();
+		if (IsFailed(res)) {
+			AppLogException("Failed to serialize cached notes on shutdown, changes stay in the journal, error: [%s]", GetErrorMessage(res));
+		}
+	}
+
+	if (__pNotes) delete __pNotes;
+	if (__pSortKeys) delete[] __pSortKeys;
+	if (__pSortTemp) delete[] __pSortTemp;
+	for (int p = 0; p < PARTITION_COUNT; p++) {
+		if (__partitions[p].pNotes) delete __partitions[p].pNotes;
+		if (__partitions[p].pKeys) delete[] __partitions[p].pKeys;
+	}
+	if (__pResults) delete __pResults;
+	if (__pBackup) delete __pBackup;
+	if (__pJournal) delete __pJournal;
+	if (__pRemovedIds) delete __pRemovedIds;
+	if (__pLock) delete __pLock;
 }
 
 result CachingNotesManager::Construct(const String &path) {
+	return Construct(path, null);
+}
+
+result CachingNotesManager::Construct(const String &path, ILoadProgressListener *pListener) {
     String platformVersion;
     result res = SystemInfo::GetValue(L"APIVersion", platformVersion);
     if (!IsFailed(res)) {
@@ -177,6 +209,30 @@ result CachingNotesManager::Construct(const String &path) {
 		return res;
     }
 
+    __pLock = new Mutex;
+    res = __pLock->Create();
+    if (IsFailed(res)) {
+    	AppLogException("Failed to create notes cache lock, error: [%s]", GetErrorMessage(res));
+    	return res;
+    }
+
+    __pRemovedIds = new ArrayListT<int>;
+    __pRemovedIds->Construct();
+
+    for (int p = 0; p < PARTITION_COUNT; p++) {
+    	__partitions[p].pNotes = new ArrayListT<Note *>;
+    	__partitions[p].pNotes->Construct();
+    }
+
+    //queries still work without memoization, just slower
+    __pResults = new ResultSetCache;
+    res = __pResults->Construct(MAX_RESULT_SETS, MAX_RESULT_SET_KEYS);
+    if (IsFailed(res)) {
+    	AppLogException("Failed to construct query result cache, error: [%s]", GetErrorMessage(res));
+    	delete __pResults;
+    	__pResults = null;
+    }
+
     __pSerializer = new SerializerThread;
     __pSerializer->Construct(this);
 
@@ -186,22 +242,93 @@ result CachingNotesManager::Construct(const String &path) {
 		return res;
 	}
 
-	__pNotes = NotesManager::GetNotesN();
+	LinkedListT<Note *> *pLoaded = NotesManager::LoadNotesN(pListener);
 	res = GetLastResult();
 	if (IsFailed(res)) {
 		AppLogException("Failed to precache notes, error: [%s]", GetErrorMessage(res));
 		return res;
 	}
 
+	__pNotes = new ArrayListT<Note *>;
+	res = __pNotes->Construct(*pLoaded);
+	delete pLoaded;
+	if (IsFailed(res)) {
+		AppLogException("Failed to precache notes, error: [%s]", GetErrorMessage(res));
+
+		delete __pNotes;
+		__pNotes = null;
+		return res;
+	}
+
+	__pJournal = new NotesJournal;
+	res = __pJournal->Construct(path);
+	if (IsFailed(res)) {
+		AppLogException("Failed to open cache journal, changes will not survive a crash until serialized, error: [%s]", GetErrorMessage(res));
+
+		delete __pJournal;
+		__pJournal = null;
+	} else {
+		long long generation = -1;
+		GetGeneration(generation);
+
+		//changes left over from a crash are written to the database right away
+		res = __pJournal->Replay(__pNotes, __pRemovedIds, generation, __smtChanged);
+		if (IsFailed(res)) {
+			AppLogException("Failed to replay cache journal, error: [%s]", GetErrorMessage(res));
+		} else if (__smtChanged) {
+			Flush();
+		} else {
+			//records skipped as already committed must not be looked at again
+			__pJournal->Reset(generation);
+		}
+	}
+
+	res = RebuildPartitionsLocked();
+	if (IsFailed(res)) {
+		AppLogException("Failed to partition notes cache, error: [%s]", GetErrorMessage(res));
+		return res;
+	}
+
 	__pSerializer->Start();
 
 	return E_SUCCESS;
 }
 
+result CachingNotesManager::EnableBackup(const String &backupRoot) {
+	StoreBackup *pBackup = new StoreBackup;
+	result res = pBackup->Construct(GetPath(), backupRoot);
+	if (IsFailed(res)) {
+		AppLogException("Failed to set up incremental backup, error: [%s]", GetErrorMessage(res));
+		delete pBackup;
+		return res;
+	}
+
+	if (__pBackup) delete __pBackup;
+	__pBackup = pBackup;
+
+	return E_SUCCESS;
+}
+
 result CachingNotesManager::AddNote(Note *val) {
 	if (__pNotes) {
+		__pLock->Acquire();
 		__smtChanged = true;
+		__audioChanged = __audioChanged || val->GetType() == NOTE_TYPE_AUDIO;
+		__epoch++;
+		//serializer only reads keys, so they are built here on the caller's thread
+		GetTitleKey(val);
 		result res = __pNotes->Add(val);
+		if (!IsFailed(res)) {
+			int index = GetPartitionIndex(val->GetType());
+			if (index >= 0) {
+				__partitions[index].pNotes->Add(val);
+				__partitions[index].sorted = false;
+			}
+		}
+		if (!IsFailed(res) && __pJournal) {
+			__pJournal->Append(JOURNAL_OP_ADD, val);
+		}
+		__pLock->Release();
 
 		if (!IsFailed(res)) __pSerializer->SendUserEvent(SerializerThread::REQUEST_SERIALIZATION, null);
 		return res;
@@ -211,9 +338,232 @@ result CachingNotesManager::AddNote(Note *val) {
 	}
 }
 
+//yielded notes belong to the enumerator, so the cache keeps copies of them
+static Note *CopyNoteN(const Note *pNote) {
+	Note *pCopy = new Note;
+	pCopy->Construct(pNote->GetType());
+	pCopy->SetDate(pNote->GetDate());
+	pCopy->SetMarked(pNote->GetMarked());
+	pCopy->SetTitle(pNote->GetTitle());
+	pCopy->SetText(pNote->GetText());
+	pCopy->SetResourcePath(pNote->GetResourcePath());
+	return pCopy;
+}
+
+result CachingNotesManager::ImportNotes(IEnumeratorT<Note *> &notes, int batchSize, IImportProgressListener *pListener) {
+	if (!__pNotes) {
+		AppLogException("Attempt to import notes to the list which wasn't cached yet");
+		return E_INVALID_STATE;
+	}
+	if (batchSize <= 0) {
+		return E_INVALID_ARG;
+	}
+
+	ArrayListT<Note *> batch;
+	result res = batch.Construct(batchSize);
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	int imported = 0;
+	bool more = true;
+	while (more && !IsFailed(res)) {
+		//source is read without the lock, so the cache stays usable while files are parsed
+		while (batch.GetCount() < batchSize) {
+			if (IsFailed(notes.MoveNext())) {
+				more = false;
+				break;
+			}
+			Note *pNote = null;
+			if (!IsFailed(notes.GetCurrent(pNote)) && pNote) {
+				batch.Add(CopyNoteN(pNote));
+			}
+		}
+		if (batch.GetCount() == 0) {
+			break;
+		}
+
+		IngestResources();
+		__pLock->Acquire();
+		//changes made meanwhile go first, so nothing logged in the journal predates the batch's generation
+		res = FlushLocked();
+		if (IsFailed(res)) {
+			AppLogException("Failed to serialize cached notes before import, error: [%s]", GetErrorMessage(res));
+		} else {
+			res = NotesManager::ImportBatch(batch);
+		}
+
+		if (!IsFailed(res)) {
+			//the batch advanced the generation the journal is based on
+			ResetJournalLocked();
+
+			//notes already cached stay where they are, references held by forms remain valid
+			for (int i = 0; i < batch.GetCount(); i++) {
+				Note *pNote = null;
+				batch.GetAt(i, pNote);
+				__pNotes->Add(pNote);
+				int index = GetPartitionIndex(pNote->GetType());
+				if (index >= 0) {
+					__partitions[index].pNotes->Add(pNote);
+					__partitions[index].sorted = false;
+				}
+				__audioChanged = __audioChanged || pNote->GetType() == NOTE_TYPE_AUDIO;
+			}
+			__epoch++;
+			imported += batch.GetCount();
+			batch.RemoveAll();
+		}
+		__pLock->Release();
+
+		if (!IsFailed(res) && pListener) {
+			pListener->OnImportProgress(imported);
+		}
+	}
+
+	//notes of a failed batch never made it into the cache
+	for (int i = 0; i < batch.GetCount(); i++) {
+		Note *pNote = null;
+		batch.GetAt(i, pNote);
+		delete pNote;
+	}
+	return res;
+}
+
+result CachingNotesManager::FlushLocked(void) {
+	if (!__smtChanged) {
+		return E_SUCCESS;
+	}
+
+	MetricsTimer timer(METRIC_FLUSH_DURATION);
+
+	result res = NotesManager::SerializeNotes(*__pNotes);
+	if (IsFailed(res)) {
+		AppLogException("Failed to serialize cached notes, error: [%s]", GetErrorMessage(res));
+		return res;
+	}
+
+	//serialized changes are committed at a newer generation now, so the journal is rebased on it right away;
+	//otherwise edits logged after a failed removal would be skipped on replay as already committed
+	ResetJournalLocked();
+	if (__pJournal) {
+		for (int i = 0; i < __pRemovedIds->GetCount(); i++) {
+			int entry_id = -1;
+			__pRemovedIds->GetAt(i, entry_id);
+			__pJournal->AppendRemove(entry_id);
+		}
+	}
+
+	while (__pRemovedIds->GetCount() > 0) {
+		int entry_id = -1;
+		__pRemovedIds->GetAt(0, entry_id);
+
+		res = NotesManager::RemoveNote(entry_id);
+		if (IsFailed(res)) {
+			AppLogException("Failed to remove note [%d] from database, error: [%s]", entry_id, GetErrorMessage(res));
+			return res;
+		}
+		__pRemovedIds->RemoveAt(0);
+	}
+
+	__smtChanged = false;
+
+	//journal is only dropped once the removals are committed too
+	ResetJournalLocked();
+	return E_SUCCESS;
+}
+
+void CachingNotesManager::IngestResources(void) {
+	ArrayListT<Note *> notes;
+	ArrayListT<String> paths;
+	notes.Construct();
+	paths.Construct();
+
+	__pLock->Acquire();
+	int count = __smtChanged ? __pNotes->GetCount() : 0;
+	for (int i = 0; i < count; i++) {
+		Note *pNote = null;
+		__pNotes->GetAt(i, pNote);
+		if (!pNote->GetSerialized() && (pNote->GetType() == NOTE_TYPE_PHOTO || pNote->GetType() == NOTE_TYPE_AUDIO)) {
+			notes.Add(pNote);
+			paths.Add(pNote->GetResourcePath());
+		}
+	}
+	__pLock->Release();
+
+	for (int i = 0; i < notes.GetCount(); i++) {
+		String path, stored;
+		paths.GetAt(i, path);
+		if (IsFailed(IngestResource(path, stored)) || stored.Equals(path, true)) {
+			continue;
+		}
+
+		//note may be gone or point elsewhere by now, the copy is collected as unreferenced then
+		__pLock->Acquire();
+		Note *pNote = null;
+		notes.GetAt(i, pNote);
+		if (__pNotes->Contains(pNote) && pNote->GetResourcePath().Equals(path, true)) {
+			pNote->SetResourcePath(stored);
+		}
+		__pLock->Release();
+	}
+}
+
+bool CachingNotesManager::TakeAudioChanged(void) {
+	__pLock->Acquire();
+	bool changed = __audioChanged;
+	__audioChanged = false;
+	__pLock->Release();
+
+	return changed;
+}
+
+void CachingNotesManager::ResetJournalLocked(void) {
+	if (!__pJournal) {
+		return;
+	}
+
+	long long generation = -1;
+	result res = GetGeneration(generation);
+	if (IsFailed(res)) {
+		AppLogException("Failed to get database generation, journal will be replayed in full after a crash, error: [%s]", GetErrorMessage(res));
+	}
+	__pJournal->Reset(generation);
+}
+
+result CachingNotesManager::Flush(void) {
+	if (!__pNotes) {
+		return E_INVALID_STATE;
+	}
+
+	IngestResources();
+
+	__pLock->Acquire();
+	bool flushed = __smtChanged;
+	result res = FlushLocked();
+	__pLock->Release();
+
+	if (!IsFailed(res) && flushed && __pBackup) {
+		res = __pBackup->Backup();
+		if (IsFailed(res)) {
+			AppLogException("Failed to write incremental backup, error: [%s]", GetErrorMessage(res));
+		}
+	}
+	return res;
+}
+
 result CachingNotesManager::UpdateNote(Note *val) {
 	if (__pNotes) {
+		__pLock->Acquire();
 		__smtChanged = true;
+		__audioChanged = __audioChanged || val->GetType() == NOTE_TYPE_AUDIO;
+		__epoch++;
+		GetTitleKey(val);
+		InvalidatePartition(val);
+		if (__pJournal) {
+			__pJournal->Append(JOURNAL_OP_UPDATE, val);
+		}
+		__pLock->Release();
+
 		__pSerializer->SendUserEvent(SerializerThread::REQUEST_SERIALIZATION, null);
 		return E_SUCCESS;
 	} else {
@@ -224,8 +574,24 @@ result CachingNotesManager::UpdateNote(Note *val) {
 
 result CachingNotesManager::RemoveNote(Note *val) {
 	if (__pNotes) {
-		__smtChanged = true;
+		__pLock->Acquire();
 		result res = __pNotes->Remove(val);
+		if (!IsFailed(res)) {
+			__smtChanged = true;
+			__epoch++;
+			int index = GetPartitionIndex(val->GetType());
+			if (index >= 0) {
+				__partitions[index].pNotes->Remove(val);
+				__partitions[index].sorted = false;
+			}
+			if (val->GetEntryId() >= 0) {
+				__pRemovedIds->Add(val->GetEntryId());
+			}
+			if (__pJournal) {
+				__pJournal->Append(JOURNAL_OP_REMOVE, val);
+			}
+		}
+		__pLock->Release();
 
 		if (!IsFailed(res)) __pSerializer->SendUserEvent(SerializerThread::REQUEST_SERIALIZATION, null);
 		return res;
@@ -258,12 +624,10 @@ result CachingNotesManager::RemoveNote(int entry_id) {
 		delete pEnum;
 
 		if (pToRemove) {
-			__smtChanged = true;
-			res = __pNotes->Remove(pToRemove);
-
-			if (!IsFailed(res)) __pSerializer->SendUserEvent(SerializerThread::REQUEST_SERIALIZATION, null);
-			return res;
+			Metrics::Add(METRIC_CACHE_HITS);
+			return RemoveNote(pToRemove);
 		} else {
+			Metrics::Add(METRIC_CACHE_MISSES);
 			return E_OBJ_NOT_FOUND;
 		}
 	} else {
@@ -272,65 +636,302 @@ result CachingNotesManager::RemoveNote(int entry_id) {
 	}
 }
 
-LinkedListT<Note *> *CachingNotesManager::GetNotesN(SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter) {
-	result res = E_SUCCESS;
-	if (__pNotes) {
-		if (sorting == SORT_BY_DATE) {
-			__pNotes->Sort(NoteDateComparer(order == SORT_ORDER_ASCENDING ? true : false));
-		} else if (sorting == SORT_BY_TYPE) {
-			__pNotes->Sort(NoteTypeComparer(order == SORT_ORDER_ASCENDING ? true : false));
+int CachingNotesManager::GetPartitionIndex(NoteType type) {
+	if (type < NOTE_TYPE_TEXT || type > NOTE_TYPE_MAP) {
+		return -1;
+	}
+	return type - NOTE_TYPE_TEXT;
+}
+
+result CachingNotesManager::RebuildPartitionsLocked(void) {
+	for (int p = 0; p < PARTITION_COUNT; p++) {
+		__partitions[p].pNotes->RemoveAll();
+		__partitions[p].sorted = false;
+	}
+
+	int count = __pNotes->GetCount();
+	for (int i = 0; i < count; i++) {
+		Note *pNote = null;
+		__pNotes->GetAt(i, pNote);
+
+		int index = GetPartitionIndex(pNote->GetType());
+		if (index >= 0) {
+			result res = __partitions[index].pNotes->Add(pNote);
+			if (IsFailed(res)) {
+				return res;
+			}
+		}
+	}
+	return E_SUCCESS;
+}
+
+void CachingNotesManager::InvalidatePartition(Note *val) {
+	int index = GetPartitionIndex(val->GetType());
+	if (index >= 0) {
+		__partitions[index].sorted = false;
+	}
+}
+
+result CachingNotesManager::EnsureSortBuffers(int count) {
+	if (count > __sortKeysCapacity) {
+		//buffers only grow, so repeated sorts of the same cache don't allocate
+		int capacity = count + count / 4;
+		NoteSortKey *pKeys = new NoteSortKey[capacity];
+		NoteSortKey *pTemp = new NoteSortKey[capacity];
+		if (!pKeys || !pTemp) {
+			if (pKeys) delete[] pKeys;
+			if (pTemp) delete[] pTemp;
+			return E_OUT_OF_MEMORY;
+		}
+		if (__pSortKeys) delete[] __pSortKeys;
+		if (__pSortTemp) delete[] __pSortTemp;
+		__pSortKeys = pKeys;
+		__pSortTemp = pTemp;
+		__sortKeysCapacity = capacity;
+	}
+	return E_SUCCESS;
+}
+
+result CachingNotesManager::SortPartitionLocked(int index, SortType sorting, SortOrder order) {
+	NotePartition &part = __partitions[index];
+	if (part.sorted && part.sorting == sorting && part.order == order) {
+		return E_SUCCESS;
+	}
+
+	TRACE_SCOPE("cache.sort");
+
+	int count = part.pNotes->GetCount();
+	if (count > part.capacity) {
+		int capacity = count + count / 4;
+		NoteSortKey *pKeys = new NoteSortKey[capacity];
+		if (!pKeys) {
+			return E_OUT_OF_MEMORY;
+		}
+		if (part.pKeys) delete[] part.pKeys;
+		part.pKeys = pKeys;
+		part.capacity = capacity;
+	}
+
+	for (int i = 0; i < count; i++) {
+		Note *pNote = null;
+		part.pNotes->GetAt(i, pNote);
+
+		NoteSortKey &key = part.pKeys[i];
+		key.pNote = pNote;
+		key.marked = pNote->GetMarked();
+		key.primary = sorting == SORT_BY_TYPE ? (long long)pNote->GetType() : pNote->GetDate();
+		if (sorting == SORT_BY_TITLE) {
+			//keys are built once per title and reused by every later sort
+			const ByteBuffer *pKey = GetTitleKey(pNote);
+			key.pTitleKey = pKey ? pKey->GetPointer() : null;
+			key.titleKeyLength = pKey ? pKey->GetLimit() : 0;
 		} else {
-			__pNotes->Sort(NoteTitleComparer(order == SORT_ORDER_ASCENDING ? true : false));
+			key.pTitleKey = null;
+			key.titleKeyLength = 0;
 		}
+	}
 
-		LinkedListT<Note *> *__pRet = new LinkedListT<Note *> ;
+	//scratch buffer is sized for the whole cache by the caller
+	result res = NoteSorter::Sort(part.pKeys, __pSortTemp, count, sorting, order == SORT_ORDER_ASCENDING);
+	if (IsFailed(res)) {
+		return res;
+	}
 
-		IEnumeratorT<Note *> *pEnum = __pNotes->GetEnumeratorN();
-		res = GetLastResult();
+	//next sort of this partition starts from this order, which keeps ties stable
+	for (int i = 0; i < count; i++) {
+		part.pNotes->SetAt(part.pKeys[i].pNote, i);
+	}
+	part.sorted = true;
+	part.sorting = sorting;
+	part.order = order;
+	return E_SUCCESS;
+}
+
+LinkedListT<Note *> *CachingNotesManager::GetNotesN(SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter) {
+	bool has_more = false;
+	return QueryCacheN(sorting, order, type_filter, filter_mode, filter, null, 0, -1, has_more);
+}
+
+LinkedListT<Note *> *CachingNotesManager::GetNotesPageN(int offset, int limit, bool &hasMore, SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter) {
+	if (offset < 0 || limit <= 0) {
+		SetLastResult(E_INVALID_ARG);
+		return null;
+	}
+	return QueryCacheN(sorting, order, type_filter, filter_mode, filter, null, offset, limit, hasMore);
+}
+
+LinkedListT<Note *> *CachingNotesManager::GetNotesAfterN(NotesCursor &cursor, int limit, bool &hasMore, SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter) {
+	if (limit <= 0) {
+		SetLastResult(E_INVALID_ARG);
+		return null;
+	}
+
+	if (!cursor.Matches(sorting, order)) {
+		cursor.Reset();
+	}
+
+	LinkedListT<Note *> *pNotes = QueryCacheN(sorting, order, type_filter, filter_mode, filter, &cursor, 0, limit, hasMore);
+	if (pNotes && pNotes->GetCount() > 0) {
+		Note *pLast = null;
+		pNotes->GetAt(pNotes->GetCount() - 1, pLast);
+		AdvanceCursor(cursor, pLast, sorting, order);
+	}
+	return pNotes;
+}
+
+int CachingNotesManager::FindCursor(const NoteSortKey *pKeys, int count, const NotesCursor &cursor, SortType sorting, SortOrder order) {
+	if (cursor.IsAtStart()) {
+		return 0;
+	}
+
+	NoteSortKey key;
+	key.pNote = null;
+	key.marked = cursor.GetMarked();
+	key.primary = cursor.GetPrimary();
+	key.pTitleKey = cursor.GetTitleKey() ? cursor.GetTitleKey()->GetPointer() : null;
+	key.titleKeyLength = cursor.GetTitleKey() ? cursor.GetTitleKey()->GetLimit() : 0;
+
+	NoteSortKeyLess less(sorting == SORT_BY_TITLE, order == SORT_ORDER_ASCENDING);
+	const NoteSortKey *pFirst = std::lower_bound(pKeys, pKeys + count, key, less);
+	const NoteSortKey *pLast = std::upper_bound(pFirst, pKeys + count, key, less);
+
+	//ties keep their relative order, so continue right after the cursor note; if it's gone, skip the whole run
+	for (const NoteSortKey *pKey = pFirst; pKey != pLast; pKey++) {
+		if (pKey->pNote->GetEntryId() == cursor.GetEntryId()) {
+			return (pKey - pKeys) + 1;
+		}
+	}
+	return pLast - pKeys;
+}
+
+result CachingNotesManager::FilterLocked(SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter, const NoteSortKey *&pKeys, int &count) {
+	pKeys = null;
+	count = 0;
+
+	result res = EnsureSortBuffers(__pNotes->GetCount());
+	if (IsFailed(res)) {
+		AppLogException("Failed to allocate sort buffers, error: [%s]", GetErrorMessage(res));
+		return res;
+	}
+
+	const NoteSortKey *pSorted = null;
+	int total = 0;
+	if (type_filter != NOTE_TYPE_ALL) {
+		//a single tab only ever touches its own partition
+		int index = GetPartitionIndex(type_filter);
+		if (index < 0) {
+			return E_SUCCESS;
+		}
+
+		res = SortPartitionLocked(index, sorting, order);
 		if (IsFailed(res)) {
-			AppLogException("Failed to acquire DB cache enumerator, error: [%s]", GetErrorMessage(res));
-			delete __pRet;
-			return null;
+			AppLogException("Failed to sort notes partition, error: [%s]", GetErrorMessage(res));
+			return res;
+		}
+		pSorted = __partitions[index].pKeys;
+		total = __partitions[index].pNotes->GetCount();
+	} else {
+		const NoteSortKey *runs[PARTITION_COUNT];
+		int counts[PARTITION_COUNT];
+		for (int p = 0; p < PARTITION_COUNT; p++) {
+			res = SortPartitionLocked(p, sorting, order);
+			if (IsFailed(res)) {
+				AppLogException("Failed to sort notes partition, error: [%s]", GetErrorMessage(res));
+				return res;
+			}
+			runs[p] = __partitions[p].pKeys;
+			counts[p] = __partitions[p].pNotes->GetCount();
+			total += counts[p];
 		}
 
-		String search_str;
-		if (__12APIAvailable && !filter.IsEmpty()) {
-			filter.ToLowerCase(search_str);
-		} else {
-			search_str = filter;
+		TRACE_SCOPE("cache.merge");
+
+		NoteSorter::MergeRuns(runs, counts, PARTITION_COUNT, __pSortKeys, sorting, order == SORT_ORDER_ASCENDING);
+		pSorted = __pSortKeys;
+	}
+
+	if (filter.IsEmpty()) {
+		pKeys = pSorted;
+		count = total;
+		return E_SUCCESS;
+	}
+
+	TRACE_SCOPE("cache.filter");
+
+	//needle is folded once, notes are matched in place instead of being copied and lowered one by one
+	TextBuilder needle;
+	res = needle.Append(filter);
+	if (IsFailed(res)) {
+		return res;
+	}
+	if (__12APIAvailable) {
+		needle.FoldCase();
+	}
+	TextView folded = needle.GetView();
+
+	//sorter is done with the scratch buffer, so matching keys are gathered there
+	for (int i = 0; i < total; i++) {
+		Note *pNote = pSorted[i].pNote;
+		TextView haystack(filter_mode == FILTER_BY_TEXT ? pNote->GetText() : pNote->GetTitle());
+
+		bool found = __12APIAvailable ? TextUtils::ContainsFolded(haystack, folded.pChars, folded.length) : TextUtils::Contains(haystack, folded);
+		if (!found) {
+			continue;
 		}
+		__pSortTemp[count++] = pSorted[i];
+	}
+	pKeys = __pSortTemp;
+	return E_SUCCESS;
+}
 
-		if (pEnum) {
-			while(!IsFailed(pEnum->MoveNext())) {
-				Note *pNote; pEnum->GetCurrent(pNote);
-				if (!filter.IsEmpty()) {
-
-					int sIndex = -1;
-					String tmp;
-					if (filter_mode == FILTER_BY_TEXT) {
-						tmp = pNote->GetText();
-					} else {
-						tmp = pNote->GetTitle();
-					}
-
-					if (__12APIAvailable) {
-						tmp.ToLowerCase();
-					}
-					res = tmp.IndexOf(search_str, 0, sIndex);
-
-					if (res == E_OBJ_NOT_FOUND) {
-						continue;
-					}
-				}
-				if (type_filter != NOTE_TYPE_ALL && type_filter != pNote->GetType()) {
-					continue;
-				}
-				__pRet->Add(pNote);
+LinkedListT<Note *> *CachingNotesManager::QueryCacheN(SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter,
+													 const NotesCursor *pAfter, int offset, int limit, bool &hasMore) {
+	hasMore = false;
+
+	if (__pNotes) {
+		//serializer thread enumerates the same list
+		__pLock->Acquire();
+
+		ResultSetKey key;
+		key.sorting = sorting;
+		key.order = order;
+		key.typeFilter = type_filter;
+		key.filterMode = filter_mode;
+		key.filter = filter;
+
+		int count = 0;
+		const NoteSortKey *pKeys = __pResults ? __pResults->Find(key, __epoch, count) : null;
+		if (pKeys) {
+			Metrics::Add(METRIC_RESULT_SET_HITS);
+		} else {
+			Metrics::Add(METRIC_RESULT_SET_MISSES);
+
+			result res = FilterLocked(sorting, order, type_filter, filter_mode, filter, pKeys, count);
+			if (IsFailed(res)) {
+				__pLock->Release();
+				SetLastResult(res);
+				return null;
+			}
+
+			//sets over the bound are just not remembered
+			if (__pResults) {
+				__pResults->Put(key, __epoch, pKeys, count);
 			}
 		}
 
-		delete pEnum;
+		LinkedListT<Note *> *__pRet = new LinkedListT<Note *> ;
+
+		int start = pAfter ? FindCursor(pKeys, count, *pAfter, sorting, order) : offset;
+		int end = count;
+		if (limit >= 0 && start + limit < count) {
+			end = start + limit;
+			hasMore = true;
+		}
+		for (int i = start; i < end; i++) {
+			__pRet->Add(pKeys[i].pNote);
+		}
 
+		__pLock->Release();
 		return __pRet;
 	} else {
 		AppLogException("Attempt to get notes list when it wasn't pre-cached yet");
@@ -339,19 +940,32 @@ LinkedListT<Note *> *CachingNotesManager::GetNotesN(SortType sorting, SortOrder
 	}
 }
 
-Note *CachingNotesManager::GetNote(int index) const {
+void CachingNotesManager::ReleaseCachedResults(void) {
 	if (__pNotes) {
-		Note *pRet;
-		result res = __pNotes->GetAt(index, pRet);
-		SetLastResult(res);
-		if (IsFailed(res)) {
-			return null;
-		} else {
-			return pRet;
+		__pLock->Acquire();
+		if (__pResults) {
+			__pResults->Clear();
+		}
+		__pLock->Release();
+	}
+}
+
+void CachingNotesManager::OnAudioInfoExtracted(int entry_id, const AudioInfo &info) const {
+	if (!__pNotes) {
+		return;
+	}
+
+	//duration is not a sort key, so memoized results stay valid
+	__pLock->Acquire();
+	int index = GetPartitionIndex(NOTE_TYPE_AUDIO);
+	ArrayListT<Note *> *pList = (index >= 0 && __partitions[index].pNotes) ? __partitions[index].pNotes : __pNotes;
+	for (int i = 0; i < pList->GetCount(); i++) {
+		Note *pNote = null;
+		pList->GetAt(i, pNote);
+		if (pNote && pNote->GetEntryId() == entry_id) {
+			pNote->SetAudioDuration(info.duration);
+			break;
 		}
-	} else {
-		AppLogException("Attempt to get note from the list which wasn't cached yet");
-		SetLastResult(E_INVALID_STATE);
-		return null;
 	}
+	__pLock->Release();
 }
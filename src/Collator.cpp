@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <FLocales.h>
+
+#include "Collator.h"
+#include "TextUtils.h"
+
+using namespace Osp::Locales;
+
+static const int LEVEL_SEPARATOR = 0x0001;
+
+static const int WEIGHT_PUNCTUATION = 0x0100;
+static const int WEIGHT_DIGIT = 0x0200;
+static const int WEIGHT_SCRIPT_FIRST = 0x0300;
+static const int WEIGHT_SCRIPT_SECOND = 0x0400;
+static const int WEIGHT_UNKNOWN = 0xFF00;
+
+static const int SECONDARY_BASE = 0x0002;
+static const int TERTIARY_LOWER = 0x0002;
+static const int TERTIARY_UPPER = 0x0003;
+
+//base letters of U+00C0..U+00FF, '*' marks expansions, '!' marks symbols
+static const char LATIN1_BASE[] =
+	"aaaaaa*ceeeeiiiidnooooo!ouuuuy**"
+	"aaaaaa*ceeeeiiiidnooooo!ouuuuy*y";
+
+//base letters of U+0100..U+017F
+static const char LATIN_EXT_A_BASE[] =
+	"aaaaaacccccccc" "dddd" "eeeeeeeeee" "gggggggg" "hhhh" "iiiiiiiiii" "**" "jj" "kkk"
+	"llllllllll" "nnnnnnn" "nn" "oooooo" "**" "rrrrrr" "ssssssss" "tttttt" "uuuuuuuuuuuu"
+	"ww" "yyy" "zzzzzz" "s";
+
+Collator::Collator(void) {
+	__language = L"";
+	__latinBase = WEIGHT_SCRIPT_FIRST;
+	__cyrillicBase = WEIGHT_SCRIPT_SECOND;
+}
+
+result Collator::Construct(const String &language) {
+	__language = language;
+
+	//readers of Russian expect their own alphabet before Latin titles
+	if (language.StartsWith(L"ru", 0)) {
+		__cyrillicBase = WEIGHT_SCRIPT_FIRST;
+		__latinBase = WEIGHT_SCRIPT_SECOND;
+	} else {
+		__latinBase = WEIGHT_SCRIPT_FIRST;
+		__cyrillicBase = WEIGHT_SCRIPT_SECOND;
+	}
+	return E_SUCCESS;
+}
+
+String Collator::GetRulesId(void) const {
+	String id = __language;
+	id.Append(L":");
+	id.Append(RULES_VERSION);
+	return id;
+}
+
+String Collator::GetSystemLanguage(void) {
+	LocaleManager locMgr;
+	result res = locMgr.Construct();
+	if (IsFailed(res)) {
+		AppLogException("Failed to construct locale manager, using default collation. Error: [%s]", GetErrorMessage(res));
+		return L"eng";
+	}
+
+	return locMgr.GetSystemLocale().GetLanguageCodeString();
+}
+
+mchar Collator::FoldAccent(mchar lower, const char *&pExpansion) {
+	pExpansion = null;
+
+	char base = 0;
+	if (lower >= 0x00C0 && lower <= 0x00FF) {
+		base = LATIN1_BASE[lower - 0x00C0];
+	} else if (lower >= 0x0100 && lower <= 0x017F) {
+		base = LATIN_EXT_A_BASE[lower - 0x0100];
+	} else if (lower == 0x0451) {
+		//'ё' is 'е' with a diaeresis, as in Russian dictionaries
+		return 0x0435;
+	} else {
+		return lower;
+	}
+
+	if (base == '*') {
+		switch (lower) {
+		case 0x00E6: pExpansion = "ae"; break;
+		case 0x00FE: pExpansion = "th"; break;
+		case 0x00DF: pExpansion = "ss"; break;
+		case 0x0133: pExpansion = "ij"; break;
+		case 0x0153: pExpansion = "oe"; break;
+		default: return lower;
+		}
+		return pExpansion[0];
+	} else if (base == '!') {
+		return lower;
+	}
+	return base;
+}
+
+int Collator::GetPrimaryWeights(mchar ch, int *pWeights) const {
+	if (ch >= L'a' && ch <= L'z') {
+		pWeights[0] = __latinBase + (ch - L'a');
+		return 1;
+	} else if (ch >= 0x0430 && ch <= 0x044F) {
+		pWeights[0] = __cyrillicBase + (ch - 0x0430);
+		return 1;
+	} else if (ch >= L'0' && ch <= L'9') {
+		pWeights[0] = WEIGHT_DIGIT + (ch - L'0');
+		return 1;
+	} else if (ch < 0x0080) {
+		pWeights[0] = WEIGHT_PUNCTUATION + ch;
+		return 1;
+	}
+
+	//anything else goes after all known letters in code point order
+	pWeights[0] = WEIGHT_UNKNOWN;
+	pWeights[1] = ch < SECONDARY_BASE ? SECONDARY_BASE : ch;
+	return 2;
+}
+
+static inline int PutWeight(byte *pBuf, int pos, int weight) {
+	pBuf[pos] = (byte)((weight >> 8) & 0xFF);
+	pBuf[pos + 1] = (byte)(weight & 0xFF);
+	return pos + 2;
+}
+
+ByteBuffer *Collator::CreateKeyN(const String &str) const {
+	int len = str.GetLength();
+	const mchar *pStr = str.GetPointer();
+
+	//every character yields at most two weights on each of three levels
+	int levelSize = len * 4;
+	byte *pBuf = new byte[levelSize * 3 + 4];
+	if (!pBuf) {
+		SetLastResult(E_OUT_OF_MEMORY);
+		return null;
+	}
+
+	int primary = 0;
+	int secondary = levelSize + 2;
+	int tertiary = levelSize * 2 + 4;
+	int secondaryStart = secondary;
+	int tertiaryStart = tertiary;
+
+	for (int i = 0; i < len; i++) {
+		bool upper = false;
+		mchar lower = TextUtils::FoldCase(pStr[i], upper);
+
+		const char *pExpansion = null;
+		mchar base = FoldAccent(lower, pExpansion);
+
+		int accent = base == lower ? SECONDARY_BASE : (int)lower;
+		int caseWeight = upper ? TERTIARY_UPPER : TERTIARY_LOWER;
+
+		int weights[4];
+		int count = 0;
+		if (pExpansion) {
+			for (const char *p = pExpansion; *p; p++) {
+				count += GetPrimaryWeights((mchar)*p, weights + count);
+			}
+		} else {
+			count = GetPrimaryWeights(base, weights);
+		}
+
+		for (int j = 0; j < count; j++) {
+			primary = PutWeight(pBuf, primary, weights[j]);
+			secondary = PutWeight(pBuf, secondary, accent);
+			tertiary = PutWeight(pBuf, tertiary, caseWeight);
+		}
+	}
+
+	//pack levels together, separator sorts below every weight so prefixes go first
+	int secondaryLength = secondary - secondaryStart;
+	int tertiaryLength = tertiary - tertiaryStart;
+
+	int pos = PutWeight(pBuf, primary, LEVEL_SEPARATOR);
+	memmove(pBuf + pos, pBuf + secondaryStart, secondaryLength);
+	pos = PutWeight(pBuf, pos + secondaryLength, LEVEL_SEPARATOR);
+	memmove(pBuf + pos, pBuf + tertiaryStart, tertiaryLength);
+	pos += tertiaryLength;
+
+	ByteBuffer *pKey = new ByteBuffer;
+	result res = pKey->Construct(pos > 0 ? pos : 1);
+	if (!IsFailed(res)) {
+		res = pKey->SetArray(pBuf, 0, pos);
+	}
+	delete[] pBuf;
+
+	if (IsFailed(res)) {
+		AppLogException("Failed to build collation key, error: [%s]", GetErrorMessage(res));
+
+		delete pKey;
+		SetLastResult(res);
+		return null;
+	}
+
+	pKey->Flip();
+	return pKey;
+}
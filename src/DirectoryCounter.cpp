@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "DirectoryCounter.h"
+#include "Trace.h"
+
+DirectoryCounter::DirectoryCounter(void) {
+	__maxEntries = 0;
+	__pTarget = null;
+	__pEntries = null;
+	__pLock = null;
+	__generation = 0;
+}
+
+DirectoryCounter::~DirectoryCounter(void) {
+	if (__pEntries) {
+		while (__pEntries->GetCount() > 0) {
+			Entry *pEntry = null;
+			__pEntries->GetAt(0, pEntry);
+			__pEntries->RemoveAt(0);
+			delete pEntry;
+		}
+		delete __pEntries;
+	}
+	if (__pLock) delete __pLock;
+}
+
+result DirectoryCounter::Construct(int maxEntries, Control *pTarget) {
+	if (maxEntries <= 0) {
+		return E_INVALID_ARG;
+	}
+
+	__maxEntries = maxEntries;
+	__pTarget = pTarget;
+
+	__pLock = new Mutex;
+	result res = __pLock->Create();
+	if (IsFailed(res)) {
+		AppLogException("Failed to create directory counter lock, error: [%s]", GetErrorMessage(res));
+		return res;
+	}
+
+	__pEntries = new ArrayListT<Entry *>;
+	res = __pEntries->Construct(maxEntries);
+	if (IsFailed(res)) {
+		AppLogException("Failed to construct directory count list, error: [%s]", GetErrorMessage(res));
+		return res;
+	}
+
+	return Thread::Construct(THREAD_TYPE_EVENT_DRIVEN);
+}
+
+bool DirectoryCounter::OnStart(void) {
+	return true;
+}
+
+void DirectoryCounter::OnStop(void) {
+}
+
+DirectoryCounter::Entry *DirectoryCounter::FindLocked(const String &path, bool touch) {
+	for (int i = 0; i < __pEntries->GetCount(); i++) {
+		Entry *pEntry = null;
+		__pEntries->GetAt(i, pEntry);
+		if (pEntry->path.Equals(path, true)) {
+			if (touch && i > 0) {
+				__pEntries->RemoveAt(i);
+				__pEntries->InsertAt(pEntry, 0);
+			}
+			return pEntry;
+		}
+	}
+	return null;
+}
+
+int DirectoryCounter::GetCount(const String &dir) {
+	if (!__pEntries || dir.IsEmpty()) {
+		return -1;
+	}
+
+	__pLock->Acquire();
+	int count = -1;
+	Entry *pEntry = FindLocked(dir, true);
+	if (pEntry) {
+		count = pEntry->count;
+	}
+	int generation = __generation;
+	__pLock->Release();
+
+	//even a known count is checked again, the directory may have changed since
+	ArrayList *pArgs = new ArrayList;
+	pArgs->Construct();
+	pArgs->Add(*(new String(dir)));
+	pArgs->Add(*(new Integer(generation)));
+
+	result res = SendUserEvent(REQUEST_COUNT, pArgs);
+	if (IsFailed(res)) {
+		AppLogException("Failed to queue element count for [%S], error: [%s]", dir.GetPointer(), GetErrorMessage(res));
+
+		pArgs->RemoveAll(true);
+		delete pArgs;
+	}
+	return count;
+}
+
+void DirectoryCounter::CancelPending(void) {
+	if (!__pLock) {
+		return;
+	}
+
+	__pLock->Acquire();
+	__generation++;
+	__pLock->Release();
+}
+
+void DirectoryCounter::OnUserEventReceivedN(RequestId requestId, IList *pArgs) {
+	if (requestId == REQUEST_COUNT && pArgs && pArgs->GetCount() > 1) {
+		String path = *static_cast<String *>(pArgs->GetAt(0));
+		int generation = static_cast<Integer *>(pArgs->GetAt(1))->ToInt();
+
+		__pLock->Acquire();
+		bool stale = generation != __generation;
+		__pLock->Release();
+
+		FileAttributes attr;
+		if (!stale && !IsFailed(File::GetAttributes(path, attr))) {
+			DateTime modified = attr.GetLastModifiedTime();
+
+			__pLock->Acquire();
+			Entry *pEntry = FindLocked(path, false);
+			bool known = pEntry && pEntry->count >= 0 && pEntry->modified == modified;
+			__pLock->Release();
+
+			int count = -1;
+			if (!known) {
+				count = CountElements(path);
+
+				__pLock->Acquire();
+				pEntry = FindLocked(path, false);
+				if (!pEntry) {
+					while (__pEntries->GetCount() >= __maxEntries) {
+						Entry *pLast = null;
+						__pEntries->GetAt(__pEntries->GetCount() - 1, pLast);
+						__pEntries->RemoveAt(__pEntries->GetCount() - 1);
+						delete pLast;
+					}
+					pEntry = new Entry;
+					pEntry->path = path;
+					__pEntries->InsertAt(pEntry, 0);
+				}
+				pEntry->modified = modified;
+				pEntry->count = count;
+				__pLock->Release();
+			}
+
+			//target already shows the right count if nothing changed
+			if (!known && __pTarget) {
+				ArrayList *pReady = new ArrayList;
+				pReady->Construct();
+				pReady->Add(*(new String(path)));
+				pReady->Add(*(new Integer(count)));
+
+				result res = __pTarget->SendUserEvent(COUNT_READY, pReady);
+				if (IsFailed(res)) {
+					pReady->RemoveAll(true);
+					delete pReady;
+				}
+			}
+		}
+	}
+
+	if (pArgs) {
+		pArgs->RemoveAll(true);
+		delete pArgs;
+	}
+}
+
+int DirectoryCounter::CountElements(const String &dir) {
+	TRACE_SCOPE("io.count_directory");
+
+	Directory *pDir = new Directory;
+	result res = pDir->Construct(dir);
+	if (IsFailed(res)) {
+		AppLogException("Failed to construct directory object for path [%S], error: [%s]", dir.GetPointer(), GetErrorMessage(res));
+
+		delete pDir;
+
+		SetLastResult(res);
+		return -1;
+	}
+
+	DirEnumerator *pDirEnum = pDir->ReadN();
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to construct directory enumerator for path [%S], error: [%s]", dir.GetPointer(), GetErrorMessage(res));
+
+		delete pDir;
+
+		SetLastResult(res);
+		return -1;
+	}
+
+	int count = 0;
+	while (!IsFailed(pDirEnum->MoveNext())) {
+		DirEntry entry = pDirEnum->GetCurrentDirEntry();
+		if (entry.GetName().Equals(String(L".")) || entry.GetName().Equals(String(L".."))) {
+			continue;
+		}
+		count++;
+	}
+
+	delete pDir;
+	delete pDirEnum;
+
+	return count;
+}
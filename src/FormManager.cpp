@@ -18,13 +18,18 @@
 #include <FApp.h>
 
 #include "FormManager.h"
+#include "Trace.h"
 
 using namespace Osp::App;
 
 BaseForm *FormManager::__pActiveForm = null;
 BaseForm *FormManager::__pPrevForm = null;
+BaseForm *FormManager::__pPool[FormManager::MAX_POOLED_FORMS] = { null };
+int FormManager::__pooledCount = 0;
 
 result FormManager::SetActiveForm(BaseForm *pForm, bool release) {
+	TRACE_SCOPE("ui.set_active_form");
+
 	if (pForm == __pPrevForm) {
 		return SetPreviousFormActive(release);
 	}
@@ -41,7 +46,11 @@ result FormManager::SetActiveForm(BaseForm *pForm, bool release) {
 					__pActiveForm->OnBecameInactive();
 				}
 
-				result res = pFrame->AddControl(*pForm);
+				//pooled forms never left the frame
+				result res = E_SUCCESS;
+				if (pForm->GetParent() != pFrame) {
+					res = pFrame->AddControl(*pForm);
+				}
 				if (IsFailed(res)) {
 					AppLogException("Failed to add form to the frame object, error: [%s]", GetErrorMessage(res));
 					//well, let's at least try to get things back
@@ -64,13 +73,9 @@ result FormManager::SetActiveForm(BaseForm *pForm, bool release) {
 				result rr = E_SUCCESS;
 				if (__pActiveForm) {
 					if (release) {
-						__pActiveForm->OnRemovedFromFormManager();
-
-						rr = pFrame->RemoveControl(*__pActiveForm);
+						rr = ReleaseForm(pFrame, __pActiveForm);
 					} else if (__pPrevForm) {
-						__pPrevForm->OnRemovedFromFormManager();
-
-						rr = pFrame->RemoveControl(*__pPrevForm);
+						rr = ReleaseForm(pFrame, __pPrevForm);
 						__pPrevForm = __pActiveForm;
 					} else {
 						__pPrevForm = __pActiveForm;
@@ -92,9 +97,8 @@ result FormManager::SetActiveForm(BaseForm *pForm, bool release) {
 				}
 			} else if (__pActiveForm) {
 				__pActiveForm->OnBecameInactive();
-				__pActiveForm->OnRemovedFromFormManager();
 
-				result res = pFrame->RemoveControl(*__pActiveForm);
+				result res = ReleaseForm(pFrame, __pActiveForm);
 				__pActiveForm = null;
 
 				if (IsFailed(res)) {
@@ -155,9 +159,7 @@ result FormManager::SetPreviousFormActive(bool release) {
 			__pActiveForm->OnBecameActive();
 
 			if (release && __pPrevForm) {
-				__pPrevForm->OnRemovedFromFormManager();
-
-				res = pFrame->RemoveControl(*__pPrevForm);
+				res = ReleaseForm(pFrame, __pPrevForm);
 				__pPrevForm = null;
 
 				if (IsFailed(res)) {
@@ -192,6 +194,8 @@ result FormManager::RemoveAllForms(void) {
 			}
 
 			__pActiveForm = __pPrevForm = null;
+			//pooled forms went away with the rest of controls
+			__pooledCount = 0;
 			return E_SUCCESS;
 		}
 	}
@@ -207,3 +211,57 @@ BaseForm *FormManager::GetActiveForm(void) {
 BaseForm *FormManager::GetPreviousForm(void) {
 	return __pPrevForm;
 }
+
+void FormManager::NotifyLowMemory(void) {
+	if (__pActiveForm) {
+		__pActiveForm->OnLowMemory();
+	}
+	if (__pPrevForm) {
+		__pPrevForm->OnLowMemory();
+	}
+	ReleasePooledForms();
+}
+
+result FormManager::ReleaseForm(Frame *pFrame, BaseForm *pForm) {
+	pForm->OnRemovedFromFormManager();
+
+	if (pForm->IsReusable() && __pooledCount < MAX_POOLED_FORMS) {
+		__pPool[__pooledCount++] = pForm;
+		return E_SUCCESS;
+	}
+	return pFrame->RemoveControl(*pForm);
+}
+
+BaseForm *FormManager::TakePooledForm(const String &name) {
+	for (int i = 0; i < __pooledCount; i++) {
+		BaseForm *pForm = __pPool[i];
+		if (pForm->GetName().Equals(name, true)) {
+			__pPool[i] = __pPool[--__pooledCount];
+			__pPool[__pooledCount] = null;
+			return pForm;
+		}
+	}
+	return null;
+}
+
+void FormManager::ReleasePooledForms(void) {
+	if (!__pooledCount) {
+		return;
+	}
+
+	IAppFrame *appFrame = Application::GetInstance()->GetAppFrame();
+	Frame *pFrame = appFrame ? appFrame->GetFrame() : null;
+	if (!pFrame) {
+		AppLogException("Could not retrieve application frame interface");
+		return;
+	}
+
+	for (int i = 0; i < __pooledCount; i++) {
+		result res = pFrame->RemoveControl(*__pPool[i]);
+		if (IsFailed(res)) {
+			AppLogException("Failed to remove pooled form from frame object, error: [%s]", GetErrorMessage(res));
+		}
+		__pPool[i] = null;
+	}
+	__pooledCount = 0;
+}
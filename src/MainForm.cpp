@@ -19,8 +19,10 @@
 
 #include "FormManager.h"
 #include "MainForm.h"
+#include "Metrics.h"
 #include "SaveForm.h"
 #include "TextNoteForm.h"
+#include "Trace.h"
 
 using namespace Osp::App;
 
@@ -33,11 +35,20 @@ MainForm::MainForm(void) {
 
 	__pNotesListItemFormat = null;
 	__pNotesListSortingHeaderFormat = null;
-	__pNotesManager = null;
+	__pStores = null;
+	__storeId = -1;
+	__pShownNotes = null;
+	__hasMoreNotes = false;
+	__pThumbnails = null;
+	__pStoreOpener = null;
+	__pStorePopup = null;
+	__pStoreProgress = null;
+	__backupRoot = L"";
 	__currentTab = NOTE_TYPE_ALL;
 	__currentSorting = SORT_BY_DATE;
 	__currentSortOrder = SORT_ORDER_DESCENDING;
 	__currentFilterMode = FILTER_BY_TITLE;
+	__diagnosticsEnabled = false;
 
 	__pHeaderIconAsc = null;
 	__pHeaderIconDesc = null;
@@ -48,10 +59,21 @@ MainForm::MainForm(void) {
 }
 
 MainForm::~MainForm(void) {
+	if (__pStoreOpener) {
+		__pStoreOpener->Join();
+		delete __pStoreOpener;
+	}
+	if (__pStorePopup) delete __pStorePopup;
 	if (__pOptionMenu) delete __pOptionMenu;
 	if (__pNotesListItemFormat) delete __pNotesListItemFormat;
 	if (__pNotesListSortingHeaderFormat) delete __pNotesListSortingHeaderFormat;
-	if (__pNotesManager) delete __pNotesManager;
+	if (__pStores) delete __pStores;
+	if (__pShownNotes) delete __pShownNotes;
+	if (__pThumbnails) {
+		__pThumbnails->Stop();
+		__pThumbnails->Join();
+		delete __pThumbnails;
+	}
 
 	if (__pHeaderIconAsc) delete __pHeaderIconAsc;
 	if (__pHeaderIconDesc) delete __pHeaderIconDesc;
@@ -62,7 +84,7 @@ MainForm::~MainForm(void) {
 }
 
 result MainForm::Construct() {
-	result res = Form::Construct(L"IDF_MAINFORM");
+	result res = Form::Construct(IDF_MAINFORM);
 	if (IsFailed(res)) {
 		AppLogException("Failed to construct form's XML structure, error [%s]", GetErrorMessage(res));
 		return res;
@@ -73,10 +95,10 @@ result MainForm::Construct() {
 		__pTabPanel->SetEditModeEnabled(true);
 	}
 
-	__pMainPanel = static_cast<ScrollPanel*>(GetControl(L"IDC_MAINFORM_MAIN_SCROLLPANEL"));
+	__pMainPanel = static_cast<ScrollPanel*>(GetControl(IDC_MAINFORM_MAIN_SCROLLPANEL));
 	if (__pMainPanel) {
-		__pSearchField = static_cast<EditField*>(__pMainPanel->GetControl(L"IDPC_MAINFORM_SEARCH_FIELD"));
-		__pNotesList = static_cast<CustomList*>(__pMainPanel->GetControl(L"IDPC_MAINFORM_LIST"));
+		__pSearchField = static_cast<EditField*>(__pMainPanel->GetControl(IDPC_MAINFORM_SEARCH_FIELD));
+		__pNotesList = static_cast<CustomList*>(__pMainPanel->GetControl(IDPC_MAINFORM_LIST));
 	}
 
 	if (!CheckControls()) {
@@ -115,7 +137,15 @@ result MainForm::Construct() {
 	__pNotesListSortingHeaderFormat->AddElement(ID_LIST_HEADER_FORMAT_BITMAP, Rectangle(0,0,48,48));
 	__pNotesListSortingHeaderFormat->AddElement(ID_LIST_HEADER_FORMAT_TITLE, Rectangle(48,3,432,45));
 
-	__pNotesManager = new CachingNotesManager;
+	__pStores = new StoreRegistry;
+
+	__pShownNotes = new ArrayListT<Note *>;
+	res = __pShownNotes->Construct(NOTES_PAGE_SIZE);
+
+	if (IsFailed(res)) {
+		AppLogException("Failed to construct shown notes list, error [%s]", GetErrorMessage(res));
+		return res;
+	}
 
 	return E_SUCCESS;
 }
@@ -128,33 +158,29 @@ bool MainForm::CheckControls(void) const {
 
 String MainForm::SortTypeToString(SortType type) const {
 	if (type == SORT_BY_DATE) {
-		return GetString(L"SORT_TYPE_DATE");
+		return GetString(STR_SORT_TYPE_DATE);
 	} else if (type == SORT_BY_TITLE) {
-		return GetString(L"SORT_TYPE_TITLE");
+		return GetString(STR_SORT_TYPE_TITLE);
 	} else {
-		return GetString(L"SORT_TYPE_TYPE");
+		return GetString(STR_SORT_TYPE_TYPE);
 	}
 }
 
 result MainForm::LoadNotes(void) {
-	__pNotesList->RemoveAllItems();
+	TRACE_SCOPE("ui.load_notes");
+	MetricsTimer timer(METRIC_LIST_REFRESH);
 
-	LinkedListT<Note *> *pNotes = __pNotesManager->GetNotesN(__currentSorting, __currentSortOrder, __currentTab,
-															 __currentFilterMode, __pSearchField->GetText());
-	result res = GetLastResult();
-	if (IsFailed(res)) {
-		AppLogException("Failed to get notes list, error: [%s]", GetErrorMessage(res));
-		return res;
-	}
+	__pNotesList->RemoveAllItems();
+	__pShownNotes->RemoveAll();
+	__notesCursor.Reset();
+	__hasMoreNotes = false;
 
 	CustomListItem *pHeaderItem = new CustomListItem;
-	res = pHeaderItem->Construct(48);
+	result res = pHeaderItem->Construct(48);
 	if (IsFailed(res)) {
 		AppLogException("Failed to construct notes list item, error: [%s]", GetErrorMessage(res));
 
 		delete pHeaderItem;
-		delete pNotes;
-
 		return res;
 	}
 
@@ -163,66 +189,136 @@ result MainForm::LoadNotes(void) {
 	pHeaderItem->SetItemFormat(*__pNotesListSortingHeaderFormat);
 
 	pHeaderItem->SetElement(ID_LIST_HEADER_FORMAT_BITMAP, *header_icon, header_icon);
-	pHeaderItem->SetElement(ID_LIST_HEADER_FORMAT_TITLE, GetString(L"MAINFORM_NOTES_LIST_HEADER_TITLE") + SortTypeToString(__currentSorting));
+	pHeaderItem->SetElement(ID_LIST_HEADER_FORMAT_TITLE, GetString(STR_MAINFORM_NOTES_LIST_HEADER_TITLE) + SortTypeToString(__currentSorting));
 
 	__pNotesList->AddItem(*pHeaderItem, 1);
 
-	int i = 0;
+	res = LoadNextNotesPage();
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	RefreshForm();
+	return E_SUCCESS;
+}
+
+result MainForm::LoadNextNotesPage(void) {
+	if (__hasMoreNotes) {
+		__pNotesList->RemoveItemAt(__pNotesList->GetItemIndexFromItemId(ID_LIST_ITEM_SHOW_MORE));
+		__hasMoreNotes = false;
+	}
+
+	//only one screen is fetched at a time, the rest is requested through the trailing item
+	bool has_more = false;
+	LinkedListT<Note *> *pNotes = __pStores->GetNotesAfterN(__notesCursor, NOTES_PAGE_SIZE, has_more, __currentSorting, __currentSortOrder,
+																  __currentTab, __currentFilterMode, __pSearchField->GetText());
+	result res = GetLastResult();
+	if (!pNotes) {
+		if (!IsFailed(res)) res = E_FAILURE;
+		AppLogException("Failed to get notes list, error: [%s]", GetErrorMessage(res));
+		return res;
+	}
+
+	int i = __pShownNotes->GetCount();
 	IEnumeratorT<Note *> *pEnum = pNotes->GetEnumeratorN();
 	if (pEnum) {
 		while(!IsFailed(pEnum->MoveNext())) {
 			Note *pNote; pEnum->GetCurrent(pNote);
 
-			CustomListItem *pItem = new CustomListItem;
-			res = pItem->Construct(90);
-			if (IsFailed(res)) {
-				AppLogException("Failed to construct notes list item, error: [%s]", GetErrorMessage(res));
+			CustomListItem *pItem = CreateNoteItemN(pNote);
+			if (!pItem) {
+				res = GetLastResult();
 
-				delete pItem;
+				delete pEnum;
 				delete pNotes;
 
 				return res;
 			}
 
-			pItem->SetItemFormat(*__pNotesListItemFormat);
+			__pNotesList->AddItem(*pItem, i + 2);
+			__pShownNotes->Add(pNote);
+			i++;
+		}
+	}
+
+	delete pEnum;
+	delete pNotes;
 
-			pItem->SetElement(ID_LIST_FORMAT_DATE, GetLocaleSpecificDatetime(pNote->GetDate()));
+	if (has_more) {
+		CustomListItem *pMoreItem = new CustomListItem;
+		res = pMoreItem->Construct(48);
+		if (IsFailed(res)) {
+			AppLogException("Failed to construct notes list item, error: [%s]", GetErrorMessage(res));
 
-			res = GetLastResult();
-			if (IsFailed(res)) {
-				AppLogException("Failed to acquire locale specific datetime, error: [%s]", GetErrorMessage(res));
+			delete pMoreItem;
+			return res;
+		}
 
-				delete pItem;
-				delete pNotes;
+		pMoreItem->SetItemFormat(*__pNotesListSortingHeaderFormat);
+		pMoreItem->SetElement(ID_LIST_HEADER_FORMAT_TITLE, GetString(STR_MAINFORM_NOTES_LIST_SHOW_MORE));
 
-				return res;
-			}
+		__pNotesList->AddItem(*pMoreItem, ID_LIST_ITEM_SHOW_MORE);
+		__hasMoreNotes = true;
+	}
 
-			if (pNote->GetMarked()) {
-				pItem->SetElement(ID_LIST_FORMAT_BITMAP,*__pMarkIcon,__pMarkIcon);
-			} else {
-				if (pNote->GetType() == NOTE_TYPE_TEXT) {
-					pItem->SetElement(ID_LIST_FORMAT_BITMAP,*__pTextIcon,__pTextIcon);
-				} else if (pNote->GetType() == NOTE_TYPE_AUDIO) {
-					pItem->SetElement(ID_LIST_FORMAT_BITMAP,*__pAudioIcon,__pAudioIcon);
-				} else if (pNote->GetType() == NOTE_TYPE_PHOTO) {
-					pItem->SetElement(ID_LIST_FORMAT_BITMAP,*__pPhotoIcon,__pPhotoIcon);
-				}
-			}
+	return E_SUCCESS;
+}
 
-			pItem->SetElement(ID_LIST_FORMAT_TITLE,pNote->GetTitle());
+CustomListItem *MainForm::CreateNoteItemN(Note *pNote) {
+	CustomListItem *pItem = new CustomListItem;
+	result res = pItem->Construct(90);
+	if (IsFailed(res)) {
+		AppLogException("Failed to construct notes list item, error: [%s]", GetErrorMessage(res));
 
-			__pNotesList->AddItem(*pItem, i + 2);
-			i++;
-		}
+		delete pItem;
+		SetLastResult(res);
+		return null;
 	}
 
-	RefreshForm();
+	pItem->SetItemFormat(*__pNotesListItemFormat);
 
-	delete pEnum;
-	delete pNotes;
+	String date = GetLocaleSpecificDatetime(pNote->GetDate());
 
-	return E_SUCCESS;
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to acquire locale specific datetime, error: [%s]", GetErrorMessage(res));
+
+		delete pItem;
+		SetLastResult(res);
+		return null;
+	}
+
+	//duration comes with the note from the metadata table, media itself is never touched here
+	if (pNote->GetType() == NOTE_TYPE_AUDIO && pNote->GetAudioDuration() >= 0) {
+		int seconds = (pNote->GetAudioDuration() + 500) / 1000;
+		date.Append(L"  ");
+		date.Append(seconds / 60);
+		date.Append(seconds % 60 < 10 ? L":0" : L":");
+		date.Append(seconds % 60);
+	}
+	pItem->SetElement(ID_LIST_FORMAT_DATE, date);
+
+	if (pNote->GetMarked()) {
+		pItem->SetElement(ID_LIST_FORMAT_BITMAP,*__pMarkIcon,__pMarkIcon);
+	} else {
+		if (pNote->GetType() == NOTE_TYPE_TEXT) {
+			pItem->SetElement(ID_LIST_FORMAT_BITMAP,*__pTextIcon,__pTextIcon);
+		} else if (pNote->GetType() == NOTE_TYPE_AUDIO) {
+			pItem->SetElement(ID_LIST_FORMAT_BITMAP,*__pAudioIcon,__pAudioIcon);
+		} else if (pNote->GetType() == NOTE_TYPE_PHOTO) {
+			//generic icon stays until the thumbnail is decoded in background
+			Bitmap *pThumb = __pThumbnails ? __pThumbnails->GetThumbnail(pNote->GetResourcePath()) : null;
+			if (pThumb) {
+				pItem->SetElement(ID_LIST_FORMAT_BITMAP,*pThumb,pThumb);
+			} else {
+				pItem->SetElement(ID_LIST_FORMAT_BITMAP,*__pPhotoIcon,__pPhotoIcon);
+			}
+		}
+	}
+
+	pItem->SetElement(ID_LIST_FORMAT_TITLE,pNote->GetTitle());
+
+	return pItem;
 }
 
 result MainForm::UpdateOptionMenu(void) {
@@ -234,7 +330,7 @@ result MainForm::UpdateOptionMenu(void) {
 				AppLogException("Failed to remove sort by type subitem of option menu, error: [%s]", GetErrorMessage(res));
 			}
 		} else if (__currentTab == NOTE_TYPE_ALL && __pOptionMenu->GetSubItemCount(0) < 3) {
-			__pOptionMenu->AddSubItem(0, GetString(L"MAINFORM_OPTIONMENU_SORT_BY_TYPE"), ID_OPTION_SORT_BY_TYPE_CLICKED);
+			__pOptionMenu->AddSubItem(0, GetString(STR_MAINFORM_OPTIONMENU_SORT_BY_TYPE), ID_OPTION_SORT_BY_TYPE_CLICKED);
 		}
 		return res;
 	} else return E_INVALID_STATE;
@@ -254,6 +350,15 @@ result MainForm::SwitchTab(void) {
 result MainForm::OnKeypadSearchClicked(const Control &src) {
 	__pMainPanel->CloseOverlayWindow();
 
+	//diagnostics are hidden from regular users behind a service code
+	if (__pSearchField->GetText() == L"*#diag#") {
+		__pSearchField->Clear();
+		if (!__diagnosticsEnabled) {
+			__pOptionMenu->AddItem(GetString(STR_MAINFORM_OPTIONMENU_DIAGNOSTICS), ID_OPTION_DIAGNOSTICS_CLICKED);
+			__diagnosticsEnabled = true;
+		}
+	}
+
 	result res = __pSearchField->Draw();
 	if (IsFailed(res))
 		return res;
@@ -296,8 +401,8 @@ result MainForm::OnOptionSortByTypeClicked(const Control &src) {
 result MainForm::OnOptionSearchByTitleClicked(const Control &src) {
 	__currentFilterMode = FILTER_BY_TITLE;
 
-	String sGuide = GetString(L"MAINFORM_SEARCH_FIELD_GUIDE");
-	sGuide.Append(__currentFilterMode == FILTER_BY_TITLE ? GetString(L"MAINFORM_SEARCH_FIELD_GUIDE_BY_TITLE") : GetString(L"MAINFORM_SEARCH_FIELD_GUIDE_BY_TEXT"));
+	String sGuide = GetString(STR_MAINFORM_SEARCH_FIELD_GUIDE);
+	sGuide.Append(__currentFilterMode == FILTER_BY_TITLE ? GetString(STR_MAINFORM_SEARCH_FIELD_GUIDE_BY_TITLE) : GetString(STR_MAINFORM_SEARCH_FIELD_GUIDE_BY_TEXT));
 	__pSearchField->SetGuideText(sGuide);
 
 	return LoadNotes();
@@ -306,15 +411,16 @@ result MainForm::OnOptionSearchByTitleClicked(const Control &src) {
 result MainForm::OnOptionSearchByTextClicked(const Control &src) {
 	__currentFilterMode = FILTER_BY_TEXT;
 
-	String sGuide = GetString(L"MAINFORM_SEARCH_FIELD_GUIDE");
-	sGuide.Append(__currentFilterMode == FILTER_BY_TITLE ? GetString(L"MAINFORM_SEARCH_FIELD_GUIDE_BY_TITLE") : GetString(L"MAINFORM_SEARCH_FIELD_GUIDE_BY_TEXT"));
+	String sGuide = GetString(STR_MAINFORM_SEARCH_FIELD_GUIDE);
+	sGuide.Append(__currentFilterMode == FILTER_BY_TITLE ? GetString(STR_MAINFORM_SEARCH_FIELD_GUIDE_BY_TITLE) : GetString(STR_MAINFORM_SEARCH_FIELD_GUIDE_BY_TEXT));
 	__pSearchField->SetGuideText(sGuide);
 
 	return LoadNotes();
 }
 
 result MainForm::OnOptionChangeStorageClicked(const Control &src) {
-	SaveForm *pSaveForm = new SaveForm(CALLBACK(ID_SELECT_STORAGE_FILE), __pNotesManager->GetPath());
+	CachingNotesManager *pStore = __pStores->GetStore(__storeId);
+	SaveForm *pSaveForm = new SaveForm(CALLBACK(ID_SELECT_STORAGE_FILE), pStore ? pStore->GetPath() : String(L"/Home/notes.bin"));
 	result res = pSaveForm->Construct();
 	if (IsFailed(res)) {
 		AppLogException("Failed to construct file selection dialog, error: [%s]", GetErrorMessage(res));
@@ -331,6 +437,155 @@ result MainForm::OnOptionChangeStorageClicked(const Control &src) {
 	return res;
 }
 
+result MainForm::SwitchStorage(const String &path) {
+	if (__pStoreOpener) {
+		return E_IN_PROGRESS;
+	}
+	if (__storeId >= 0 && __pStores->FindStore(path) == __storeId) {
+		return E_SUCCESS;
+	}
+
+	__pStoreOpener = new StoreOpener;
+	result res = __pStoreOpener->Construct(path, __backupRoot, this);
+	if (!IsFailed(res)) {
+		res = __pStoreOpener->Start();
+	}
+	if (IsFailed(res)) {
+		delete __pStoreOpener;
+		__pStoreOpener = null;
+	}
+	return res;
+}
+
+void MainForm::OnStoreOpened(void) {
+	//opener posts its last event right before returning, so this doesn't wait
+	__pStoreOpener->Join();
+	result res = __pStoreOpener->GetResult();
+	CachingNotesManager *pManager = __pStoreOpener->DetachManagerN();
+	String path = __pStoreOpener->GetPath();
+	delete __pStoreOpener;
+	__pStoreOpener = null;
+
+	HideStoreProgress();
+
+	int storeId = -1;
+	if (pManager) {
+		res = __pStores->Attach(pManager, storeId);
+		if (IsFailed(res)) {
+			AppLogException("Failed to mount opened store, error: [%s]", GetErrorMessage(res));
+		}
+	}
+
+	//shown notes belong to the store which is about to go away
+	__pShownNotes->RemoveAll();
+	__notesCursor.Reset();
+
+	if (storeId >= 0 && __storeId >= 0 && storeId != __storeId) {
+		//whatever was changed in the old store meanwhile is written out before it goes away
+		res = __pStores->Unmount(__storeId);
+		if (IsFailed(res)) {
+			AppLogException("Failed to close current store, keeping it. Error: [%s]", GetErrorMessage(res));
+			__pStores->Unmount(storeId);
+			storeId = -1;
+		}
+	}
+	if (storeId < 0) {
+		ShowMessageBox(GetString(STR_MAINFORM_STORE_OPEN_FAILED_TITLE), GetString(STR_MAINFORM_STORE_OPEN_FAILED_MSG), MSGBOX_STYLE_OK);
+
+		res = LoadNotes();
+		if (IsFailed(res)) {
+			AppLogException("Failed to fill notes list, error: [%s]", GetErrorMessage(res));
+		}
+		return;
+	}
+	__storeId = storeId;
+
+	AppRegistry *appReg = Application::GetInstance()->GetAppRegistry();
+	res = appReg->Set(L"ALLNOTES_STORAGE_FILE", path);
+	if (IsFailed(res)) {
+		AppLogException("Failed to save storage file path to registry, error: [%s]", GetErrorMessage(res));
+	}
+	appReg->Save();
+
+	res = LoadNotes();
+	if (IsFailed(res)) {
+		AppLogException("Failed to fill notes list, error: [%s]", GetErrorMessage(res));
+	}
+}
+
+result MainForm::ShowStoreProgress(void) {
+	__pStorePopup = new Popup;
+	result res = __pStorePopup->Construct(true, Dimension(440, 260));
+	if (IsFailed(res)) {
+		AppLogException("Failed to construct storage progress popup, error: [%s]", GetErrorMessage(res));
+
+		delete __pStorePopup;
+		__pStorePopup = null;
+		return res;
+	}
+	__pStorePopup->SetTitleText(GetString(STR_MAINFORM_STORE_OPENING_TITLE));
+
+	Label *pLabel = new Label;
+	res = pLabel->Construct(Rectangle(10, 10, 400, 60), GetString(STR_MAINFORM_STORE_OPENING_MSG));
+	if (!IsFailed(res)) {
+		res = __pStorePopup->AddControl(*pLabel);
+	} else {
+		delete pLabel;
+	}
+
+	__pStoreProgress = new Progress;
+	if (!IsFailed(res)) {
+		res = __pStoreProgress->Construct(Rectangle(10, 80, 400, 60), 0, 100);
+	}
+	if (!IsFailed(res)) {
+		res = __pStorePopup->AddControl(*__pStoreProgress);
+	}
+	if (IsFailed(res)) {
+		AppLogException("Failed to construct storage progress controls, error: [%s]", GetErrorMessage(res));
+
+		if (__pStoreProgress->GetParent() == null) delete __pStoreProgress;
+		__pStoreProgress = null;
+		delete __pStorePopup;
+		__pStorePopup = null;
+		return res;
+	}
+
+	res = __pStorePopup->SetShowState(true);
+	if (IsFailed(res)) {
+		AppLogException("Failed to set show state for popup, error: [%s]", GetErrorMessage(res));
+		return res;
+	}
+	return __pStorePopup->Show();
+}
+
+void MainForm::HideStoreProgress(void) {
+	if (__pStorePopup) {
+		__pStorePopup->SetShowState(false);
+		delete __pStorePopup;
+		__pStorePopup = null;
+		__pStoreProgress = null;
+
+		RefreshForm();
+	}
+}
+
+result MainForm::OnOptionDiagnosticsClicked(const Control &src) {
+	String path = L"/Home/metrics.txt";
+	result res = Metrics::DumpToFile(path);
+
+	String msg = Metrics::FormatReport();
+	msg.Append(L"\n");
+	if (IsFailed(res)) {
+		msg.Append(GetString(STR_MAINFORM_DIAGNOSTICS_DUMP_FAILED));
+	} else {
+		msg.Append(GetString(STR_MAINFORM_DIAGNOSTICS_DUMP_SAVED));
+		msg.Append(path);
+	}
+
+	ShowMessageBox(GetString(STR_MAINFORM_DIAGNOSTICS_TITLE), msg, MSGBOX_STYLE_OK);
+	return res;
+}
+
 result MainForm::OnTabAllClicked(const Control &src) {
 	if (__currentTab != NOTE_TYPE_ALL) {
 		__currentTab = NOTE_TYPE_ALL;
@@ -364,34 +619,55 @@ result MainForm::OnLeftSoftkeyClicked(const Control &src) {
 }
 
 result MainForm::OnRightSoftkeyClicked(const Control &src) {
-	TextNoteForm *pNoteForm = new TextNoteForm(CALLBACK(ID_CREATE_TEXT_NOTE));
-	result res = pNoteForm->Construct();
-	if (IsFailed(res)) {
-		AppLogException("Failed to construct text note creation form, error: [%s]", GetErrorMessage(res));
-		delete pNoteForm;
-		return res;
+	return OpenTextNoteForm(ID_CREATE_TEXT_NOTE, null);
+}
+
+result MainForm::OpenTextNoteForm(int taskId, Note *pNote) {
+	MetricsTimer timer(METRIC_EDITOR_OPEN_COLD);
+
+	TextNoteForm *pNoteForm = static_cast<TextNoteForm *>(FormManager::TakePooledForm(IDF_TEXTNOTE_FORM));
+	bool pooled = pNoteForm != null;
+
+	result res = E_SUCCESS;
+	if (pooled) {
+		timer.SetHistogram(METRIC_EDITOR_OPEN_WARM);
+
+		res = pNoteForm->Reset(CALLBACK(taskId), pNote);
+		if (IsFailed(res)) {
+			AppLogException("Failed to reset pooled text note form, error: [%s]", GetErrorMessage(res));
+			return res;
+		}
+	} else {
+		pNoteForm = new TextNoteForm(CALLBACK(taskId), pNote);
+		res = pNoteForm->Construct();
+		if (IsFailed(res)) {
+			AppLogException("Failed to construct text note form, error: [%s]", GetErrorMessage(res));
+			delete pNoteForm;
+			return res;
+		}
 	}
 
 	res = FormManager::SetActiveForm(pNoteForm);
 	if (IsFailed(res)) {
-		AppLogException("Failed to switch to text note creation form, error: [%s]", GetErrorMessage(res));
-		delete pNoteForm;
+		AppLogException("Failed to switch to text note form, error: [%s]", GetErrorMessage(res));
+		//pooled form still belongs to the frame
+		if (!pooled) delete pNoteForm;
 	}
 
 	return res;
 }
 
 result MainForm::Initialize() {
-	__pOptionMenu->AddItem(GetString(L"MAINFORM_OPTIONMENU_SORT_BY"), 1);
-	__pOptionMenu->AddItem(GetString(L"MAINFORM_OPTIONMENU_SEARCH_BY"), 2);
-	__pOptionMenu->AddItem(GetString(L"MAINFORM_OPTIONMENU_SOURCE"), ID_OPTION_CHANGE_STORAGE);
-	__pOptionMenu->AddSubItem(0, GetString(L"MAINFORM_OPTIONMENU_SORT_BY_TITLE"), ID_OPTION_SORT_BY_TITLE_CLICKED);
-	__pOptionMenu->AddSubItem(0, GetString(L"MAINFORM_OPTIONMENU_SORT_BY_DATE"), ID_OPTION_SORT_BY_DATE_CLICKED);
-	__pOptionMenu->AddSubItem(0, GetString(L"MAINFORM_OPTIONMENU_SORT_BY_TYPE"), ID_OPTION_SORT_BY_TYPE_CLICKED);
-	__pOptionMenu->AddSubItem(1, GetString(L"MAINFORM_OPTIONMENU_SEARCH_BY_TITLE"), ID_OPTION_SEARCH_BY_TITLE_CLICKED);
-	__pOptionMenu->AddSubItem(1, GetString(L"MAINFORM_OPTIONMENU_SEARCH_BY_TEXT"), ID_OPTION_SEARCH_BY_TEXT_CLICKED);
+	__pOptionMenu->AddItem(GetString(STR_MAINFORM_OPTIONMENU_SORT_BY), 1);
+	__pOptionMenu->AddItem(GetString(STR_MAINFORM_OPTIONMENU_SEARCH_BY), 2);
+	__pOptionMenu->AddItem(GetString(STR_MAINFORM_OPTIONMENU_SOURCE), ID_OPTION_CHANGE_STORAGE);
+	__pOptionMenu->AddSubItem(0, GetString(STR_MAINFORM_OPTIONMENU_SORT_BY_TITLE), ID_OPTION_SORT_BY_TITLE_CLICKED);
+	__pOptionMenu->AddSubItem(0, GetString(STR_MAINFORM_OPTIONMENU_SORT_BY_DATE), ID_OPTION_SORT_BY_DATE_CLICKED);
+	__pOptionMenu->AddSubItem(0, GetString(STR_MAINFORM_OPTIONMENU_SORT_BY_TYPE), ID_OPTION_SORT_BY_TYPE_CLICKED);
+	__pOptionMenu->AddSubItem(1, GetString(STR_MAINFORM_OPTIONMENU_SEARCH_BY_TITLE), ID_OPTION_SEARCH_BY_TITLE_CLICKED);
+	__pOptionMenu->AddSubItem(1, GetString(STR_MAINFORM_OPTIONMENU_SEARCH_BY_TEXT), ID_OPTION_SEARCH_BY_TEXT_CLICKED);
 
-	SetSoftkeyText(SOFTKEY_1, GetString(L"MAINFORM_SOFTKEY_ADD"));
+	SetSoftkeyText(SOFTKEY_1, GetString(STR_MAINFORM_SOFTKEY_ADD));
 
 	RegisterAction(ID_OPTION_KEY_CLICKED, HANDLER(MainForm::OnOptionKeyClicked));
 	RegisterAction(ID_OPTION_SORT_BY_DATE_CLICKED, HANDLER(MainForm::OnOptionSortByDateClicked));
@@ -400,12 +676,13 @@ result MainForm::Initialize() {
 	RegisterAction(ID_OPTION_SEARCH_BY_TITLE_CLICKED, HANDLER(MainForm::OnOptionSearchByTitleClicked));
 	RegisterAction(ID_OPTION_SEARCH_BY_TEXT_CLICKED, HANDLER(MainForm::OnOptionSearchByTextClicked));
 	RegisterAction(ID_OPTION_CHANGE_STORAGE, HANDLER(MainForm::OnOptionChangeStorageClicked));
+	RegisterAction(ID_OPTION_DIAGNOSTICS_CLICKED, HANDLER(MainForm::OnOptionDiagnosticsClicked));
 	__pOptionMenu->AddActionEventListener(*this);
 	SetOptionkeyActionId(ID_OPTION_KEY_CLICKED);
 	AddOptionkeyActionListener(*this);
 
-	__pSearchField->SetOverlayKeypadCommandButton(COMMAND_BUTTON_POSITION_RIGHT, GetString(L"MAINFORM_SEARCH_KEYPAD_CLEAR"), ID_OVERLAY_KEYPAD_CLEAR);
-	__pSearchField->SetOverlayKeypadCommandButton(COMMAND_BUTTON_POSITION_LEFT, GetString(L"MAINFORM_SEARCH_KEYPAD_SEARCH"), ID_OVERLAY_KEYPAD_SEARCH);
+	__pSearchField->SetOverlayKeypadCommandButton(COMMAND_BUTTON_POSITION_RIGHT, GetString(STR_MAINFORM_SEARCH_KEYPAD_CLEAR), ID_OVERLAY_KEYPAD_CLEAR);
+	__pSearchField->SetOverlayKeypadCommandButton(COMMAND_BUTTON_POSITION_LEFT, GetString(STR_MAINFORM_SEARCH_KEYPAD_SEARCH), ID_OVERLAY_KEYPAD_SEARCH);
 
 	RegisterAction(ID_OVERLAY_KEYPAD_SEARCH, HANDLER(MainForm::OnKeypadSearchClicked));
 	RegisterAction(ID_OVERLAY_KEYPAD_CLEAR, HANDLER(MainForm::OnKeypadClearClicked));
@@ -445,11 +722,11 @@ result MainForm::Initialize() {
 		L"MAINFORM_TAB_THIRD_INDEX",
 		L"MAINFORM_TAB_FOURTH_INDEX"
 	};
-	String strings[4] = {
-		"MAINFORM_TAB_TITLE_ALL",
-		"MAINFORM_TAB_TITLE_TEXT",
-		"MAINFORM_TAB_TITLE_PHOTO",
-		"MAINFORM_TAB_TITLE_AUDIO"
+	StringId strings[4] = {
+		STR_MAINFORM_TAB_TITLE_ALL,
+		STR_MAINFORM_TAB_TITLE_TEXT,
+		STR_MAINFORM_TAB_TITLE_PHOTO,
+		STR_MAINFORM_TAB_TITLE_AUDIO
 	};
 	Bitmap *bitmaps[4] = {
 		null,
@@ -520,10 +797,22 @@ result MainForm::Initialize() {
 	}
 	__currentFilterMode = (FilterType)filter_mode;
 
-	String sGuide = GetString(L"MAINFORM_SEARCH_FIELD_GUIDE");
-	sGuide.Append(__currentFilterMode == FILTER_BY_TITLE ? GetString(L"MAINFORM_SEARCH_FIELD_GUIDE_BY_TITLE") : GetString(L"MAINFORM_SEARCH_FIELD_GUIDE_BY_TEXT"));
+	String sGuide = GetString(STR_MAINFORM_SEARCH_FIELD_GUIDE);
+	sGuide.Append(__currentFilterMode == FILTER_BY_TITLE ? GetString(STR_MAINFORM_SEARCH_FIELD_GUIDE_BY_TITLE) : GetString(STR_MAINFORM_SEARCH_FIELD_GUIDE_BY_TEXT));
 	__pSearchField->SetGuideText(sGuide);
 
+	String backupRoot = L"/Home/Backup/";
+	res = appReg->Get(L"ALLNOTES_BACKUP_DIR", backupRoot);
+	if (IsFailed(res)) {
+		res = appReg->Add(L"ALLNOTES_BACKUP_DIR", backupRoot);
+		if (IsFailed(res)) {
+			AppLogException("Failed to add registry key for storing backup directory, using default, error [%s]", GetErrorMessage(res));
+		}
+	}
+	//every store mounted from now on is backed up there
+	__pStores->Construct(backupRoot);
+	__backupRoot = backupRoot;
+
 	//+TBR
 	String dataPath = L"/Home/notes.bin";
 	res = appReg->Get(L"ALLNOTES_STORAGE_FILE", dataPath);
@@ -533,9 +822,24 @@ result MainForm::Initialize() {
 			AppLogException("Failed to add registry key for storing storage file path, using default, error [%s]", GetErrorMessage(res));
 		}
 	}
-	__pNotesManager->Construct(dataPath);
+	res = __pStores->Mount(dataPath, __storeId);
+	if (IsFailed(res)) {
+		AppLogException("Failed to open storage file [%S], error [%s]", dataPath.GetPointer(), GetErrorMessage(res));
+	}
 	//-TBR
 
+	//list works without thumbnails, photo notes just keep the generic icon
+	__pThumbnails = new ThumbnailCache;
+	res = __pThumbnails->Construct(L"/Home/Thumbnails/", THUMBNAIL_SIZE, ThumbnailCache::DEFAULT_MAX_ENTRIES, this);
+	if (!IsFailed(res)) {
+		res = __pThumbnails->Start();
+	}
+	if (IsFailed(res)) {
+		AppLogException("Failed to start thumbnail decoder, error [%s]", GetErrorMessage(res));
+		delete __pThumbnails;
+		__pThumbnails = null;
+	}
+
 	appReg->Save();
 
 	res = SwitchTab();
@@ -587,6 +891,57 @@ result MainForm::Terminate() {
 	return res;
 }
 
+void MainForm::OnLowMemory(void) {
+	if (__pStores) {
+		__pStores->ReleaseCachedResults();
+	}
+	if (__pThumbnails) {
+		__pThumbnails->Clear();
+	}
+}
+
+void MainForm::OnUserEventReceivedN(RequestId requestId, IList *pArgs) {
+	if (requestId == ThumbnailCache::THUMBNAIL_READY && pArgs && pArgs->GetCount() > 0) {
+		const String *pPath = static_cast<const String *>(pArgs->GetAt(0));
+
+		//only rows showing the decoded photo are rebuilt
+		bool changed = false;
+		for (int i = 0; i < __pShownNotes->GetCount(); i++) {
+			Note *pNote = null;
+			__pShownNotes->GetAt(i, pNote);
+			if (pNote->GetType() != NOTE_TYPE_PHOTO || pNote->GetMarked() || !pNote->GetResourcePath().Equals(*pPath, true)) {
+				continue;
+			}
+
+			CustomListItem *pItem = CreateNoteItemN(pNote);
+			if (pItem) {
+				__pNotesList->SetItemAt(__pNotesList->GetItemIndexFromItemId(i + 2), *pItem, i + 2);
+				changed = true;
+			}
+		}
+		if (changed) {
+			RefreshForm();
+		}
+	} else if (requestId == StoreOpener::STORE_OPEN_PROGRESS && pArgs && pArgs->GetCount() > 0) {
+		//popup is only shown once this form is back on screen, events are queued behind the switch from the dialog
+		if (!__pStorePopup) {
+			ShowStoreProgress();
+		}
+		if (__pStoreProgress) {
+			__pStoreProgress->SetValue(static_cast<const Integer *>(pArgs->GetAt(0))->ToInt());
+			__pStorePopup->Draw();
+			__pStorePopup->Show();
+		}
+	} else if (requestId == StoreOpener::STORE_OPENED && __pStoreOpener) {
+		OnStoreOpened();
+	}
+
+	if (pArgs) {
+		pArgs->RemoveAll(true);
+		delete pArgs;
+	}
+}
+
 void MainForm::DialogCallback(int taskId, BaseForm *sender, DialogResult ret, void *dataN) {
 	result res = E_SUCCESS;
 
@@ -595,9 +950,19 @@ void MainForm::DialogCallback(int taskId, BaseForm *sender, DialogResult ret, vo
 		pCbData = (Note*)dataN;
 	}
 
-	if (taskId == ID_CREATE_TEXT_NOTE && ret == DIALOG_RESULT_OK) {
+	if (taskId == ID_SELECT_STORAGE_FILE) {
+		if (ret == DIALOG_RESULT_OK && dataN) {
+			String *pPath = static_cast<String*>(dataN);
+			res = SwitchStorage(*pPath);
+			if (IsFailed(res)) {
+				AppLogException("Failed to start switching storage to [%S], error: [%s]", pPath->GetPointer(), GetErrorMessage(res));
+			}
+			delete pPath;
+		}
+		return;
+	} else if (taskId == ID_CREATE_TEXT_NOTE && ret == DIALOG_RESULT_OK) {
 		if (pCbData) {
-			res = __pNotesManager->AddNote(pCbData);
+			res = __pStores->AddNote(__storeId, pCbData);
 			if (IsFailed(res)) {
 				AppLogException("Failed to add created note to the database, error: [%s]", GetErrorMessage(res));
 				delete pCbData;
@@ -606,7 +971,7 @@ void MainForm::DialogCallback(int taskId, BaseForm *sender, DialogResult ret, vo
 		}
 	} else if (taskId == ID_EDIT_TEXT_NOTE && ret == DIALOG_RESULT_OK) {
 		if (pCbData) {
-			res = __pNotesManager->UpdateNote(pCbData);
+			res = __pStores->UpdateNote(pCbData);
 			if (IsFailed(res)) {
 				AppLogException("Failed to update note in the database, error: [%s]", GetErrorMessage(res));
 				delete pCbData;
@@ -631,22 +996,20 @@ void MainForm::OnItemStateChanged(const Control &source, int index, int itemId,
 		if (IsFailed(res)) {
 			AppLogException("Failed to load notes after switching sorting order, error: [%s]", GetErrorMessage(res));
 		}
+	} else if (itemId == ID_LIST_ITEM_SHOW_MORE) {
+		result res = LoadNextNotesPage();
+		if (IsFailed(res)) {
+			AppLogException("Failed to load next page of notes, error: [%s]", GetErrorMessage(res));
+		}
+		RefreshForm();
 	} else {
-		itemId = itemId - 2;
-		Note *pNote = __pNotesManager->GetNote(itemId);
-
-		TextNoteForm *pNoteForm = new TextNoteForm(CALLBACK(ID_EDIT_TEXT_NOTE), pNote);
-		result res = pNoteForm->Construct();
+		Note *pNote = null;
+		result res = __pShownNotes->GetAt(itemId - 2, pNote);
 		if (IsFailed(res)) {
-			AppLogException("Failed to construct text note creation form, error: [%s]", GetErrorMessage(res));
-			delete pNoteForm;
+			AppLogException("Failed to find note for list item [%d], error: [%s]", itemId, GetErrorMessage(res));
 			return;
 		}
 
-		res = FormManager::SetActiveForm(pNoteForm);
-		if (IsFailed(res)) {
-			AppLogException("Failed to switch to text note creation form, error: [%s]", GetErrorMessage(res));
-			delete pNoteForm;
-		}
+		OpenTextNoteForm(ID_EDIT_TEXT_NOTE, pNote);
 	}
 }
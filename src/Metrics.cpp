@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <FIo.h>
+#include <FSystem.h>
+
+#include "BufferedFileWriter.h"
+#include "Metrics.h"
+
+using namespace Osp::Io;
+using namespace Osp::System;
+
+static const char *COUNTER_NAMES[METRIC_COUNTER_COUNT] = {
+	"db_opens",
+	"statements_prepared",
+	"rows_read",
+	"text_bytes_loaded",
+	"cache_hits",
+	"cache_misses",
+	"result_set_hits",
+	"result_set_misses"
+};
+
+static const char *HISTOGRAM_NAMES[METRIC_HISTOGRAM_COUNT] = {
+	"flush_duration_ms",
+	"list_refresh_ms",
+	"editor_open_cold_ms",
+	"editor_open_warm_ms"
+};
+
+const int Metrics::BUCKET_BOUNDS[Metrics::HISTOGRAM_BUCKETS - 1] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000 };
+
+long long Metrics::__counters[METRIC_COUNTER_COUNT] = { 0 };
+Metrics::Histogram Metrics::__histograms[METRIC_HISTOGRAM_COUNT];
+Mutex *Metrics::__pLock = null;
+
+result Metrics::Initialize(void) {
+	if (__pLock) {
+		return E_SUCCESS;
+	}
+
+	Mutex *pLock = new Mutex;
+	result res = pLock->Create();
+	if (IsFailed(res)) {
+		AppLogException("Failed to create metrics lock, error: [%s]", GetErrorMessage(res));
+		delete pLock;
+		return res;
+	}
+
+	for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+		__counters[i] = 0;
+	}
+	for (int i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+		for (int j = 0; j < HISTOGRAM_BUCKETS; j++) {
+			__histograms[i].buckets[j] = 0;
+		}
+		__histograms[i].count = __histograms[i].sum = __histograms[i].max = 0;
+	}
+
+	__pLock = pLock;
+	return E_SUCCESS;
+}
+
+void Metrics::Shutdown(void) {
+	if (__pLock) {
+		delete __pLock;
+		__pLock = null;
+	}
+}
+
+void Metrics::Add(MetricCounter counter, long long value) {
+	//nothing is recorded until the lock exists, so counters never tear across threads
+	if (!__pLock || counter < 0 || counter >= METRIC_COUNTER_COUNT) {
+		return;
+	}
+
+	__pLock->Acquire();
+	__counters[counter] += value;
+	__pLock->Release();
+}
+
+void Metrics::Observe(MetricHistogram histogram, long long ms) {
+	if (!__pLock || histogram < 0 || histogram >= METRIC_HISTOGRAM_COUNT) {
+		return;
+	}
+
+	int bucket = 0;
+	while (bucket < HISTOGRAM_BUCKETS - 1 && ms > BUCKET_BOUNDS[bucket]) {
+		bucket++;
+	}
+
+	__pLock->Acquire();
+	Histogram &h = __histograms[histogram];
+	h.buckets[bucket]++;
+	h.count++;
+	h.sum += ms;
+	if (ms > h.max) {
+		h.max = ms;
+	}
+	__pLock->Release();
+}
+
+long long Metrics::GetCounter(MetricCounter counter) {
+	if (!__pLock || counter < 0 || counter >= METRIC_COUNTER_COUNT) {
+		return 0;
+	}
+
+	__pLock->Acquire();
+	long long value = __counters[counter];
+	__pLock->Release();
+
+	return value;
+}
+
+String Metrics::FormatReport(void) {
+	String report;
+	if (!__pLock) {
+		return report;
+	}
+
+	//snapshot first, string building allocates and shouldn't block other threads
+	long long counters[METRIC_COUNTER_COUNT];
+	Histogram histograms[METRIC_HISTOGRAM_COUNT];
+
+	__pLock->Acquire();
+	for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+		counters[i] = __counters[i];
+	}
+	for (int i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+		histograms[i] = __histograms[i];
+	}
+	__pLock->Release();
+
+	for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+		report.Append(String(COUNTER_NAMES[i]));
+		report.Append(L": ");
+		report.Append(counters[i]);
+		report.Append(L"\n");
+	}
+
+	long long hits = counters[METRIC_CACHE_HITS];
+	long long lookups = hits + counters[METRIC_CACHE_MISSES];
+	if (lookups > 0) {
+		report.Append(L"cache_hit_rate: ");
+		report.Append((int)(hits * 100 / lookups));
+		report.Append(L"%\n");
+	}
+
+	for (int i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+		const Histogram &h = histograms[i];
+
+		report.Append(String(HISTOGRAM_NAMES[i]));
+		report.Append(L": count ");
+		report.Append(h.count);
+		report.Append(L", avg ");
+		report.Append(h.count > 0 ? h.sum / h.count : 0);
+		report.Append(L", max ");
+		report.Append(h.max);
+		report.Append(L"\n");
+
+		for (int j = 0; j < HISTOGRAM_BUCKETS; j++) {
+			if (h.buckets[j] == 0) {
+				continue;
+			}
+			report.Append(L"  ");
+			if (j < HISTOGRAM_BUCKETS - 1) {
+				report.Append(L"<= ");
+				report.Append(BUCKET_BOUNDS[j]);
+			} else {
+				report.Append(L"> ");
+				report.Append(BUCKET_BOUNDS[HISTOGRAM_BUCKETS - 2]);
+			}
+			report.Append(L": ");
+			report.Append(h.buckets[j]);
+			report.Append(L"\n");
+		}
+	}
+
+	return report;
+}
+
+result Metrics::DumpToFile(const String &path) {
+	if (!__pLock) {
+		AppLogException("Attempt to dump metrics when they weren't initialized");
+		return E_INVALID_STATE;
+	}
+
+	BufferedFileWriter writer;
+	result res = writer.Construct(path);
+	if (IsFailed(res)) {
+		AppLogException("Failed to open metrics dump file [%S], error: [%s]", path.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	res = writer.WriteUtf8(FormatReport());
+	if (!IsFailed(res)) {
+		res = writer.Flush(true);
+	}
+	writer.Close();
+
+	if (IsFailed(res)) {
+		AppLogException("Failed to write metrics dump, error: [%s]", GetErrorMessage(res));
+	}
+	return res;
+}
+
+MetricsTimer::MetricsTimer(MetricHistogram histogram) {
+	__histogram = histogram;
+	SystemTime::GetTicks(__start);
+}
+
+MetricsTimer::~MetricsTimer(void) {
+	long long end = 0;
+	SystemTime::GetTicks(end);
+	Metrics::Observe(__histogram, end - __start);
+}
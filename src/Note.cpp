@@ -29,6 +29,14 @@ Note::Note(void) {
 	__text = L"";
 	__title = L"";
 	__resPath = L"";
+	__audioDuration = -1;
+	__storeId = -1;
+
+	__pTitleKey = null;
+}
+
+Note::~Note(void) {
+	if (__pTitleKey) delete __pTitleKey;
 }
 
 result Note::Construct(NoteType type) {
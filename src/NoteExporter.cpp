@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "NoteExporter.h"
+
+NoteExporter::NoteExporter(void) {
+	__dataPath = L"";
+	__destPath = L"";
+	__format = EXPORT_FORMAT_JSON_LINES;
+	__pListener = null;
+	__canceled = false;
+}
+
+NoteExporter::~NoteExporter(void) {
+}
+
+result NoteExporter::Construct(const String &dataPath, ExportFormat format, const String &destPath, IExportProgressListener *pListener) {
+	__dataPath = dataPath;
+	__destPath = destPath;
+	__format = format;
+	__pListener = pListener;
+
+	return Thread::Construct(THREAD_TYPE_WORKER);
+}
+
+Object *NoteExporter::Run(void) {
+	result res = Export();
+	if (__pListener) {
+		__pListener->OnExportFinished(res);
+	}
+	return null;
+}
+
+result NoteExporter::Export(void) {
+	__canceled = false;
+
+	Database *pDb = new Database;
+	result res = pDb->Construct(__dataPath, false);
+	if (IsFailed(res)) {
+		AppLogException("Failed to load database file at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pDb;
+		return res;
+	}
+
+	int total = 0;
+	DbEnumerator *pEnum = pDb->QueryN(L"SELECT COUNT(*) FROM entries"); res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to query database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pDb;
+		return res;
+	}
+	if (pEnum) {
+		if (!IsFailed(pEnum->MoveNext())) {
+			pEnum->GetIntAt(0, total);
+		}
+		delete pEnum;
+	}
+
+	pEnum = pDb->QueryN(L"SELECT entries.entry_id,entries.type,entries.timestamp,entries.marked,entries.title,entries.text, CASE "
+		"WHEN (entries.type = 2) OR (entries.type = 3) THEN (SELECT res_path FROM resource_entries WHERE resource_entries.entry_id = entries.entry_id) "
+		"ELSE '' "
+		"END FROM entries ORDER BY entries.entry_id");
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to query database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pDb;
+		return res;
+	}
+
+	if (__format == EXPORT_FORMAT_JSON_LINES) {
+		res = ExportJsonLines(pEnum, total);
+	} else {
+		res = ExportTextFolder(pEnum, total);
+	}
+
+	if (pEnum) delete pEnum;
+	delete pDb;
+
+	return res;
+}
+
+result NoteExporter::ExportJsonLines(DbEnumerator *pEnum, int total) {
+	BufferedFileWriter writer;
+	result res = writer.Construct(__destPath);
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	//row values are read into the same objects every time, nothing accumulates between rows
+	int entry_id = -1;
+	int type = -1;
+	long long timestamp = 0;
+	int marked = 0;
+	String title;
+	String text;
+	String res_path;
+
+	int exported = 0;
+	while (pEnum && !IsFailed(pEnum->MoveNext())) {
+		if (__canceled) {
+			writer.Close();
+			File::Remove(__destPath);
+			return E_OPERATION_CANCELED;
+		}
+
+		result gres[6];
+		gres[0] = pEnum->GetIntAt(0, entry_id);
+		gres[1] = pEnum->GetIntAt(1, type);
+		gres[2] = pEnum->GetInt64At(2, timestamp);
+		gres[3] = pEnum->GetIntAt(3, marked);
+		gres[4] = pEnum->GetStringAt(4, title);
+		gres[5] = pEnum->GetStringAt(5, text);
+
+		for(int i = 0; i < 6; i++) {
+			if (IsFailed(gres[i])) {
+				AppLogException("Failed to retrieve query data for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(gres[i]));
+				return gres[i];
+			}
+		}
+
+		res_path = L"";
+		if (type != NOTE_TYPE_TEXT) {
+			pEnum->GetStringAt(6, res_path);
+		}
+
+		writer.WriteUtf8(L"{\"id\":", 6);
+		WriteNumber(writer, entry_id);
+		writer.WriteUtf8(L",\"type\":", 8);
+		WriteNumber(writer, type);
+		writer.WriteUtf8(L",\"timestamp\":", 13);
+		WriteNumber(writer, timestamp);
+		if (marked) {
+			writer.WriteUtf8(L",\"marked\":true", 14);
+		} else {
+			writer.WriteUtf8(L",\"marked\":false", 15);
+		}
+		writer.WriteUtf8(L",\"title\":", 9);
+		WriteJsonString(writer, title);
+		writer.WriteUtf8(L",\"text\":", 8);
+		WriteJsonString(writer, text);
+		if (!res_path.IsEmpty()) {
+			writer.WriteUtf8(L",\"res_path\":", 12);
+			WriteJsonString(writer, res_path);
+		}
+		res = writer.WriteUtf8(L"}\n", 2);
+		//writer only fails on file errors, which stick, so it is enough to check the last write
+		if (IsFailed(res)) {
+			AppLogException("Failed to write exported note to [%S], error: [%s]", __destPath.GetPointer(), GetErrorMessage(res));
+			return res;
+		}
+
+		exported++;
+		if (__pListener && (exported % PROGRESS_STEP) == 0) {
+			__pListener->OnExportProgress(exported, total);
+		}
+	}
+
+	res = writer.Flush(true);
+	if (IsFailed(res)) {
+		return res;
+	}
+	if (__pListener) {
+		__pListener->OnExportProgress(exported, total);
+	}
+	return writer.Close();
+}
+
+result NoteExporter::ExportTextFolder(DbEnumerator *pEnum, int total) {
+	String dir = __destPath;
+	if (!dir.EndsWith(L"/")) {
+		dir.Append('/');
+	}
+
+	result res = Directory::Create(dir, true);
+	if (IsFailed(res) && res != E_FILE_ALREADY_EXIST) {
+		AppLogException("Failed to create export directory [%S], error: [%s]", dir.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	int entry_id = -1;
+	int type = -1;
+	String title;
+	String text;
+	String res_path;
+	String file_path;
+
+	int exported = 0;
+	while (pEnum && !IsFailed(pEnum->MoveNext())) {
+		if (__canceled) {
+			return E_OPERATION_CANCELED;
+		}
+
+		result gres[4];
+		gres[0] = pEnum->GetIntAt(0, entry_id);
+		gres[1] = pEnum->GetIntAt(1, type);
+		gres[2] = pEnum->GetStringAt(4, title);
+		gres[3] = pEnum->GetStringAt(5, text);
+
+		for(int i = 0; i < 4; i++) {
+			if (IsFailed(gres[i])) {
+				AppLogException("Failed to retrieve query data for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(gres[i]));
+				return gres[i];
+			}
+		}
+
+		//file names are entry IDs, since titles are neither unique nor file system safe
+		file_path = dir;
+		file_path.Append(entry_id);
+		file_path.Append(L".txt");
+
+		BufferedFileWriter writer;
+		res = writer.Construct(file_path, false, 4 * 1024);
+		if (IsFailed(res)) {
+			return res;
+		}
+
+		writer.WriteUtf8(title);
+		writer.WriteUtf8(L"\n\n", 2);
+		writer.WriteUtf8(text);
+		if (type != NOTE_TYPE_TEXT && !IsFailed(pEnum->GetStringAt(6, res_path)) && !res_path.IsEmpty()) {
+			writer.WriteUtf8(L"\n\n", 2);
+			writer.WriteUtf8(res_path);
+		}
+		res = writer.Close();
+		if (IsFailed(res)) {
+			AppLogException("Failed to write exported note to [%S], error: [%s]", file_path.GetPointer(), GetErrorMessage(res));
+			return res;
+		}
+
+		exported++;
+		if (__pListener && (exported % PROGRESS_STEP) == 0) {
+			__pListener->OnExportProgress(exported, total);
+		}
+	}
+
+	if (__pListener) {
+		__pListener->OnExportProgress(exported, total);
+	}
+	return E_SUCCESS;
+}
+
+result NoteExporter::WriteJsonString(BufferedFileWriter &writer, const String &str) {
+	static const char hex[] = "0123456789abcdef";
+
+	result res = writer.WriteByte('"');
+
+	const mchar *pStr = str.GetPointer();
+	int len = str.GetLength();
+	int run_start = 0;
+
+	//unescaped runs are passed to the writer as a whole
+	for (int i = 0; i < len; i++) {
+		mchar ch = pStr[i];
+		if (ch != '"' && ch != '\\' && ch >= 0x20) {
+			continue;
+		}
+
+		writer.WriteUtf8(pStr + run_start, i - run_start);
+		run_start = i + 1;
+
+		writer.WriteByte('\\');
+		if (ch == '"' || ch == '\\') {
+			writer.WriteByte((byte)ch);
+		} else if (ch == '\n') {
+			writer.WriteByte('n');
+		} else if (ch == '\r') {
+			writer.WriteByte('r');
+		} else if (ch == '\t') {
+			writer.WriteByte('t');
+		} else {
+			byte esc[5] = { 'u', '0', '0', (byte)hex[(ch >> 4) & 0xF], (byte)hex[ch & 0xF] };
+			writer.Write(esc, 5);
+		}
+	}
+	writer.WriteUtf8(pStr + run_start, len - run_start);
+
+	res = writer.WriteByte('"');
+	return res;
+}
+
+result NoteExporter::WriteNumber(BufferedFileWriter &writer, long long val) {
+	char buf[24];
+	int pos = sizeof(buf);
+
+	bool negative = val < 0;
+	unsigned long long uval = negative ? (unsigned long long)(-(val + 1)) + 1 : (unsigned long long)val;
+	do {
+		buf[--pos] = (char)('0' + (uval % 10));
+		uval /= 10;
+	} while (uval > 0);
+
+	if (negative) {
+		buf[--pos] = '-';
+	}
+	return writer.Write(buf + pos, sizeof(buf) - pos);
+}
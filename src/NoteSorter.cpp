@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <string.h>
+
+#include "NoteSorter.h"
+
+using namespace Osp::Base::Runtime;
+
+class SortWorker: public Thread {
+public:
+	SortWorker(void) {
+		__pKeys = __pTemp = null;
+		__count = 0;
+		__sorting = SORT_BY_DATE;
+		__asc = false;
+	}
+
+	result Construct(NoteSortKey *pKeys, NoteSortKey *pTemp, int count, SortType sorting, bool ascending) {
+		__pKeys = pKeys;
+		__pTemp = pTemp;
+		__count = count;
+		__sorting = sorting;
+		__asc = ascending;
+		return Thread::Construct(THREAD_TYPE_WORKER);
+	}
+
+	virtual Object *Run(void) {
+		NoteSorter::SortSequential(__pKeys, __pTemp, __count, __sorting, __asc);
+		return null;
+	}
+
+private:
+	NoteSortKey *__pKeys;
+	NoteSortKey *__pTemp;
+	int __count;
+	SortType __sorting;
+	bool __asc;
+};
+
+static inline unsigned long long GetRadixKey(const NoteSortKey &key, bool ascending) {
+	//flipping sign bit makes signed order match unsigned byte order
+	unsigned long long k = (unsigned long long)key.primary ^ 0x8000000000000000ULL;
+	return ascending ? k : ~k;
+}
+
+//stable pass putting marked notes first; returns the buffer that holds the result
+static NoteSortKey *PartitionMarked(NoteSortKey *pSrc, NoteSortKey *pDst, int count) {
+	int marked = 0;
+	for (int i = 0; i < count; i++) {
+		if (pSrc[i].marked) {
+			marked++;
+		}
+	}
+	if (marked == 0 || marked == count) {
+		return pSrc;
+	}
+
+	int pos[2] = { 0, marked };
+	for (int i = 0; i < count; i++) {
+		pDst[pos[pSrc[i].marked ? 0 : 1]++] = pSrc[i];
+	}
+	return pDst;
+}
+
+void NoteSorter::RadixSortByDate(NoteSortKey *pKeys, NoteSortKey *pTemp, int count, bool ascending) {
+	if (count < RADIX_THRESHOLD) {
+		std::stable_sort(pKeys, pKeys + count, NoteSortKeyLess(false, ascending));
+		return;
+	}
+
+	//all histograms are gathered in one scan, so bytes shared by every key cost no pass at all
+	int counts[8][256];
+	memset(counts, 0, sizeof(counts));
+	for (int i = 0; i < count; i++) {
+		unsigned long long k = GetRadixKey(pKeys[i], ascending);
+		for (int b = 0; b < 8; b++) {
+			counts[b][(k >> (b * 8)) & 0xFF]++;
+		}
+	}
+
+	NoteSortKey *pSrc = pKeys;
+	NoteSortKey *pDst = pTemp;
+	for (int b = 0; b < 8; b++) {
+		int shift = b * 8;
+		int *pCounts = counts[b];
+		if (pCounts[(GetRadixKey(pSrc[0], ascending) >> shift) & 0xFF] == count) {
+			continue;
+		}
+
+		int offsets[256];
+		int sum = 0;
+		for (int i = 0; i < 256; i++) {
+			offsets[i] = sum;
+			sum += pCounts[i];
+		}
+		for (int i = 0; i < count; i++) {
+			pDst[offsets[(GetRadixKey(pSrc[i], ascending) >> shift) & 0xFF]++] = pSrc[i];
+		}
+
+		NoteSortKey *pTmp = pSrc;
+		pSrc = pDst;
+		pDst = pTmp;
+	}
+
+	//marked flag is the most significant digit, so it goes last
+	NoteSortKey *pResult = PartitionMarked(pSrc, pDst, count);
+	if (pResult != pKeys) {
+		memcpy(pKeys, pResult, count * sizeof(NoteSortKey));
+	}
+}
+
+void NoteSorter::CountingSortByType(NoteSortKey *pKeys, NoteSortKey *pTemp, int count, bool ascending) {
+	//one bucket per (marked, type) pair, types are small enough to need just one pass
+	const int TYPE_SLOTS = 8;
+
+	int counts[TYPE_SLOTS * 2];
+	memset(counts, 0, sizeof(counts));
+
+	for (int i = 0; i < count; i++) {
+		int type = (int)pKeys[i].primary & (TYPE_SLOTS - 1);
+		int slot = (pKeys[i].marked ? 0 : TYPE_SLOTS) + (ascending ? type : TYPE_SLOTS - 1 - type);
+		counts[slot]++;
+	}
+
+	int offsets[TYPE_SLOTS * 2];
+	int sum = 0;
+	for (int i = 0; i < TYPE_SLOTS * 2; i++) {
+		offsets[i] = sum;
+		sum += counts[i];
+	}
+
+	for (int i = 0; i < count; i++) {
+		int type = (int)pKeys[i].primary & (TYPE_SLOTS - 1);
+		int slot = (pKeys[i].marked ? 0 : TYPE_SLOTS) + (ascending ? type : TYPE_SLOTS - 1 - type);
+		pTemp[offsets[slot]++] = pKeys[i];
+	}
+	memcpy(pKeys, pTemp, count * sizeof(NoteSortKey));
+}
+
+void NoteSorter::SortSequential(NoteSortKey *pKeys, NoteSortKey *pTemp, int count, SortType sorting, bool ascending) {
+	if (count < 2) {
+		return;
+	}
+
+	if (sorting == SORT_BY_DATE) {
+		RadixSortByDate(pKeys, pTemp, count, ascending);
+	} else if (sorting == SORT_BY_TYPE) {
+		CountingSortByType(pKeys, pTemp, count, ascending);
+	} else {
+		std::stable_sort(pKeys, pKeys + count, NoteSortKeyLess(true, ascending));
+	}
+}
+
+result NoteSorter::SortParallel(NoteSortKey *pKeys, NoteSortKey *pTemp, int count, SortType sorting, bool ascending, int workers) {
+	if (workers < 2 || count < workers * 2) {
+		SortSequential(pKeys, pTemp, count, sorting, ascending);
+		return E_SUCCESS;
+	}
+
+	int chunk = (count + workers - 1) / workers;
+	SortWorker **ppWorkers = new SortWorker *[workers];
+
+	//calling thread takes the first chunk itself
+	ppWorkers[0] = null;
+	for (int w = 1; w < workers; w++) {
+		int start = w * chunk;
+		int length = start < count ? (count - start < chunk ? count - start : chunk) : 0;
+
+		ppWorkers[w] = new SortWorker;
+		result res = ppWorkers[w]->Construct(pKeys + start, pTemp + start, length, sorting, ascending);
+		if (!IsFailed(res)) {
+			res = ppWorkers[w]->Start();
+		}
+		if (IsFailed(res)) {
+			AppLogException("Failed to start sort worker, sorting its chunk in place. Error: [%s]", GetErrorMessage(res));
+
+			delete ppWorkers[w];
+			ppWorkers[w] = null;
+			SortSequential(pKeys + start, pTemp + start, length, sorting, ascending);
+		}
+	}
+
+	SortSequential(pKeys, pTemp, chunk < count ? chunk : count, sorting, ascending);
+
+	for (int w = 1; w < workers; w++) {
+		if (ppWorkers[w]) {
+			ppWorkers[w]->Join();
+			delete ppWorkers[w];
+		}
+	}
+	delete[] ppWorkers;
+
+	//merge neighbouring runs pairwise, alternating between the two buffers
+	NoteSortKeyLess less(sorting == SORT_BY_TITLE, ascending);
+	NoteSortKey *pSrc = pKeys;
+	NoteSortKey *pDst = pTemp;
+	for (int width = chunk; width < count; width *= 2) {
+		for (int lo = 0; lo < count; lo += 2 * width) {
+			int mid = lo + width < count ? lo + width : count;
+			int hi = lo + 2 * width < count ? lo + 2 * width : count;
+			std::merge(pSrc + lo, pSrc + mid, pSrc + mid, pSrc + hi, pDst + lo, less);
+		}
+
+		NoteSortKey *pTmp = pSrc;
+		pSrc = pDst;
+		pDst = pTmp;
+	}
+
+	if (pSrc != pKeys) {
+		memcpy(pKeys, pSrc, count * sizeof(NoteSortKey));
+	}
+	return E_SUCCESS;
+}
+
+void NoteSorter::MergeRuns(const NoteSortKey *const *ppRuns, const int *pCounts, int runs, NoteSortKey *pDst, SortType sorting, bool ascending) {
+	if (runs > MAX_MERGE_RUNS) {
+		runs = MAX_MERGE_RUNS;
+	}
+
+	int heads[MAX_MERGE_RUNS];
+	for (int r = 0; r < runs; r++) {
+		heads[r] = 0;
+	}
+
+	//there are only a handful of runs, so picking the smallest head by a linear scan beats a heap
+	NoteSortKeyLess less(sorting == SORT_BY_TITLE, ascending);
+	int out = 0;
+	while (true) {
+		int best = -1;
+		for (int r = 0; r < runs; r++) {
+			if (heads[r] >= pCounts[r]) {
+				continue;
+			}
+			if (best < 0 || less(ppRuns[r][heads[r]], ppRuns[best][heads[best]])) {
+				best = r;
+			}
+		}
+		if (best < 0) {
+			break;
+		}
+		pDst[out++] = ppRuns[best][heads[best]++];
+	}
+}
+
+result NoteSorter::Sort(NoteSortKey *pKeys, NoteSortKey *pTemp, int count, SortType sorting, bool ascending) {
+	if (count >= PARALLEL_THRESHOLD) {
+		return SortParallel(pKeys, pTemp, count, sorting, ascending, PARALLEL_WORKERS);
+	}
+
+	SortSequential(pKeys, pTemp, count, sorting, ascending);
+	return E_SUCCESS;
+}
@@ -0,0 +1,433 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <FText.h>
+#include <string.h>
+
+#include "BufferedFileWriter.h"
+#include "NotesJournal.h"
+
+using namespace Osp::Text;
+
+NotesJournal::NotesJournal(void) {
+	__path = L"";
+	__pFile = null;
+	__pScratch = null;
+	__scratchSize = 0;
+	__nextTempId = 0;
+}
+
+NotesJournal::~NotesJournal(void) {
+	if (__pFile) delete __pFile;
+	if (__pScratch) delete[] __pScratch;
+}
+
+result NotesJournal::Construct(const String &dataPath) {
+	__path = dataPath;
+	__path.Append(L".journal");
+
+	__pFile = new File;
+	result res = __pFile->Construct(__path, L"a+");
+	if (IsFailed(res)) {
+		AppLogException("Failed to open journal file [%S], error: [%s]", __path.GetPointer(), GetErrorMessage(res));
+
+		delete __pFile;
+		__pFile = null;
+		return res;
+	}
+
+	return Grow(256);
+}
+
+result NotesJournal::Grow(int required) {
+	if (required <= __scratchSize) {
+		return E_SUCCESS;
+	}
+
+	int size = __scratchSize > 0 ? __scratchSize : 256;
+	while (size < required) {
+		size *= 2;
+	}
+
+	byte *pNew = new byte[size];
+	if (!pNew) {
+		return E_OUT_OF_MEMORY;
+	}
+	if (__pScratch) {
+		delete[] __pScratch;
+	}
+	__pScratch = pNew;
+	__scratchSize = size;
+
+	return E_SUCCESS;
+}
+
+int NotesJournal::GetKey(const Note *pNote) {
+	if (pNote->GetEntryId() >= 0) {
+		return pNote->GetEntryId() << 1;
+	}
+
+	std::map<const Note *, int>::iterator iter = __tempIds.find(pNote);
+	if (iter != __tempIds.end()) {
+		return (iter->second << 1) | 1;
+	}
+
+	int id = __nextTempId++;
+	__tempIds.insert(std::make_pair(pNote, id));
+	return (id << 1) | 1;
+}
+
+int NotesJournal::PutVarint(int pos, unsigned long long val) {
+	while (val >= 0x80) {
+		__pScratch[pos++] = (byte)(val | 0x80);
+		val >>= 7;
+	}
+	__pScratch[pos++] = (byte)val;
+	return pos;
+}
+
+int NotesJournal::PutString(int pos, const String &str) {
+	const mchar *pStr = str.GetPointer();
+	int len = str.GetLength();
+
+	pos = PutVarint(pos, (unsigned long long)BufferedFileWriter::GetUtf8Length(pStr, len));
+	for (int i = 0; i < len; i++) {
+		unsigned int cp = (unsigned int)pStr[i];
+		if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < len && pStr[i + 1] >= 0xDC00 && pStr[i + 1] <= 0xDFFF) {
+			cp = 0x10000 + ((cp - 0xD800) << 10) + ((unsigned int)pStr[++i] - 0xDC00);
+		}
+
+		if (cp < 0x80) {
+			__pScratch[pos++] = (byte)cp;
+		} else if (cp < 0x800) {
+			__pScratch[pos++] = (byte)(0xC0 | (cp >> 6));
+			__pScratch[pos++] = (byte)(0x80 | (cp & 0x3F));
+		} else if (cp < 0x10000) {
+			__pScratch[pos++] = (byte)(0xE0 | (cp >> 12));
+			__pScratch[pos++] = (byte)(0x80 | ((cp >> 6) & 0x3F));
+			__pScratch[pos++] = (byte)(0x80 | (cp & 0x3F));
+		} else {
+			__pScratch[pos++] = (byte)(0xF0 | (cp >> 18));
+			__pScratch[pos++] = (byte)(0x80 | ((cp >> 12) & 0x3F));
+			__pScratch[pos++] = (byte)(0x80 | ((cp >> 6) & 0x3F));
+			__pScratch[pos++] = (byte)(0x80 | (cp & 0x3F));
+		}
+	}
+	return pos;
+}
+
+result NotesJournal::Append(JournalOperation op, const Note *pNote) {
+	if (!__pFile) {
+		return E_INVALID_STATE;
+	}
+
+	//generous upper bound: 4 bytes per UTF-16 unit plus fixed fields
+	int max_size = 64 + (pNote->GetTitle().GetLength() + pNote->GetText().GetLength() + pNote->GetResourcePath().GetLength()) * 4;
+	result res = Grow(max_size);
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	//payload is encoded after room reserved for its length prefix, which is at most 5 bytes
+	const int header = 5;
+	int pos = header;
+	__pScratch[pos++] = (byte)op;
+	pos = PutVarint(pos, (unsigned long long)GetKey(pNote));
+
+	if (op != JOURNAL_OP_REMOVE) {
+		long long date = pNote->GetDate();
+
+		pos = PutVarint(pos, (unsigned long long)pNote->GetType());
+		pos = PutVarint(pos, (unsigned long long)((date << 1) ^ (date >> 63)));
+		__pScratch[pos++] = pNote->GetMarked() ? 1 : 0;
+		pos = PutString(pos, pNote->GetTitle());
+		pos = PutString(pos, pNote->GetText());
+		pos = PutString(pos, pNote->GetResourcePath());
+	}
+
+	res = WriteRecord(header, pos);
+
+	if (op == JOURNAL_OP_REMOVE) {
+		__tempIds.erase(pNote);
+	}
+	return res;
+}
+
+result NotesJournal::AppendRemove(int entryId) {
+	if (!__pFile) {
+		return E_INVALID_STATE;
+	}
+
+	result res = Grow(16);
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	const int header = 5;
+	int pos = header;
+	__pScratch[pos++] = (byte)JOURNAL_OP_REMOVE;
+	pos = PutVarint(pos, (unsigned long long)entryId << 1);
+
+	return WriteRecord(header, pos);
+}
+
+result NotesJournal::WriteRecord(int header, int end) {
+	int pos = end;
+	int payload = pos - header;
+	byte checksum = 0;
+	for (int i = header; i < pos; i++) {
+		checksum = (byte)((checksum << 1 | checksum >> 7) ^ __pScratch[i]);
+	}
+	__pScratch[pos++] = checksum;
+
+	//length prefix is placed right before the payload
+	byte prefix[5];
+	int prefix_len = 0;
+	unsigned int len = (unsigned int)payload;
+	while (len >= 0x80) {
+		prefix[prefix_len++] = (byte)(len | 0x80);
+		len >>= 7;
+	}
+	prefix[prefix_len++] = (byte)len;
+
+	int start = header - prefix_len;
+	memcpy(__pScratch + start, prefix, prefix_len);
+
+	result res = __pFile->Write(__pScratch + start, pos - start);
+	if (!IsFailed(res)) {
+		res = __pFile->Flush();
+	}
+	if (IsFailed(res)) {
+		AppLogException("Failed to append record to journal [%S], error: [%s]", __path.GetPointer(), GetErrorMessage(res));
+	}
+	return res;
+}
+
+bool NotesJournal::GetVarint(const byte *pData, int len, int &pos, unsigned long long &val) {
+	val = 0;
+	for (int shift = 0; shift < 64 && pos < len; shift += 7) {
+		byte b = pData[pos++];
+		val |= (unsigned long long)(b & 0x7F) << shift;
+		if (!(b & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool NotesJournal::GetString(const byte *pData, int len, int &pos, String &str) {
+	unsigned long long size = 0;
+	if (!GetVarint(pData, len, pos, size) || pos + (int)size > len) {
+		return false;
+	}
+
+	str = L"";
+	if (size == 0) {
+		return true;
+	}
+
+	ByteBuffer bytes;
+	if (IsFailed(bytes.Construct((int)size + 1))) {
+		return false;
+	}
+	bytes.SetArray(pData, pos, (int)size);
+	bytes.SetByte('\0');
+	bytes.Flip();
+	pos += (int)size;
+
+	Utf8Encoding utf8;
+	return !IsFailed(utf8.GetString(bytes, str));
+}
+
+result NotesJournal::Replay(IListT<Note *> *pNotes, ArrayListT<int> *pRemovedIds, long long generation, bool &changed) {
+	changed = false;
+
+	FileAttributes attr;
+	result res = File::GetAttributes(__path, attr);
+	if (IsFailed(res) || attr.GetFileSize() == 0) {
+		return E_SUCCESS;
+	}
+
+	int size = (int)attr.GetFileSize();
+	byte *pData = new byte[size];
+
+	File file;
+	res = file.Construct(__path, L"r");
+	if (!IsFailed(res)) {
+		int read = file.Read(pData, size);
+		res = GetLastResult();
+		if (!IsFailed(res)) {
+			size = read;
+		}
+	}
+	if (IsFailed(res)) {
+		AppLogException("Failed to read journal [%S], error: [%s]", __path.GetPointer(), GetErrorMessage(res));
+
+		delete[] pData;
+		return res;
+	}
+
+	std::map<int, Note *> temp_notes;
+	int replayed = 0;
+	int skipped = 0;
+	//set once the database moved past the generation this log is based on, i.e. the flush committed before Reset() happened
+	bool committed = false;
+
+	int pos = 0;
+	while (pos < size) {
+		unsigned long long payload = 0;
+		if (!GetVarint(pData, size, pos, payload) || pos + (int)payload + 1 > size) {
+			//torn write of the last record
+			break;
+		}
+
+		int end = pos + (int)payload;
+		byte checksum = 0;
+		for (int i = pos; i < end; i++) {
+			checksum = (byte)((checksum << 1 | checksum >> 7) ^ pData[i]);
+		}
+		if (checksum != pData[end]) {
+			AppLogException("Journal [%S] record at [%d] is corrupted, ignoring the rest of it", __path.GetPointer(), pos);
+			break;
+		}
+
+		JournalOperation op = (JournalOperation)pData[pos++];
+		if (op == JOURNAL_OP_BEGIN) {
+			unsigned long long base = 0;
+			if (GetVarint(pData, end, pos, base)) {
+				committed = generation >= 0 && generation > (long long)base;
+			}
+			pos = end + 1;
+			continue;
+		}
+
+		unsigned long long key = 0;
+		GetVarint(pData, end, pos, key);
+
+		int id = (int)(key >> 1);
+		bool temp = (key & 1) != 0;
+
+		//committed rows already hold these changes; removals of stored notes are separate transactions
+		//which may not have run yet, and applying them again is harmless
+		if (committed && (op != JOURNAL_OP_REMOVE || temp)) {
+			skipped++;
+			pos = end + 1;
+			continue;
+		}
+
+		Note *pTarget = null;
+		if (temp) {
+			std::map<int, Note *>::iterator iter = temp_notes.find(id);
+			if (iter != temp_notes.end()) {
+				pTarget = iter->second;
+			}
+		} else {
+			IEnumeratorT<Note *> *pEnum = pNotes->GetEnumeratorN();
+			while (pEnum && !IsFailed(pEnum->MoveNext())) {
+				Note *pNote; pEnum->GetCurrent(pNote);
+				if (pNote->GetEntryId() == id) {
+					pTarget = pNote;
+					break;
+				}
+			}
+			if (pEnum) delete pEnum;
+		}
+
+		if (op == JOURNAL_OP_REMOVE) {
+			if (pTarget) {
+				pNotes->Remove(pTarget);
+				delete pTarget;
+				if (temp) {
+					temp_notes.erase(id);
+				}
+			}
+			if (!temp) {
+				pRemovedIds->Add(id);
+			}
+		} else {
+			unsigned long long type = 0, date = 0;
+			String title, text, res_path;
+			if (!GetVarint(pData, end, pos, type) || !GetVarint(pData, end, pos, date) || pos >= end) {
+				break;
+			}
+			bool marked = pData[pos++] != 0;
+			if (!GetString(pData, end, pos, title) || !GetString(pData, end, pos, text) || !GetString(pData, end, pos, res_path)) {
+				break;
+			}
+
+			if (!pTarget) {
+				if (!temp) {
+					//note was removed from the database since, nothing to apply this to
+					pos = end + 1;
+					continue;
+				}
+				pTarget = new Note;
+				pTarget->Construct((NoteType)type);
+				pNotes->Add(pTarget);
+				temp_notes.insert(std::make_pair(id, pTarget));
+			}
+
+			pTarget->SetDate((long long)(date >> 1) ^ -(long long)(date & 1));
+			pTarget->SetMarked(marked);
+			pTarget->SetTitle(title);
+			pTarget->SetText(text);
+			pTarget->SetResourcePath(res_path);
+			pTarget->SetSerialized(false);
+		}
+
+		replayed++;
+		pos = end + 1;
+	}
+	delete[] pData;
+
+	if (skipped > 0) {
+		AppLog("Skipped [%d] journal records from [%S] which were already committed", skipped, __path.GetPointer());
+	}
+	if (replayed > 0) {
+		AppLog("Replayed [%d] journal records from [%S]", replayed, __path.GetPointer());
+		changed = true;
+	}
+	return E_SUCCESS;
+}
+
+result NotesJournal::Reset(long long generation) {
+	if (!__pFile) {
+		return E_INVALID_STATE;
+	}
+
+	result res = __pFile->Truncate(0);
+	if (IsFailed(res)) {
+		AppLogException("Failed to truncate journal [%S], error: [%s]", __path.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	//everything is in the database now and has a real entry ID
+	__tempIds.clear();
+	__nextTempId = 0;
+
+	if (generation < 0) {
+		//without a header every record is replayed, as before
+		return E_SUCCESS;
+	}
+
+	const int header = 5;
+	int pos = header;
+	__pScratch[pos++] = (byte)JOURNAL_OP_BEGIN;
+	pos = PutVarint(pos, (unsigned long long)generation);
+
+	return WriteRecord(header, pos);
+}
@@ -18,12 +18,83 @@
 #include <FApp.h>
 #include <FIo.h>
 
+#include "AttachmentStore.h"
+#include "Collator.h"
+#include "Metrics.h"
 #include "NotesManager.h"
+#include "TextUtils.h"
+#include "Trace.h"
 
 using namespace Osp::App;
 using namespace Osp::Io;
 
-#define DB_VERSION 2
+#define DB_VERSION 6
+
+//reference counts follow resource rows, so deleting or rewriting a note keeps them right without extra statements
+static const int ATTACHMENT_SCHEMA_COUNT = 5;
+static const mchar *ATTACHMENT_SCHEMA[ATTACHMENT_SCHEMA_COUNT] = {
+	L"CREATE TABLE attachments (hash TEXT PRIMARY KEY, path TEXT, size INTEGER, refs INTEGER)",
+	L"CREATE INDEX resource_entries_hash ON resource_entries (hash)",
+	L"CREATE TRIGGER attachments_ref AFTER INSERT ON resource_entries WHEN NEW.hash IS NOT NULL "
+	"BEGIN UPDATE attachments SET refs = refs + 1 WHERE hash = NEW.hash; END",
+	L"CREATE TRIGGER attachments_unref AFTER DELETE ON resource_entries WHEN OLD.hash IS NOT NULL "
+	"BEGIN UPDATE attachments SET refs = refs - 1 WHERE hash = OLD.hash; END",
+	L"CREATE TRIGGER attachments_reref AFTER UPDATE OF hash ON resource_entries "
+	"BEGIN UPDATE attachments SET refs = refs - 1 WHERE hash = OLD.hash; UPDATE attachments SET refs = refs + 1 WHERE hash = NEW.hash; END"
+};
+
+//metadata is dropped whenever the media behind it changes and extracted again by ExtractAudioInfo()
+static const int AUDIO_SCHEMA_COUNT = 3;
+static const mchar *AUDIO_SCHEMA[AUDIO_SCHEMA_COUNT] = {
+	L"CREATE TABLE audio_metadata (entry_id INTEGER PRIMARY KEY, duration INTEGER, size INTEGER, envelope BLOB)",
+	L"CREATE TRIGGER audio_metadata_changed AFTER UPDATE OF res_path, hash ON resource_entries "
+	"WHEN OLD.hash IS NOT NEW.hash OR (NEW.hash IS NULL AND OLD.res_path IS NOT NEW.res_path) "
+	"BEGIN DELETE FROM audio_metadata WHERE entry_id = NEW.entry_id; END",
+	L"CREATE TRIGGER audio_metadata_removed AFTER DELETE ON resource_entries "
+	"BEGIN DELETE FROM audio_metadata WHERE entry_id = OLD.entry_id; END"
+};
+
+NotesCursor::NotesCursor(void) {
+	__pTitleKey = null;
+	Reset();
+}
+
+NotesCursor::~NotesCursor(void) {
+	if (__pTitleKey) delete __pTitleKey;
+}
+
+void NotesCursor::Reset(void) {
+	__valid = false;
+	__sorting = SORT_BY_DATE;
+	__order = SORT_ORDER_DESCENDING;
+	__marked = false;
+	__primary = 0;
+	__entryId = -1;
+	if (__pTitleKey) {
+		delete __pTitleKey;
+		__pTitleKey = null;
+	}
+}
+
+void NotesCursor::Set(SortType sorting, SortOrder order, bool marked, long long primary, const ByteBuffer *pTitleKey, int entryId) {
+	Reset();
+
+	//key is copied, because the note it came from may be gone by the time next page is requested
+	if (pTitleKey) {
+		__pTitleKey = new ByteBuffer;
+		if (IsFailed(__pTitleKey->Construct(*pTitleKey))) {
+			delete __pTitleKey;
+			__pTitleKey = null;
+			return;
+		}
+	}
+	__valid = true;
+	__sorting = sorting;
+	__order = order;
+	__marked = marked;
+	__primary = primary;
+	__entryId = entryId;
+}
 
 result NotesManager::Construct(const String &path) {
 	__dataPath = path;
@@ -31,8 +102,27 @@ result NotesManager::Construct(const String &path) {
 }
 
 result NotesManager::Load(void) {
+	TRACE_SCOPE("db.load");
+
+	if (!__pCollator) {
+		__pCollator = new Collator;
+		__pCollator->Construct(Collator::GetSystemLanguage());
+	}
+	if (!__pAttachments) {
+		__pAttachments = new AttachmentStore;
+		result res = __pAttachments->Construct(__dataPath);
+		if (IsFailed(res)) {
+			//notes keep referencing media where it was picked from
+			AppLogException("Failed to open attachment store for [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+			delete __pAttachments;
+			__pAttachments = null;
+		}
+	}
+
 	if (File::IsFileExist(__dataPath)) {
 		Database *pDb = new Database;
+		Metrics::Add(METRIC_DB_OPENS);
 		result res = pDb->Construct(__dataPath, false);
 		if (IsFailed(res)) {
 			AppLogException("Failed to load database file at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
@@ -60,18 +150,39 @@ result NotesManager::Load(void) {
 					return res;
 				}
 
-				if (DB_VERSION != ver) {
+				if (ver > DB_VERSION) {
 					delete pEnum;
 					delete pDb;
 
 					return E_INVALID_FORMAT;
-				} else break;
+				} else if (ver < DB_VERSION) {
+					delete pEnum;
+					pEnum = null;
+
+					res = Upgrade(pDb, ver);
+					if (IsFailed(res)) {
+						delete pDb;
+						return res;
+					}
+				}
+				break;
 			}
 		} else {
 			delete pDb;
 			return E_INVALID_FORMAT;
 		}
-		delete pEnum;
+		if (pEnum) delete pEnum;
+
+		res = RefreshTitleKeys(pDb);
+		if (IsFailed(res)) {
+			//title order falls back to whatever keys are stored, the rest still works
+			AppLogException("Failed to refresh title collation keys for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+		}
+
+		res = RelinkAttachments(pDb);
+		if (IsFailed(res)) {
+			AppLogException("Failed to relink attachments for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+		}
 
 		pEnum = pDb->QueryN(L"SELECT MAX(entry_id) FROM entries"); res = GetLastResult();
 		if (IsFailed(res)) {
@@ -103,6 +214,7 @@ result NotesManager::Load(void) {
 		delete pDb;
 	} else {
 		Database *pDb = new Database;
+		Metrics::Add(METRIC_DB_OPENS);
 		result res = pDb->Construct(__dataPath, true);
 		if (IsFailed(res)) {
 			AppLogException("Failed to initialize database file at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
@@ -111,17 +223,27 @@ result NotesManager::Load(void) {
 			return res;
 		}
 
-		result mres[4];
-		mres[0] = pDb->ExecuteSql(L"CREATE TABLE db_info (ver INTEGER)", true);
+		const int stepCount = 7 + ATTACHMENT_SCHEMA_COUNT + AUDIO_SCHEMA_COUNT;
+		result mres[stepCount];
+		mres[0] = pDb->ExecuteSql(L"CREATE TABLE db_info (ver INTEGER, generation INTEGER, collation TEXT)", true);
 		String db_ver = L""; db_ver.Append(DB_VERSION);
-		mres[1] = pDb->ExecuteSql(L"INSERT INTO db_info (ver) VALUES ('" + db_ver + L"')", true);
-
-		mres[2] = pDb->ExecuteSql(L"CREATE TABLE entries (entry_id INTEGER, type INTEGER, timestamp INTEGER, marked INTEGER, title TEXT, text TEXT)", true);
-		mres[3] = pDb->ExecuteSql(L"CREATE TABLE resource_entries (entry_id INTEGER, res_path TEXT)", true);
+		mres[1] = pDb->ExecuteSql(L"INSERT INTO db_info (ver, generation, collation) VALUES ('" + db_ver + L"', 0, '" + __pCollator->GetRulesId() + L"')", true);
+
+		mres[2] = pDb->ExecuteSql(L"CREATE TABLE entries (entry_id INTEGER, type INTEGER, timestamp INTEGER, marked INTEGER, title TEXT, text TEXT, generation INTEGER, title_key BLOB)", true);
+		mres[3] = pDb->ExecuteSql(L"CREATE TABLE resource_entries (entry_id INTEGER, res_path TEXT, hash TEXT)", true);
+		mres[4] = pDb->ExecuteSql(L"CREATE TABLE removed_entries (entry_id INTEGER, generation INTEGER)", true);
+		mres[5] = pDb->ExecuteSql(L"CREATE INDEX entries_generation ON entries (generation)", true);
+		mres[6] = pDb->ExecuteSql(L"CREATE INDEX entries_title_key ON entries (marked, title_key)", true);
+		for (int i = 0; i < ATTACHMENT_SCHEMA_COUNT; i++) {
+			mres[7 + i] = pDb->ExecuteSql(ATTACHMENT_SCHEMA[i], true);
+		}
+		for (int i = 0; i < AUDIO_SCHEMA_COUNT; i++) {
+			mres[7 + ATTACHMENT_SCHEMA_COUNT + i] = pDb->ExecuteSql(AUDIO_SCHEMA[i], true);
+		}
 
 		delete pDb;
 
-		for(int i = 0; i < 4; i++) {
+		for(int i = 0; i < stepCount; i++) {
 			if (IsFailed(mres[i])) {
 				AppLogException("Failed to initialize database structure at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(mres[i]));
 
@@ -132,12 +254,430 @@ result NotesManager::Load(void) {
 	return E_SUCCESS;
 }
 
+result NotesManager::Upgrade(Database *pDb, int fromVersion) const {
+	result res = pDb->BeginTransaction();
+	if (IsFailed(res)) {
+		AppLogException("Failed to begin upgrade transaction for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	//every step brings database one version up, so old files pass through all of them in order
+	if (fromVersion < 3) {
+		result mres[5];
+		mres[0] = pDb->ExecuteSql(L"ALTER TABLE db_info ADD COLUMN generation INTEGER DEFAULT 0", false);
+		mres[1] = pDb->ExecuteSql(L"ALTER TABLE entries ADD COLUMN generation INTEGER DEFAULT 0", false);
+		mres[2] = pDb->ExecuteSql(L"CREATE TABLE removed_entries (entry_id INTEGER, generation INTEGER)", false);
+		mres[3] = pDb->ExecuteSql(L"CREATE INDEX entries_generation ON entries (generation)", false);
+		mres[4] = pDb->ExecuteSql(L"UPDATE db_info SET ver = 3, generation = 0", false);
+
+		for(int i = 0; i < 5; i++) {
+			if (IsFailed(mres[i])) {
+				AppLogException("Failed to upgrade database at [%S] to version 3, error: [%s]", __dataPath.GetPointer(), GetErrorMessage(mres[i]));
+
+				pDb->RollbackTransaction();
+				return mres[i];
+			}
+		}
+	}
+	if (fromVersion < 4) {
+		//keys are filled right after upgrade by RefreshTitleKeys()
+		result mres[4];
+		mres[0] = pDb->ExecuteSql(L"ALTER TABLE db_info ADD COLUMN collation TEXT DEFAULT ''", false);
+		mres[1] = pDb->ExecuteSql(L"ALTER TABLE entries ADD COLUMN title_key BLOB", false);
+		mres[2] = pDb->ExecuteSql(L"CREATE INDEX entries_title_key ON entries (marked, title_key)", false);
+		mres[3] = pDb->ExecuteSql(L"UPDATE db_info SET ver = 4", false);
+
+		for(int i = 0; i < 4; i++) {
+			if (IsFailed(mres[i])) {
+				AppLogException("Failed to upgrade database at [%S] to version 4, error: [%s]", __dataPath.GetPointer(), GetErrorMessage(mres[i]));
+
+				pDb->RollbackTransaction();
+				return mres[i];
+			}
+		}
+	}
+
+	if (fromVersion < 5) {
+		//media referenced so far stays where it is; only notes saved from now on are moved into the store
+		result mres[ATTACHMENT_SCHEMA_COUNT + 2];
+		mres[0] = pDb->ExecuteSql(L"ALTER TABLE resource_entries ADD COLUMN hash TEXT", false);
+		for (int i = 0; i < ATTACHMENT_SCHEMA_COUNT; i++) {
+			mres[1 + i] = pDb->ExecuteSql(ATTACHMENT_SCHEMA[i], false);
+		}
+		mres[ATTACHMENT_SCHEMA_COUNT + 1] = pDb->ExecuteSql(L"UPDATE db_info SET ver = 5", false);
+
+		for(int i = 0; i < ATTACHMENT_SCHEMA_COUNT + 2; i++) {
+			if (IsFailed(mres[i])) {
+				AppLogException("Failed to upgrade database at [%S] to version 5, error: [%s]", __dataPath.GetPointer(), GetErrorMessage(mres[i]));
+
+				pDb->RollbackTransaction();
+				return mres[i];
+			}
+		}
+	}
+	if (fromVersion < 6) {
+		//existing audio notes are picked up by ExtractAudioInfo() in background
+		result mres[AUDIO_SCHEMA_COUNT + 1];
+		for (int i = 0; i < AUDIO_SCHEMA_COUNT; i++) {
+			mres[i] = pDb->ExecuteSql(AUDIO_SCHEMA[i], false);
+		}
+		mres[AUDIO_SCHEMA_COUNT] = pDb->ExecuteSql(L"UPDATE db_info SET ver = 6", false);
+
+		for(int i = 0; i < AUDIO_SCHEMA_COUNT + 1; i++) {
+			if (IsFailed(mres[i])) {
+				AppLogException("Failed to upgrade database at [%S] to version 6, error: [%s]", __dataPath.GetPointer(), GetErrorMessage(mres[i]));
+
+				pDb->RollbackTransaction();
+				return mres[i];
+			}
+		}
+	}
+
+	res = pDb->CommitTransaction();
+	if (IsFailed(res)) {
+		AppLogException("Failed to commit upgrade transaction for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+	}
+	return res;
+}
+
+result NotesManager::RefreshTitleKeys(Database *pDb) const {
+	DbEnumerator *pEnum = pDb->QueryN(L"SELECT collation FROM db_info");
+	result res = GetLastResult();
+	if (IsFailed(res) || !pEnum) {
+		return IsFailed(res) ? res : E_INVALID_FORMAT;
+	}
+
+	String collation;
+	if (!IsFailed(pEnum->MoveNext())) {
+		pEnum->GetStringAt(0, collation);
+	}
+	delete pEnum;
+
+	//rows restored from a backup or written by an older version have no key yet
+	String query = L"SELECT entry_id, title FROM entries";
+	if (collation == __pCollator->GetRulesId()) {
+		query.Append(L" WHERE title_key IS NULL");
+	}
+
+	pEnum = pDb->QueryN(query);
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		return res;
+	}
+	if (!pEnum) {
+		//nothing to update
+		return E_SUCCESS;
+	}
+
+	res = pDb->BeginTransaction();
+	if (IsFailed(res)) {
+		delete pEnum;
+		return res;
+	}
+
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pUpdate = pDb->CreateStatementN(L"UPDATE entries SET title_key = ? WHERE entry_id = ?");
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		delete pEnum;
+		pDb->RollbackTransaction();
+		return res;
+	}
+
+	int rows = 0;
+	while (!IsFailed(pEnum->MoveNext())) {
+		int entry_id = -1;
+		String title;
+
+		res = pEnum->GetIntAt(0, entry_id);
+		if (!IsFailed(res)) {
+			res = pEnum->GetStringAt(1, title);
+		}
+
+		ByteBuffer *pKey = null;
+		if (!IsFailed(res)) {
+			pKey = __pCollator->CreateKeyN(title);
+			res = pKey ? pUpdate->BindBlob(0, *pKey) : GetLastResult();
+		}
+		if (!IsFailed(res)) {
+			res = pUpdate->BindInt(1, entry_id);
+		}
+		if (!IsFailed(res)) {
+			pDb->ExecuteStatementN(*pUpdate);
+			res = GetLastResult();
+		}
+		if (pKey) delete pKey;
+
+		if (IsFailed(res)) {
+			delete pUpdate;
+			delete pEnum;
+			pDb->RollbackTransaction();
+			return res;
+		}
+		rows++;
+	}
+	delete pUpdate;
+	delete pEnum;
+
+	Metrics::Add(METRIC_ROWS_READ, rows);
+
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pInfo = pDb->CreateStatementN(L"UPDATE db_info SET collation = ?");
+	res = GetLastResult();
+	if (!IsFailed(res)) {
+		res = pInfo->BindString(0, __pCollator->GetRulesId());
+		if (!IsFailed(res)) {
+			pDb->ExecuteStatementN(*pInfo);
+			res = GetLastResult();
+		}
+		delete pInfo;
+	}
+	if (IsFailed(res)) {
+		pDb->RollbackTransaction();
+		return res;
+	}
+
+	if (rows > 0) {
+		AppLog("Rebuilt [%d] title collation keys for language [%S]", rows, __pCollator->GetLanguage().GetPointer());
+	}
+	return pDb->CommitTransaction();
+}
+
+const ByteBuffer *NotesManager::GetTitleKey(Note *val) const {
+	if (!val->GetTitleKey() && __pCollator) {
+		val->SetTitleKey(__pCollator->CreateKeyN(val->GetTitle()));
+	}
+	return val->GetTitleKey();
+}
+
+result NotesManager::BindTitleKey(DbStatement *pStmt, int index, Note *val) const {
+	const ByteBuffer *pKey = val->GetTitleKey();
+	if (pKey) {
+		return pStmt->BindBlob(index, *pKey);
+	} else {
+		//row gets its key on next load
+		return pStmt->BindNull(index);
+	}
+}
+
+result NotesManager::IngestResource(const String &path, String &storedPath) const {
+	storedPath = path;
+
+	String relative, hash;
+	if (!__pAttachments || path.IsEmpty() || __pAttachments->ParsePath(path, relative, hash) || !File::IsFileExist(path)) {
+		return E_SUCCESS;
+	}
+
+	long long size = 0;
+	result res = __pAttachments->Ingest(path, relative, hash, size);
+	if (!IsFailed(res)) {
+		Database *pDb = new Database;
+		Metrics::Add(METRIC_DB_OPENS);
+		res = pDb->Construct(__dataPath, true);
+		if (!IsFailed(res)) {
+			//unreferenced until the note is saved, so the copy is collected if that never happens
+			Metrics::Add(METRIC_STATEMENTS_PREPARED);
+			DbStatement *pAttach = pDb->CreateStatementN(L"INSERT OR IGNORE INTO attachments (hash, path, size, refs) VALUES (?, ?, ?, 0)");
+			res = GetLastResult();
+			if (!IsFailed(res)) {
+				result bind_res[3];
+				bind_res[0] = pAttach->BindString(0, hash);
+				bind_res[1] = pAttach->BindString(1, relative);
+				bind_res[2] = pAttach->BindInt64(2, size);
+				for (int i = 0; i < 3 && !IsFailed(res); i++) {
+					res = bind_res[i];
+				}
+				if (!IsFailed(res)) {
+					pDb->ExecuteStatementN(*pAttach); res = GetLastResult();
+				}
+				delete pAttach;
+			}
+		}
+		delete pDb;
+	}
+
+	if (IsFailed(res)) {
+		//note keeps pointing at the original file, it's picked up again next time the note is saved
+		AppLogException("Failed to add [%S] to attachment store, error: [%s]", path.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	storedPath = __pAttachments->GetAbsolutePath(relative);
+	return E_SUCCESS;
+}
+
+void NotesManager::IngestResource(Note *val) const {
+	if (val->GetType() != NOTE_TYPE_PHOTO && val->GetType() != NOTE_TYPE_AUDIO) {
+		return;
+	}
+
+	//notes with nothing to copy are left untouched, they may be shared with other threads
+	String stored;
+	if (!IsFailed(IngestResource(val->GetResourcePath(), stored)) && !stored.Equals(val->GetResourcePath(), true)) {
+		val->SetResourcePath(stored);
+	}
+}
+
+result NotesManager::BindResource(DbStatement *pStmt, int index, Note *val) const {
+	String relative, hash;
+	const String &path = val->GetResourcePath();
+	bool managed = __pAttachments && __pAttachments->ParsePath(path, relative, hash);
+
+	result res = pStmt->BindString(index, path);
+	if (!IsFailed(res)) {
+		res = managed ? pStmt->BindString(index + 1, hash) : pStmt->BindNull(index + 1);
+	}
+	return res;
+}
+
+result NotesManager::RelinkAttachments(Database *pDb) const {
+	if (!__pAttachments) {
+		return E_SUCCESS;
+	}
+	const String &root = __pAttachments->GetRoot();
+
+	//store was moved together with its media directory
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pMoved = pDb->CreateStatementN(L"UPDATE resource_entries SET res_path = ? || (SELECT path FROM attachments WHERE attachments.hash = resource_entries.hash) "
+												"WHERE hash IS NOT NULL AND substr(res_path, 1, ?) <> ?");
+	result res = GetLastResult();
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	result bind_res[3];
+	bind_res[0] = pMoved->BindString(0, root);
+	bind_res[1] = pMoved->BindInt(1, root.GetLength());
+	bind_res[2] = pMoved->BindString(2, root);
+	for (int i = 0; i < 3 && !IsFailed(res); i++) {
+		res = bind_res[i];
+	}
+	if (!IsFailed(res)) {
+		pDb->ExecuteStatementN(*pMoved); res = GetLastResult();
+	}
+	delete pMoved;
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	//rows restored from a backup point into the store but carry no hash, so they are not counted yet
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pRestored = pDb->CreateStatementN(L"UPDATE resource_entries SET hash = (SELECT hash FROM attachments WHERE ? || attachments.path = resource_entries.res_path) "
+												   "WHERE hash IS NULL AND substr(res_path, 1, ?) = ?");
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	bind_res[0] = pRestored->BindString(0, root);
+	bind_res[1] = pRestored->BindInt(1, root.GetLength());
+	bind_res[2] = pRestored->BindString(2, root);
+	for (int i = 0; i < 3 && !IsFailed(res); i++) {
+		res = bind_res[i];
+	}
+	if (!IsFailed(res)) {
+		pDb->ExecuteStatementN(*pRestored); res = GetLastResult();
+	}
+	delete pRestored;
+
+	return res;
+}
+
+result NotesManager::CollectAttachments(Database *pDb) const {
+	if (!__pAttachments) {
+		return E_SUCCESS;
+	}
+
+	result res = RelinkAttachments(pDb);
+	if (IsFailed(res)) {
+		//without it restored notes could lose their media
+		AppLogException("Failed to relink attachments, skipping collection. Error: [%s]", GetErrorMessage(res));
+		return res;
+	}
+
+	DbEnumerator *pEnum = pDb->QueryN(L"SELECT path FROM attachments WHERE refs <= 0");
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to query orphaned attachments for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	if (pEnum) {
+		while (!IsFailed(pEnum->MoveNext())) {
+			String relative;
+			if (!IsFailed(pEnum->GetStringAt(0, relative))) {
+				__pAttachments->Delete(relative);
+			}
+		}
+		delete pEnum;
+
+		res = pDb->ExecuteSql(L"DELETE FROM attachments WHERE refs <= 0", true);
+		if (IsFailed(res)) {
+			AppLogException("Failed to drop orphaned attachments for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+		}
+	}
+	return res;
+}
+
+result NotesManager::BumpGeneration(Database *pDb) const {
+	//rows written in the same transaction are then tagged with '(SELECT generation FROM db_info)'
+	result res = pDb->ExecuteSql(L"UPDATE db_info SET generation = generation + 1", false);
+	if (IsFailed(res)) {
+		AppLogException("Failed to advance modification generation for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+	}
+	return res;
+}
+
+result NotesManager::GetGeneration(long long &generation) const {
+	generation = -1;
+
+	Database *pDb = new Database;
+	Metrics::Add(METRIC_DB_OPENS);
+	result res = pDb->Construct(__dataPath, false);
+	if (IsFailed(res)) {
+		AppLogException("Failed to load database file at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pDb;
+		return res;
+	}
+
+	DbEnumerator *pEnum = pDb->QueryN(L"SELECT generation FROM db_info"); res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to query database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pDb;
+		return res;
+	}
+
+	res = E_OBJ_NOT_FOUND;
+	if (pEnum) {
+		if (!IsFailed(pEnum->MoveNext())) {
+			res = pEnum->GetInt64At(0, generation);
+		}
+		delete pEnum;
+	}
+	if (IsFailed(res)) {
+		AppLogException("Failed to get modification generation for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+		generation = -1;
+	}
+
+	delete pDb;
+	return res;
+}
+
 result NotesManager::AddNote(Note *val) {
+	TRACE_SCOPE("db.add_note");
+
 	if (val->GetEntryId() >= 0) {
 		return UpdateNote(val);
 	}
 
+	//media is copied before the transaction, so it doesn't hold the database while doing that
+	IngestResource(val);
+	GetTitleKey(val);
+
 	Database *pDb = new Database;
+	Metrics::Add(METRIC_DB_OPENS);
 	result res = pDb->Construct(__dataPath, true);
 	if (IsFailed(res)) {
 		AppLogException("Failed to load database file at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
@@ -148,8 +688,12 @@ result NotesManager::AddNote(Note *val) {
 
 	result trans_res[2];
 	trans_res[0] = pDb->BeginTransaction();
+	if (!IsFailed(trans_res[0])) {
+		trans_res[0] = BumpGeneration(pDb);
+	}
 
-	DbStatement *pEntries = pDb->CreateStatementN(L"INSERT INTO entries (entry_id, type, timestamp, marked, title, text) VALUES (?, ?, ?, ?, ?, ?)");
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pEntries = pDb->CreateStatementN(L"INSERT INTO entries (entry_id, type, timestamp, marked, title, text, title_key, generation) VALUES (?, ?, ?, ?, ?, ?, ?, (SELECT generation FROM db_info))");
 
 	res = GetLastResult();
 	if (IsFailed(res)) {
@@ -161,15 +705,16 @@ result NotesManager::AddNote(Note *val) {
 
 	int cur_id = __lastEntryId++;
 
-	result bind_res[6];
+	result bind_res[7];
 	bind_res[0] = pEntries->BindInt(0, cur_id);
 	bind_res[1] = pEntries->BindInt(1, val->GetType());
 	bind_res[2] = pEntries->BindInt64(2, val->GetDate());
 	bind_res[3] = pEntries->BindInt(3, (int)val->GetMarked());
 	bind_res[4] = pEntries->BindString(4, val->GetTitle());
 	bind_res[5] = pEntries->BindString(5, val->GetText());
+	bind_res[6] = BindTitleKey(pEntries, 6, val);
 
-	for(int i = 0; i < 6; i++) {
+	for(int i = 0; i < 7; i++) {
 		if (IsFailed(bind_res[i])) {
 			AppLogException("Failed to bind transaction data for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(bind_res[i]));
 
@@ -190,7 +735,8 @@ result NotesManager::AddNote(Note *val) {
 	}
 
 	if (val->GetType() == NOTE_TYPE_PHOTO || val->GetType() == NOTE_TYPE_AUDIO) {
-		DbStatement *pText = pDb->CreateStatementN(L"INSERT INTO resource_entries (entry_id, res_path) VALUES (?, ?)");
+		Metrics::Add(METRIC_STATEMENTS_PREPARED);
+		DbStatement *pText = pDb->CreateStatementN(L"INSERT INTO resource_entries (entry_id, res_path, hash) VALUES (?, ?, ?)");
 		res = GetLastResult();
 		if (IsFailed(res)) {
 			AppLogException("Failed to initialize resource transaction statement for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
@@ -200,7 +746,7 @@ result NotesManager::AddNote(Note *val) {
 		}
 
 		bind_res[0] = pText->BindInt(0, cur_id);
-		bind_res[1] = pText->BindString(1, val->GetResourcePath());
+		bind_res[1] = BindResource(pText, 1, val);
 
 		for(int i = 0; i < 2; i++) {
 			if (IsFailed(bind_res[i])) {
@@ -242,7 +788,24 @@ result NotesManager::AddNote(Note *val) {
 }
 
 result NotesManager::SerializeNotes(const ICollectionT<Note *> &pNotes) {
+	TRACE_SCOPE("db.serialize_notes");
+
+	//new media goes to the attachment store before the transaction, its own writes can't run inside it;
+	//CachingNotesManager has done this already without its lock, so for its notes nothing is left to copy
+	IEnumeratorT<Note *> *pNew = pNotes.GetEnumeratorN();
+	if (pNew) {
+		while (!IsFailed(pNew->MoveNext())) {
+			Note *pNote = null;
+			pNew->GetCurrent(pNote);
+			if (!pNote->GetSerialized()) {
+				IngestResource(pNote);
+			}
+		}
+		delete pNew;
+	}
+
 	Database *pDb = new Database;
+	Metrics::Add(METRIC_DB_OPENS);
 	result res = pDb->Construct(__dataPath, true);
 	if (IsFailed(res)) {
 		AppLogException("Failed to load database file at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
@@ -253,8 +816,12 @@ result NotesManager::SerializeNotes(const ICollectionT<Note *> &pNotes) {
 
 	result trans_res[2];
 	trans_res[0] = pDb->BeginTransaction();
+	if (!IsFailed(trans_res[0])) {
+		trans_res[0] = BumpGeneration(pDb);
+	}
 
-	DbStatement *pEntries = pDb->CreateStatementN(L"INSERT INTO entries (entry_id, type, timestamp, marked, title, text) VALUES (?, ?, ?, ?, ?, ?)");
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pEntries = pDb->CreateStatementN(L"INSERT INTO entries (entry_id, type, timestamp, marked, title, text, title_key, generation) VALUES (?, ?, ?, ?, ?, ?, ?, (SELECT generation FROM db_info))");
 
 	res = GetLastResult();
 	if (IsFailed(res)) {
@@ -264,7 +831,8 @@ result NotesManager::SerializeNotes(const ICollectionT<Note *> &pNotes) {
 		return res;
 	}
 
-	DbStatement *pText = pDb->CreateStatementN(L"INSERT INTO resource_entries (entry_id, res_path) VALUES (?, ?)");
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pText = pDb->CreateStatementN(L"INSERT INTO resource_entries (entry_id, res_path, hash) VALUES (?, ?, ?)");
 
 	res = GetLastResult();
 	if (IsFailed(res)) {
@@ -275,7 +843,8 @@ result NotesManager::SerializeNotes(const ICollectionT<Note *> &pNotes) {
 		return res;
 	}
 
-	DbStatement *pUpdate = pDb->CreateStatementN(L"UPDATE entries SET timestamp = ?, marked = ?, title = ?, text = ? WHERE entry_id = ?");
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pUpdate = pDb->CreateStatementN(L"UPDATE entries SET timestamp = ?, marked = ?, title = ?, text = ?, title_key = ?, generation = (SELECT generation FROM db_info) WHERE entry_id = ?");
 
 	res = GetLastResult();
 	if (IsFailed(res)) {
@@ -287,7 +856,8 @@ result NotesManager::SerializeNotes(const ICollectionT<Note *> &pNotes) {
 		return res;
 	}
 
-	DbStatement *pUpdateRes = pDb->CreateStatementN(L"UPDATE resource_entries SET res_path = ? WHERE entry_id = ?");
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pUpdateRes = pDb->CreateStatementN(L"UPDATE resource_entries SET res_path = ?, hash = ? WHERE entry_id = ?");
 	res = GetLastResult();
 	if (IsFailed(res)) {
 		AppLogException("Failed to initialize resource transaction statement for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
@@ -306,14 +876,15 @@ result NotesManager::SerializeNotes(const ICollectionT<Note *> &pNotes) {
 			continue;
 		}
 		if (pNote->GetEntryId() >= 0) {
-			result bind_res[5];
+			result bind_res[6];
 			bind_res[0] = pUpdate->BindInt64(0, pNote->GetDate());
 			bind_res[1] = pUpdate->BindInt(1, (int)pNote->GetMarked());
 			bind_res[2] = pUpdate->BindString(2, pNote->GetTitle());
 			bind_res[3] = pUpdate->BindString(3, pNote->GetText());
-			bind_res[4] = pUpdate->BindInt(4, pNote->GetEntryId());
+			bind_res[4] = BindTitleKey(pUpdate, 4, pNote);
+			bind_res[5] = pUpdate->BindInt(5, pNote->GetEntryId());
 
-			for(int i = 0; i < 5; i++) {
+			for(int i = 0; i < 6; i++) {
 				if (IsFailed(bind_res[i])) {
 					AppLogException("Failed to bind transaction data with index [%d] for database at [%S], error: [%s]", i, __dataPath.GetPointer(), GetErrorMessage(bind_res[i]));
 
@@ -343,8 +914,8 @@ result NotesManager::SerializeNotes(const ICollectionT<Note *> &pNotes) {
 
 			if (pNote->GetType() == NOTE_TYPE_PHOTO || pNote->GetType() == NOTE_TYPE_AUDIO) {
 				result bind_res[2];
-				bind_res[0] = pUpdateRes->BindString(0, pNote->GetResourcePath());
-				bind_res[1] = pUpdateRes->BindInt(1, pNote->GetEntryId());
+				bind_res[0] = BindResource(pUpdateRes, 0, pNote);
+				bind_res[1] = pUpdateRes->BindInt(2, pNote->GetEntryId());
 
 				for(int i = 0; i < 2; i++) {
 					if (IsFailed(bind_res[i])) {
@@ -376,15 +947,16 @@ result NotesManager::SerializeNotes(const ICollectionT<Note *> &pNotes) {
 		} else {
 			int cur_id = __lastEntryId++;
 
-			result bind_res[6];
+			result bind_res[7];
 			bind_res[0] = pEntries->BindInt(0, cur_id);
 			bind_res[1] = pEntries->BindInt(1, pNote->GetType());
 			bind_res[2] = pEntries->BindInt64(2, pNote->GetDate());
 			bind_res[3] = pEntries->BindInt(3, (int)pNote->GetMarked());
 			bind_res[4] = pEntries->BindString(4, pNote->GetTitle());
 			bind_res[5] = pEntries->BindString(5, pNote->GetText());
+			bind_res[6] = BindTitleKey(pEntries, 6, pNote);
 
-			for(int i = 0; i < 6; i++) {
+			for(int i = 0; i < 7; i++) {
 				if (IsFailed(bind_res[i])) {
 					AppLogException("Failed to bind transaction data for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(bind_res[i]));
 
@@ -413,7 +985,7 @@ result NotesManager::SerializeNotes(const ICollectionT<Note *> &pNotes) {
 
 			if (pNote->GetType() == NOTE_TYPE_PHOTO || pNote->GetType() == NOTE_TYPE_AUDIO) {
 				bind_res[0] = pText->BindInt(0, cur_id);
-				bind_res[1] = pText->BindString(1, pNote->GetResourcePath());
+				bind_res[1] = BindResource(pText, 1, pNote);
 
 				for(int i = 0; i < 2; i++) {
 					if (IsFailed(bind_res[i])) {
@@ -454,6 +1026,10 @@ result NotesManager::SerializeNotes(const ICollectionT<Note *> &pNotes) {
 	delete pUpdateRes;
 
 	trans_res[1] = pDb->CommitTransaction();
+	if (!IsFailed(trans_res[1])) {
+		//media no longer referenced by a changed note goes away with the commit
+		CollectAttachments(pDb);
+	}
 	delete pDb;
 
 	for(int i = 0; i < 2; i++) {
@@ -466,16 +1042,278 @@ result NotesManager::SerializeNotes(const ICollectionT<Note *> &pNotes) {
 	return E_SUCCESS;
 }
 
-result NotesManager::UpdateNote(Note *val) const {
-	if (val->GetEntryId() < 0) {
-		AppLogException("Attempt to update note that is not yet saved to database");
-		return E_INVALID_ARG;
-	} else if (val->GetSerialized()) {
-		AppLogException("Attempt to update note that is already serialized");
+int NotesManager::AllocateEntryIds(int count) {
+	int first = __lastEntryId;
+	__lastEntryId += count;
+	return first;
+}
+
+result NotesManager::InsertNote(Database *pDb, DbStatement *pEntries, DbStatement *pResources, Note *val, int entry_id) const {
+	//imported notes are not shared with anyone yet
+	GetTitleKey(val);
+
+	result bind_res[7];
+	bind_res[0] = pEntries->BindInt(0, entry_id);
+	bind_res[1] = pEntries->BindInt(1, val->GetType());
+	bind_res[2] = pEntries->BindInt64(2, val->GetDate());
+	bind_res[3] = pEntries->BindInt(3, (int)val->GetMarked());
+	bind_res[4] = pEntries->BindString(4, val->GetTitle());
+	bind_res[5] = pEntries->BindString(5, val->GetText());
+	bind_res[6] = BindTitleKey(pEntries, 6, val);
+
+	for(int i = 0; i < 7; i++) {
+		if (IsFailed(bind_res[i])) {
+			AppLogException("Failed to bind transaction data for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(bind_res[i]));
+			return bind_res[i];
+		}
+	}
+
+	pDb->ExecuteStatementN(*pEntries);
+	result res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to execute transaction statement for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	if (val->GetType() == NOTE_TYPE_PHOTO || val->GetType() == NOTE_TYPE_AUDIO) {
+		bind_res[0] = pResources->BindInt(0, entry_id);
+		bind_res[1] = BindResource(pResources, 1, val);
+
+		for(int i = 0; i < 2; i++) {
+			if (IsFailed(bind_res[i])) {
+				AppLogException("Failed to bind resource transaction data for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(bind_res[i]));
+				return bind_res[i];
+			}
+		}
+
+		pDb->ExecuteStatementN(*pResources);
+		res = GetLastResult();
+		if (IsFailed(res)) {
+			AppLogException("Failed to execute resource transaction statement for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+			return res;
+		}
+	}
+	return E_SUCCESS;
+}
+
+result NotesManager::ImportNotes(IEnumeratorT<Note *> &notes, int batchSize, IImportProgressListener *pListener) {
+	TRACE_SCOPE("db.import_notes");
+
+	if (batchSize <= 0) {
 		return E_INVALID_ARG;
 	}
 
 	Database *pDb = new Database;
+	Metrics::Add(METRIC_DB_OPENS);
+	result res = pDb->Construct(__dataPath, true);
+	if (IsFailed(res)) {
+		AppLogException("Failed to load database file at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pDb;
+		return res;
+	}
+
+	//statements are prepared once and rebound for every note of every batch
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pEntries = pDb->CreateStatementN(L"INSERT INTO entries (entry_id, type, timestamp, marked, title, text, title_key, generation) VALUES (?, ?, ?, ?, ?, ?, ?, (SELECT generation FROM db_info))");
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to initialize transaction statement for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pDb;
+		return res;
+	}
+
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pResources = pDb->CreateStatementN(L"INSERT INTO resource_entries (entry_id, res_path, hash) VALUES (?, ?, ?)");
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to initialize resource transaction statement for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pEntries;
+		delete pDb;
+		return res;
+	}
+
+	int imported = 0;
+	int batched = 0;
+	int next_id = 0;
+	int ids_left = 0;
+	bool in_transaction = false;
+
+	while (!IsFailed(notes.MoveNext())) {
+		Note *pNote = null;
+		if (IsFailed(notes.GetCurrent(pNote)) || !pNote) {
+			continue;
+		}
+
+		if (!in_transaction) {
+			res = pDb->BeginTransaction();
+			if (IsFailed(res)) {
+				AppLogException("Failed to begin import transaction for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+				break;
+			}
+			in_transaction = true;
+
+			res = BumpGeneration(pDb);
+			if (IsFailed(res)) {
+				break;
+			}
+		}
+
+		if (ids_left == 0) {
+			next_id = AllocateEntryIds(batchSize);
+			ids_left = batchSize;
+		}
+		int cur_id = next_id++;
+		ids_left--;
+
+		res = InsertNote(pDb, pEntries, pResources, pNote, cur_id);
+		if (IsFailed(res)) {
+			break;
+		}
+
+		if (++batched == batchSize) {
+			res = pDb->CommitTransaction();
+			in_transaction = false;
+
+			if (IsFailed(res)) {
+				AppLogException("Failed to commit import batch for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+				break;
+			}
+			//only notes of committed batches count as imported
+			imported += batched;
+			batched = 0;
+			if (pListener) {
+				pListener->OnImportProgress(imported);
+			}
+		}
+	}
+
+	if (in_transaction) {
+		if (IsFailed(res)) {
+			//IDs allocated for the failed batch are simply never used
+			pDb->RollbackTransaction();
+		} else {
+			res = pDb->CommitTransaction();
+			if (IsFailed(res)) {
+				AppLogException("Failed to commit import batch for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+			} else {
+				imported += batched;
+				if (pListener) {
+					pListener->OnImportProgress(imported);
+				}
+			}
+		}
+	}
+
+	delete pEntries;
+	delete pResources;
+	delete pDb;
+
+	return res;
+}
+
+result NotesManager::ImportBatch(const IListT<Note *> &notes) {
+	TRACE_SCOPE("db.import_batch");
+
+	int count = notes.GetCount();
+	if (count == 0) {
+		return E_SUCCESS;
+	}
+
+	//media goes to the attachment store first, its own writes can't run inside the transaction below
+	for (int i = 0; i < count; i++) {
+		Note *pNote = null;
+		notes.GetAt(i, pNote);
+		IngestResource(pNote);
+	}
+
+	Database *pDb = new Database;
+	Metrics::Add(METRIC_DB_OPENS);
+	result res = pDb->Construct(__dataPath, true);
+	if (IsFailed(res)) {
+		AppLogException("Failed to load database file at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pDb;
+		return res;
+	}
+
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pEntries = pDb->CreateStatementN(L"INSERT INTO entries (entry_id, type, timestamp, marked, title, text, title_key, generation) VALUES (?, ?, ?, ?, ?, ?, ?, (SELECT generation FROM db_info))");
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to initialize transaction statement for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pDb;
+		return res;
+	}
+
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pResources = pDb->CreateStatementN(L"INSERT INTO resource_entries (entry_id, res_path, hash) VALUES (?, ?, ?)");
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to initialize resource transaction statement for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pEntries;
+		delete pDb;
+		return res;
+	}
+
+	res = pDb->BeginTransaction();
+	if (IsFailed(res)) {
+		AppLogException("Failed to begin import transaction for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+	} else {
+		res = BumpGeneration(pDb);
+
+		int first_id = AllocateEntryIds(count);
+		for (int i = 0; i < count && !IsFailed(res); i++) {
+			Note *pNote = null;
+			notes.GetAt(i, pNote);
+			res = InsertNote(pDb, pEntries, pResources, pNote, first_id + i);
+		}
+
+		if (IsFailed(res)) {
+			//IDs allocated for the batch are simply never used
+			pDb->RollbackTransaction();
+		} else {
+			res = pDb->CommitTransaction();
+			if (IsFailed(res)) {
+				AppLogException("Failed to commit import batch for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+			} else {
+				for (int i = 0; i < count; i++) {
+					Note *pNote = null;
+					notes.GetAt(i, pNote);
+					pNote->SetEntryID(first_id + i);
+					pNote->SetSerialized(true);
+				}
+			}
+		}
+	}
+
+	delete pEntries;
+	delete pResources;
+	delete pDb;
+
+	return res;
+}
+
+result NotesManager::UpdateNote(Note *val) const {
+	TRACE_SCOPE("db.update_note");
+
+	if (val->GetEntryId() < 0) {
+		AppLogException("Attempt to update note that is not yet saved to database");
+		return E_INVALID_ARG;
+	} else if (val->GetSerialized()) {
+		AppLogException("Attempt to update note that is already serialized");
+		return E_INVALID_ARG;
+	}
+
+	IngestResource(val);
+	GetTitleKey(val);
+
+	Database *pDb = new Database;
+	Metrics::Add(METRIC_DB_OPENS);
 	result res = pDb->Construct(__dataPath, true);
 	if (IsFailed(res)) {
 		AppLogException("Failed to load database file at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
@@ -486,8 +1324,12 @@ result NotesManager::UpdateNote(Note *val) const {
 
 	result trans_res[2];
 	trans_res[0] = pDb->BeginTransaction();
+	if (!IsFailed(trans_res[0])) {
+		trans_res[0] = BumpGeneration(pDb);
+	}
 
-	DbStatement *pEntries = pDb->CreateStatementN(L"UPDATE entries SET timestamp = ?, marked = ?, title = ?, text = ? WHERE entry_id = ?");
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pEntries = pDb->CreateStatementN(L"UPDATE entries SET timestamp = ?, marked = ?, title = ?, text = ?, title_key = ?, generation = (SELECT generation FROM db_info) WHERE entry_id = ?");
 
 	res = GetLastResult();
 	if (IsFailed(res)) {
@@ -497,14 +1339,15 @@ result NotesManager::UpdateNote(Note *val) const {
 		return res;
 	}
 
-	result bind_res[5];
+	result bind_res[6];
 	bind_res[0] = pEntries->BindInt64(0, val->GetDate());
 	bind_res[1] = pEntries->BindInt(1, (int)val->GetMarked());
 	bind_res[2] = pEntries->BindString(2, val->GetTitle());
 	bind_res[3] = pEntries->BindString(3, val->GetText());
-	bind_res[4] = pEntries->BindInt64(4, val->GetEntryId());
+	bind_res[4] = BindTitleKey(pEntries, 4, val);
+	bind_res[5] = pEntries->BindInt64(5, val->GetEntryId());
 
-	for(int i = 0; i < 5; i++) {
+	for(int i = 0; i < 6; i++) {
 		if (IsFailed(bind_res[i])) {
 			AppLogException("Failed to bind transaction data with index [%d] for database at [%S], error: [%s]", i, __dataPath.GetPointer(), GetErrorMessage(bind_res[i]));
 
@@ -525,7 +1368,8 @@ result NotesManager::UpdateNote(Note *val) const {
 	}
 
 	if (val->GetType() == NOTE_TYPE_PHOTO || val->GetType() == NOTE_TYPE_AUDIO) {
-		DbStatement *pText = pDb->CreateStatementN(L"UPDATE resource_entries SET res_path = ? WHERE entry_id = ?");
+		Metrics::Add(METRIC_STATEMENTS_PREPARED);
+		DbStatement *pText = pDb->CreateStatementN(L"UPDATE resource_entries SET res_path = ?, hash = ? WHERE entry_id = ?");
 		res = GetLastResult();
 		if (IsFailed(res)) {
 			AppLogException("Failed to initialize resource transaction statement for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
@@ -534,8 +1378,8 @@ result NotesManager::UpdateNote(Note *val) const {
 			return res;
 		}
 
-		bind_res[0] = pText->BindString(0, val->GetResourcePath());
-		bind_res[1] = pText->BindInt(1, val->GetEntryId());
+		bind_res[0] = BindResource(pText, 0, val);
+		bind_res[1] = pText->BindInt(2, val->GetEntryId());
 
 		for(int i = 0; i < 2; i++) {
 			if (IsFailed(bind_res[i])) {
@@ -560,6 +1404,10 @@ result NotesManager::UpdateNote(Note *val) const {
 	}
 
 	trans_res[1] = pDb->CommitTransaction();
+	if (!IsFailed(trans_res[1])) {
+		//media no longer referenced by a changed note goes away with the commit
+		CollectAttachments(pDb);
+	}
 	delete pDb;
 
 	for(int i = 0; i < 2; i++) {
@@ -576,7 +1424,10 @@ result NotesManager::UpdateNote(Note *val) const {
 }
 
 result NotesManager::RemoveAll(void) const {
+	TRACE_SCOPE("db.remove_all");
+
 	Database *pDb = new Database;
+	Metrics::Add(METRIC_DB_OPENS);
 	result res = pDb->Construct(__dataPath, true);
 	if (IsFailed(res)) {
 		AppLogException("Failed to load database file at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
@@ -585,15 +1436,17 @@ result NotesManager::RemoveAll(void) const {
 		return res;
 	}
 
-	result mres[4];
+	result mres[6];
 	mres[0] = pDb->BeginTransaction();
+	mres[1] = BumpGeneration(pDb);
 
-	mres[1] = pDb->ExecuteSql(L"DELETE FROM entries", false);
-	mres[2] = pDb->ExecuteSql(L"DELETE FROM resource_entries", false);
+	mres[2] = pDb->ExecuteSql(L"INSERT INTO removed_entries (entry_id, generation) SELECT entry_id, (SELECT generation FROM db_info) FROM entries", false);
+	mres[3] = pDb->ExecuteSql(L"DELETE FROM entries", false);
+	mres[4] = pDb->ExecuteSql(L"DELETE FROM resource_entries", false);
 
-	mres[3] = pDb->CommitTransaction();
+	mres[5] = pDb->CommitTransaction();
 
-	for(int i = 0; i < 4; i++) {
+	for(int i = 0; i < 6; i++) {
 		if (IsFailed(mres[i])) {
 			AppLogException("Failed to commit transaction for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(mres[i]));
 
@@ -601,6 +1454,10 @@ result NotesManager::RemoveAll(void) const {
 			return mres[i];
 		}
 	}
+
+	CollectAttachments(pDb);
+
+	delete pDb;
 	return E_SUCCESS;
 }
 
@@ -609,10 +1466,13 @@ result NotesManager::RemoveNote(Note *val) const {
 }
 
 result NotesManager::RemoveNote(int entry_id) const {
+	TRACE_SCOPE("db.remove_note");
+
 	if (entry_id < 0)
 		return E_INVALID_ARG;
 
 	Database *pDb = new Database;
+	Metrics::Add(METRIC_DB_OPENS);
 	result res = pDb->Construct(__dataPath, true);
 	if (IsFailed(res)) {
 		AppLogException("Failed to load database file at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
@@ -627,15 +1487,18 @@ result NotesManager::RemoveNote(int entry_id) const {
 		return res;
 	}
 
-	result mres[4];
+	result mres[6];
 	mres[0] = pDb->BeginTransaction();
+	mres[1] = BumpGeneration(pDb);
 
-	mres[1] = pDb->ExecuteSql(L"DELETE FROM entries WHERE entry_id=" + id, false);
-	mres[2] = pDb->ExecuteSql(L"DELETE FROM resource_entries WHERE entry_id=" + id, false);
+	//tombstone lets incremental backups know the note is gone
+	mres[2] = pDb->ExecuteSql(L"INSERT INTO removed_entries (entry_id, generation) VALUES (" + id + L", (SELECT generation FROM db_info))", false);
+	mres[3] = pDb->ExecuteSql(L"DELETE FROM entries WHERE entry_id=" + id, false);
+	mres[4] = pDb->ExecuteSql(L"DELETE FROM resource_entries WHERE entry_id=" + id, false);
 
-	mres[3] = pDb->CommitTransaction();
+	mres[5] = pDb->CommitTransaction();
 
-	for(int i = 0; i < 4; i++) {
+	for(int i = 0; i < 6; i++) {
 		if (IsFailed(mres[i])) {
 			AppLogException("Failed to commit transaction for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(mres[i]));
 
@@ -643,13 +1506,87 @@ result NotesManager::RemoveNote(int entry_id) const {
 			return mres[i];
 		}
 	}
+
+	CollectAttachments(pDb);
+
+	delete pDb;
 	return E_SUCCESS;
 }
 
 LinkedListT<Note *> *NotesManager::GetNotesN(SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter) const {
+	bool has_more = false;
+	return QueryNotesN(sorting, order, type_filter, filter_mode, filter, null, 0, -1, has_more);
+}
+
+LinkedListT<Note *> *NotesManager::GetNotesPageN(int offset, int limit, bool &hasMore, SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter) const {
+	if (offset < 0 || limit <= 0) {
+		SetLastResult(E_INVALID_ARG);
+		return null;
+	}
+	return QueryNotesN(sorting, order, type_filter, filter_mode, filter, null, offset, limit, hasMore);
+}
+
+LinkedListT<Note *> *NotesManager::GetNotesAfterN(NotesCursor &cursor, int limit, bool &hasMore, SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter) const {
+	if (limit <= 0) {
+		SetLastResult(E_INVALID_ARG);
+		return null;
+	}
+
+	//cursor taken under another ordering means nothing here, so start over
+	if (!cursor.Matches(sorting, order)) {
+		cursor.Reset();
+	}
+
+	LinkedListT<Note *> *pNotes = QueryNotesN(sorting, order, type_filter, filter_mode, filter, cursor.IsAtStart() ? null : &cursor, 0, limit, hasMore);
+	if (pNotes && pNotes->GetCount() > 0) {
+		Note *pLast = null;
+		pNotes->GetAt(pNotes->GetCount() - 1, pLast);
+		AdvanceCursor(cursor, pLast, sorting, order);
+	}
+	return pNotes;
+}
+
+void NotesManager::AdvanceCursor(NotesCursor &cursor, Note *pLast, SortType sorting, SortOrder order) const {
+	const ByteBuffer *pKey = sorting == SORT_BY_TITLE ? GetTitleKey(pLast) : null;
+	long long primary = sorting == SORT_BY_TYPE ? (long long)pLast->GetType() : pLast->GetDate();
+
+	cursor.Set(sorting, order, pLast->GetMarked(), primary, pKey, pLast->GetEntryId());
+}
+
+LinkedListT<Note *> *NotesManager::LoadNotesN(ILoadProgressListener *pListener) const {
+	int total = 0;
+
+	Database *pDb = new Database;
+	Metrics::Add(METRIC_DB_OPENS);
+	result res = pDb->Construct(__dataPath, false);
+	if (!IsFailed(res)) {
+		DbEnumerator *pEnum = pDb->QueryN(L"SELECT COUNT(*) FROM entries"); res = GetLastResult();
+		if (!IsFailed(res) && pEnum) {
+			if (!IsFailed(pEnum->MoveNext())) {
+				pEnum->GetIntAt(0, total);
+			}
+			delete pEnum;
+		}
+	}
+	delete pDb;
+	if (IsFailed(res)) {
+		//rows are still read, the listener just can't tell how far along they are
+		AppLogException("Failed to count notes for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+	}
+
+	bool has_more = false;
+	return QueryNotesN(SORT_BY_DATE, SORT_ORDER_DESCENDING, NOTE_TYPE_ALL, FILTER_BY_TITLE, L"", null, 0, -1, has_more, pListener, total);
+}
+
+LinkedListT<Note *> *NotesManager::QueryNotesN(SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter,
+											  const NotesCursor *pAfter, int offset, int limit, bool &hasMore, ILoadProgressListener *pListener, int total) const {
+	TRACE_SCOPE("db.get_notes");
+
+	hasMore = false;
 	LinkedListT<Note *> *pNotes = new LinkedListT<Note *>;
 
 	Database *pDb = new Database;
+	Metrics::Add(METRIC_DB_OPENS);
 	result res = pDb->Construct(__dataPath, false);
 	if (IsFailed(res)) {
 		AppLogException("Failed to load database file at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
@@ -661,78 +1598,242 @@ LinkedListT<Note *> *NotesManager::GetNotesN(SortType sorting, SortOrder order,
 		return null;
 	}
 
-	for (int i = 1; i > -1; i--) {
-		String query = L"SELECT entries.entry_id,entries.type,entries.timestamp,entries.marked,entries.title,entries.text, CASE "
-		"WHEN (entries.type = 2) OR (entries.type = 3) THEN (SELECT res_path FROM resource_entries WHERE resource_entries.entry_id = entries.entry_id) "
-		"ELSE '' "
-		"END FROM entries WHERE (entries.marked = ";
-		res = query.Append(i);
+	const mchar *sort_column = L"entries.timestamp";
+	if (sorting == SORT_BY_TITLE) {
+		sort_column = L"entries.title_key";
+	} else if (sorting == SORT_BY_TYPE) {
+		sort_column = L"entries.type";
+	}
+	const mchar *direction = order == SORT_ORDER_ASCENDING ? L"ASC" : L"DESC";
+	const mchar *after_op = order == SORT_ORDER_ASCENDING ? L">" : L"<";
+
+	//assembled on the stack, the only allocation is the final string
+	TextBuilder query;
+	res = query.Append(L"SELECT entries.entry_id,entries.type,entries.timestamp,entries.marked,entries.title,entries.text, CASE "
+	"WHEN (entries.type = 2) OR (entries.type = 3) THEN (SELECT res_path FROM resource_entries WHERE resource_entries.entry_id = entries.entry_id) "
+	"ELSE '' "
+	"END, entries.title_key, IFNULL((SELECT duration FROM audio_metadata WHERE audio_metadata.entry_id = entries.entry_id), -1) FROM entries WHERE 1 ");
+
+	if (!filter.IsEmpty()) {
+		if (filter_mode == FILTER_BY_TITLE) {
+			res = query.Append(L"AND (UPPER(entries.title) LIKE UPPER(?) ESCAPE '\\') ");
+		} else {
+			res = query.Append(L"AND (UPPER(entries.text) LIKE UPPER(?) ESCAPE '\\') ");
+		}
+	}
+	if (type_filter != NOTE_TYPE_ALL) {
+		res = query.Append(L"AND (entries.type = ");
+		res = query.Append((int)type_filter);
 		res = query.Append(L") ");
+	}
+	if (pAfter) {
+		//marked notes always come first, so everything past the cursor is either unmarked or further along by key
+		res = query.Append(L"AND ((entries.marked < ?) OR (entries.marked = ? AND ((");
+		res = query.Append(sort_column);
+		res = query.Append(after_op);
+		res = query.Append(L" ?) OR (");
+		res = query.Append(sort_column);
+		res = query.Append(L" = ? AND entries.entry_id ");
+		res = query.Append(after_op);
+		res = query.Append(L" ?)))) ");
+	}
+	//entry ID breaks ties, so pages never overlap or skip rows
+	res = query.Append(L"ORDER BY entries.marked DESC, ");
+	res = query.Append(sort_column);
+	res = query.Append(L" ");
+	res = query.Append(direction);
+	res = query.Append(L", entries.entry_id ");
+	res = query.Append(direction);
+	res = query.Append(L" LIMIT ? OFFSET ?");
+	//builder fails every append after the first failed one, so the last result covers them all
+	if (IsFailed(res)) {
+		AppLogException("Failed to construct query string, error: [%s]", GetErrorMessage(res));
 
-		if (!filter.IsEmpty()) {
-			if (filter_mode == FILTER_BY_TITLE) {
-				res = query.Append(L"AND (UPPER(entries.title) LIKE UPPER(?)) ");
-			} else {
-				res = query.Append(L"AND (UPPER(entries.text) LIKE UPPER(?)) ");
+		delete pNotes;
+		delete pDb;
+		SetLastResult(res);
+
+		return null;
+	}
+
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pStmt = pDb->CreateStatementN(query.ToString());
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to initialize query statement for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pNotes;
+		delete pDb;
+		SetLastResult(res);
+
+		return null;
+	}
+
+	int bind_index = 0;
+	if (!filter.IsEmpty()) {
+		//wildcards typed by the user are matched literally
+		TextBuilder esc;
+		esc.Append(L'%');
+		const mchar *pFilter = filter.GetPointer();
+		for (int i = 0; i < filter.GetLength(); i++) {
+			if (pFilter[i] == L'%' || pFilter[i] == L'_' || pFilter[i] == L'\\') {
+				esc.Append(L'\\');
 			}
+			esc.Append(pFilter[i]);
 		}
-		if (type_filter != NOTE_TYPE_ALL) {
-			res = query.Append(L"AND (entries.type = ");
-			res = query.Append((int)type_filter);
-			res = query.Append(") ");
+		res = esc.Append(L'%');
+
+		if (!IsFailed(res)) {
+			res = pStmt->BindString(bind_index++, esc.ToString());
 		}
-		if (sorting == SORT_BY_DATE) {
-			res = query.Append(L"ORDER BY entries.timestamp ");
-		} else if (sorting == SORT_BY_TITLE) {
-			res = query.Append(L"ORDER BY entries.title ");
+	}
+	if (!IsFailed(res) && pAfter) {
+		result bind_res[5];
+		bind_res[0] = pStmt->BindInt(bind_index++, pAfter->GetMarked() ? 1 : 0);
+		bind_res[1] = pStmt->BindInt(bind_index++, pAfter->GetMarked() ? 1 : 0);
+		if (sorting == SORT_BY_TITLE) {
+			const ByteBuffer *pKey = pAfter->GetTitleKey();
+			bind_res[2] = pKey ? pStmt->BindBlob(bind_index++, *pKey) : pStmt->BindNull(bind_index++);
+			bind_res[3] = pKey ? pStmt->BindBlob(bind_index++, *pKey) : pStmt->BindNull(bind_index++);
 		} else {
-			res = query.Append(L"ORDER BY entries.type ");
+			bind_res[2] = pStmt->BindInt64(bind_index++, pAfter->GetPrimary());
+			bind_res[3] = pStmt->BindInt64(bind_index++, pAfter->GetPrimary());
 		}
-		res = query.Append(order == SORT_ORDER_ASCENDING ? L"ASC" : L"DESC");
-		//'res' here can only be OUT_OF_MEMORY, thus check cumulatively
-		if (IsFailed(res)) {
-			AppLogException("Failed to construct query string, error: [%s]", GetErrorMessage(res));
+		bind_res[4] = pStmt->BindInt(bind_index++, pAfter->GetEntryId());
 
-			delete pNotes;
-			delete pDb;
-			SetLastResult(res);
-
-			return null;
+		for(int i = 0; i < 5 && !IsFailed(res); i++) {
+			res = bind_res[i];
 		}
+	}
+	if (!IsFailed(res)) {
+		//one extra row tells whether there is another page
+		res = pStmt->BindInt(bind_index++, limit < 0 ? -1 : limit + 1);
+	}
+	if (!IsFailed(res)) {
+		res = pStmt->BindInt(bind_index++, offset);
+	}
+	if (IsFailed(res)) {
+		AppLogException("Failed to bind transaction data for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
 
-		DbStatement *pStmt = pDb->CreateStatementN(query);
-		res = GetLastResult();
-		if (IsFailed(res)) {
-			AppLogException("Failed to initialize query statement for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+		delete pStmt;
+		delete pNotes;
+		delete pDb;
+		SetLastResult(res);
 
-			delete pNotes;
-			delete pDb;
-			SetLastResult(res);
+		return null;
+	}
 
-			return null;
-		}
+	DbEnumerator *pEnum = pDb->ExecuteStatementN(*pStmt);
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to execute query statement for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
 
-		if (!filter.IsEmpty()) {
-			String esc = L"%";
-			res = esc.Append(filter);
-			res = esc.Append('%');
+		delete pStmt;
+		delete pNotes;
+		delete pDb;
+		SetLastResult(res);
 
-			if (IsFailed(res)) {
-				delete pStmt;
-				delete pNotes;
-				delete pDb;
-				SetLastResult(res);
+		return null;
+	}
 
-				return null;
+	if (pEnum) {
+		int rows = 0;
+		long long text_bytes = 0;
+
+		while (!IsFailed(pEnum->MoveNext())) {
+			if (limit >= 0 && rows == limit) {
+				hasMore = true;
+				break;
+			}
+
+			Note *pNote = new Note;
+
+			int entry_id = -1;
+			int type = -1;
+			long long timestamp = 0;
+			int marked = 0;
+			String title;
+			String text;
+
+			result gres[6];
+			gres[0] = pEnum->GetIntAt(0, entry_id);
+			gres[1] = pEnum->GetIntAt(1, type);
+			gres[2] = pEnum->GetInt64At(2, timestamp);
+			gres[3] = pEnum->GetIntAt(3, marked);
+			gres[4] = pEnum->GetStringAt(4, title);
+			gres[5] = pEnum->GetStringAt(5, text);
+
+			for(int i = 0; i < 6; i++) {
+				if (IsFailed(gres[i])) {
+					AppLogException("Failed to retrieve query data for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(gres[i]));
+
+					delete pNote;
+					delete pEnum;
+					delete pStmt;
+					delete pNotes;
+					delete pDb;
+					SetLastResult(gres[i]);
+
+					return null;
+				}
+			}
+			pNote->Construct((NoteType)type);
+			pNote->SetEntryID(entry_id);
+			pNote->SetSerialized(true);
+			pNote->SetDate(timestamp);
+			pNote->SetMarked(marked);
+			pNote->SetTitle(title);
+			pNote->SetText(text);
+
+			//stored key is only missing if the store could not be updated on load
+			int key_size = pEnum->GetColumnSize(7);
+			if (key_size > 0) {
+				ByteBuffer *pKey = new ByteBuffer;
+				res = pKey->Construct(key_size);
+				if (!IsFailed(res)) {
+					res = pEnum->GetBlobAt(7, *pKey);
+				}
+				if (!IsFailed(res)) {
+					pKey->SetPosition(0);
+					pNote->SetTitleKey(pKey);
+				} else {
+					delete pKey;
+				}
 			}
 
-			if (!filter.IsEmpty()) {
-				res = pStmt->BindString(0, esc);
+			rows++;
+			text_bytes += (title.GetLength() + text.GetLength()) * sizeof(mchar);
+			if (pListener && rows % LOAD_PROGRESS_STEP == 0) {
+				pListener->OnLoadProgress(rows, total);
 			}
 
-			if (IsFailed(res)) {
-				AppLogException("Failed to bind transaction data for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+			if (type != NOTE_TYPE_TEXT) {
+				String res_path;
+				res = pEnum->GetStringAt(6, res_path);
+				if (IsFailed(res)) {
+					AppLogException("Failed to retrieve query data for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+					delete pNote;
+					delete pEnum;
+					delete pStmt;
+					delete pNotes;
+					delete pDb;
+					SetLastResult(res);
+
+					return null;
+				}
+				pNote->SetResourcePath(res_path);
+			}
+			if (type == NOTE_TYPE_AUDIO) {
+				int duration = -1;
+				pEnum->GetIntAt(8, duration);
+				pNote->SetAudioDuration(duration);
+			}
 
+			res = pNotes->Add(pNote);
+			if (IsFailed(res)) {
+				delete pNote;
+				delete pEnum;
 				delete pStmt;
 				delete pNotes;
 				delete pDb;
@@ -741,96 +1842,182 @@ LinkedListT<Note *> *NotesManager::GetNotesN(SortType sorting, SortOrder order,
 				return null;
 			}
 		}
+		Metrics::Add(METRIC_ROWS_READ, rows);
+		Metrics::Add(METRIC_TEXT_BYTES_LOADED, text_bytes);
+		if (pListener) {
+			pListener->OnLoadProgress(rows, total);
+		}
 
-		DbEnumerator *pEnum = pDb->ExecuteStatementN(*pStmt);
-		res = GetLastResult();
-		if (IsFailed(res)) {
-			AppLogException("Failed to execute query statement for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+		delete pEnum;
+	}
+	delete pStmt;
 
-			delete pStmt;
-			delete pNotes;
-			delete pDb;
-			SetLastResult(res);
+	delete pDb;
+	return pNotes;
+}
+
+result NotesManager::ExtractAudioInfo(int maxNotes, int &extracted) const {
+	TRACE_SCOPE("db.extract_audio_info");
+
+	extracted = 0;
+
+	Database *pDb = new Database;
+	Metrics::Add(METRIC_DB_OPENS);
+	result res = pDb->Construct(__dataPath, false);
+	if (IsFailed(res)) {
+		AppLogException("Failed to load database file at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pDb;
+		return res;
+	}
+
+	String query = L"SELECT resource_entries.entry_id, resource_entries.res_path FROM resource_entries, entries "
+	"WHERE entries.entry_id = resource_entries.entry_id AND entries.type = ";
+	query.Append((int)NOTE_TYPE_AUDIO);
+	query.Append(L" AND resource_entries.entry_id NOT IN (SELECT entry_id FROM audio_metadata) LIMIT ");
+	query.Append(maxNotes);
+
+	DbEnumerator *pEnum = pDb->QueryN(query);
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to query audio notes without metadata for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pDb;
+		return res;
+	}
+	if (!pEnum) {
+		delete pDb;
+		return E_SUCCESS;
+	}
 
-			return null;
+	//files are only opened once the query is done with
+	ArrayListT<int> ids;
+	ArrayListT<String> paths;
+	ids.Construct(maxNotes);
+	paths.Construct(maxNotes);
+	while (!IsFailed(pEnum->MoveNext())) {
+		int entry_id = -1;
+		String path;
+		if (!IsFailed(pEnum->GetIntAt(0, entry_id)) && !IsFailed(pEnum->GetStringAt(1, path))) {
+			ids.Add(entry_id);
+			paths.Add(path);
 		}
+	}
+	delete pEnum;
 
-		if (pEnum) {
-			while (!IsFailed(pEnum->MoveNext())) {
-				Note *pNote = new Note;
-
-				int entry_id = -1;
-				int type = -1;
-				long long timestamp = 0;
-				int marked = 0;
-				String title;
-				String text;
-
-				result gres[6];
-				gres[0] = pEnum->GetIntAt(0, entry_id);
-				gres[1] = pEnum->GetIntAt(1, type);
-				gres[2] = pEnum->GetInt64At(2, timestamp);
-				gres[3] = pEnum->GetIntAt(3, marked);
-				gres[4] = pEnum->GetStringAt(4, title);
-				gres[5] = pEnum->GetStringAt(5, text);
-
-				for(int i = 0; i < 6; i++) {
-					if (IsFailed(gres[i])) {
-						AppLogException("Failed to retrieve query data for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(gres[i]));
-
-						delete pNote;
-						delete pEnum;
-						delete pStmt;
-						delete pNotes;
-						delete pDb;
-						SetLastResult(gres[i]);
+	if (ids.GetCount() == 0) {
+		delete pDb;
+		return E_SUCCESS;
+	}
 
-						return null;
-					}
-				}
-				pNote->Construct((NoteType)type);
-				pNote->SetEntryID(entry_id);
-				pNote->SetSerialized(true);
-				pNote->SetDate(timestamp);
-				pNote->SetMarked(marked);
-				pNote->SetTitle(title);
-				pNote->SetText(text);
-
-				if (type != NOTE_TYPE_TEXT) {
-					String res_path;
-					res = pEnum->GetStringAt(6, res_path);
-					if (IsFailed(res)) {
-						AppLogException("Failed to retrieve query data for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+	Metrics::Add(METRIC_STATEMENTS_PREPARED);
+	DbStatement *pStmt = pDb->CreateStatementN(L"INSERT OR REPLACE INTO audio_metadata (entry_id, duration, size, envelope) VALUES (?, ?, ?, ?)");
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to initialize audio metadata statement for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
 
-						delete pNote;
-						delete pEnum;
-						delete pStmt;
-						delete pNotes;
-						delete pDb;
-						SetLastResult(res);
+		delete pDb;
+		return res;
+	}
 
-						return null;
-					}
-					pNote->SetResourcePath(res_path);
-				}
+	AudioInfo info;
+	for (int i = 0; i < ids.GetCount(); i++) {
+		int entry_id = -1;
+		String path;
+		ids.GetAt(i, entry_id);
+		paths.GetAt(i, path);
 
-				res = pNotes->Add(pNote);
-				if (IsFailed(res)) {
-					delete pNote;
-					delete pEnum;
-					delete pStmt;
-					delete pNotes;
-					delete pDb;
-					SetLastResult(res);
+		//unreadable media still gets a row, so it isn't retried on every pass
+		res = AudioInfoExtractor::Extract(path, info);
+		if (IsFailed(res)) {
+			AppLogException("Failed to extract audio metadata from [%S], error: [%s]", path.GetPointer(), GetErrorMessage(res));
+		}
 
-					return null;
+		result bind_res[4];
+		bind_res[0] = pStmt->BindInt(0, entry_id);
+		bind_res[1] = pStmt->BindInt(1, info.duration);
+		bind_res[2] = pStmt->BindInt64(2, info.size);
+		if (info.envelopeLength > 0) {
+			ByteBuffer envelope;
+			bind_res[3] = envelope.Construct(info.envelopeLength);
+			if (!IsFailed(bind_res[3])) {
+				envelope.SetArray(info.envelope, 0, info.envelopeLength);
+				envelope.Flip();
+				bind_res[3] = pStmt->BindBlob(3, envelope);
+			}
+		} else {
+			bind_res[3] = pStmt->BindNull(3);
+		}
+		res = E_SUCCESS;
+		for (int j = 0; j < 4 && !IsFailed(res); j++) {
+			res = bind_res[j];
+		}
+		if (!IsFailed(res)) {
+			pDb->ExecuteStatementN(*pStmt); res = GetLastResult();
+		}
+		if (IsFailed(res)) {
+			AppLogException("Failed to store audio metadata for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+			break;
+		}
+
+		extracted++;
+		OnAudioInfoExtracted(entry_id, info);
+	}
+	delete pStmt;
+
+	delete pDb;
+	return res;
+}
+
+result NotesManager::GetAudioInfo(int entry_id, AudioInfo &info) const {
+	info.duration = -1;
+	info.size = 0;
+	info.envelopeLength = 0;
+
+	Database *pDb = new Database;
+	Metrics::Add(METRIC_DB_OPENS);
+	result res = pDb->Construct(__dataPath, false);
+	if (IsFailed(res)) {
+		AppLogException("Failed to load database file at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pDb;
+		return res;
+	}
+
+	String query = L"SELECT duration, size, envelope FROM audio_metadata WHERE entry_id = ";
+	query.Append(entry_id);
+
+	DbEnumerator *pEnum = pDb->QueryN(query);
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to query audio metadata for database at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pDb;
+		return res;
+	}
+
+	res = E_OBJ_NOT_FOUND;
+	if (pEnum) {
+		if (!IsFailed(pEnum->MoveNext())) {
+			res = pEnum->GetIntAt(0, info.duration);
+			if (!IsFailed(res)) {
+				res = pEnum->GetInt64At(1, info.size);
+			}
+
+			int envelope_size = pEnum->GetColumnSize(2);
+			if (!IsFailed(res) && envelope_size > 0) {
+				if (envelope_size > AUDIO_ENVELOPE_POINTS) {
+					envelope_size = AUDIO_ENVELOPE_POINTS;
+				}
+				res = pEnum->GetBlobAt(2, info.envelope, envelope_size);
+				if (!IsFailed(res)) {
+					info.envelopeLength = envelope_size;
 				}
 			}
-			delete pEnum;
-			delete pStmt;
 		}
+		delete pEnum;
 	}
 
 	delete pDb;
-	return pNotes;
+	return res;
 }
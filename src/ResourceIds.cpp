@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+//Generated by tools/gen_resources.py from Res/*.xml, do not edit by hand.
+
+#include "ResourceIds.h"
+
+const mchar *const RES_LANGUAGE_CODES[RES_LANGUAGE_COUNT] = {
+	L"eng",
+	L"rus"
+};
+
+const mchar *const RES_STRING_IDS[STRING_COUNT] = {
+	L"MAINFORM_DIAGNOSTICS_DUMP_FAILED",
+	L"MAINFORM_DIAGNOSTICS_DUMP_SAVED",
+	L"MAINFORM_DIAGNOSTICS_TITLE",
+	L"MAINFORM_NOTES_LIST_HEADER_TITLE",
+	L"MAINFORM_NOTES_LIST_SHOW_MORE",
+	L"MAINFORM_OPTIONMENU_DIAGNOSTICS",
+	L"MAINFORM_OPTIONMENU_SEARCH_BY",
+	L"MAINFORM_OPTIONMENU_SEARCH_BY_TEXT",
+	L"MAINFORM_OPTIONMENU_SEARCH_BY_TITLE",
+	L"MAINFORM_OPTIONMENU_SORT_BY",
+	L"MAINFORM_OPTIONMENU_SORT_BY_DATE",
+	L"MAINFORM_OPTIONMENU_SORT_BY_TITLE",
+	L"MAINFORM_OPTIONMENU_SORT_BY_TYPE",
+	L"MAINFORM_OPTIONMENU_SOURCE",
+	L"MAINFORM_SEARCH_FIELD_GUIDE",
+	L"MAINFORM_SEARCH_FIELD_GUIDE_BY_TEXT",
+	L"MAINFORM_SEARCH_FIELD_GUIDE_BY_TITLE",
+	L"MAINFORM_SEARCH_KEYPAD_CLEAR",
+	L"MAINFORM_SEARCH_KEYPAD_SEARCH",
+	L"MAINFORM_SOFTKEY_ADD",
+	L"MAINFORM_STORE_OPENING_MSG",
+	L"MAINFORM_STORE_OPENING_TITLE",
+	L"MAINFORM_STORE_OPEN_FAILED_MSG",
+	L"MAINFORM_STORE_OPEN_FAILED_TITLE",
+	L"MAINFORM_TAB_TITLE_ALL",
+	L"MAINFORM_TAB_TITLE_AUDIO",
+	L"MAINFORM_TAB_TITLE_PHOTO",
+	L"MAINFORM_TAB_TITLE_TEXT",
+	L"SAVEFORM_ACCEPT_BUTTON",
+	L"SAVEFORM_CANCEL_BUTTON",
+	L"SAVEFORM_DIRLIST_TITLE",
+	L"SAVEFORM_DIR_ENTRY_APPFOLDER",
+	L"SAVEFORM_DIR_ENTRY_INFO",
+	L"SAVEFORM_DIR_ENTRY_INFO_COUNTING",
+	L"SAVEFORM_DIR_ENTRY_INFO_EMPTY",
+	L"SAVEFORM_DIR_ENTRY_INTMEM",
+	L"SAVEFORM_DIR_ENTRY_STORAGECARD",
+	L"SAVEFORM_FILENAME_FIELD_TITLE",
+	L"SAVEFORM_FILE_ENTRY_INFO_FORMAT",
+	L"SAVEFORM_INPUT_DIRNAME_ACCEPT_BUTTON",
+	L"SAVEFORM_INPUT_DIRNAME_MSG",
+	L"SAVEFORM_INPUT_DIRNAME_TITLE",
+	L"SAVEFORM_MBOX_DIR_MSG",
+	L"SAVEFORM_MBOX_DIR_TITLE",
+	L"SAVEFORM_MBOX_FILE_MSG",
+	L"SAVEFORM_MBOX_TEXT",
+	L"SAVEFORM_MBOX_TITLE",
+	L"SAVEFORM_NAVIGATE_BACK",
+	L"SAVEFORM_OPTIONMENU_CREATE_FOLDER",
+	L"SAVEFORM_TITLE",
+	L"SORT_TYPE_DATE",
+	L"SORT_TYPE_TITLE",
+	L"SORT_TYPE_TYPE",
+	L"TEXTNOTE_FORM_MBOX_MSG",
+	L"TEXTNOTE_FORM_SOFTKEY_ACCEPT_EDIT",
+	L"TEXTNOTE_FORM_SOFTKEY_ACCEPT_NEW",
+	L"TEXTNOTE_FORM_SOFTKEY_CANCEL",
+	L"TEXTNOTE_FORM_TEXT_CAPTION",
+	L"TEXTNOTE_FORM_TIME_CAPTION",
+	L"TEXTNOTE_FORM_TITLEFIELD_TITLE",
+	L"TEXTNOTE_FORM_TITLE_EDIT",
+	L"TEXTNOTE_FORM_TITLE_NEW"
+};
+
+const mchar *const RES_STRINGS[RES_LANGUAGE_COUNT][STRING_COUNT] = {
+	{
+		L"Failed to save metrics file",
+		L"Saved to ",
+		L"Diagnostics",
+		L"Sorting by ",
+		L"Show more...",
+		L"Diagnostics",
+		L"Search by...",
+		L"Content",
+		L"Title",
+		L"Sort by...",
+		L"Date",
+		L"Title",
+		L"Type",
+		L"Change storage file...",
+		L"Search by ",
+		L"content...",
+		L"title...",
+		L"Clear",
+		L"Search",
+		L"Add",
+		L"Opening notes storage...",
+		L"Changing storage",
+		L"Selected file could not be opened as notes storage",
+		L"Error",
+		L"All notes",
+		L"Recordings",
+		L"Photos",
+		L"Texts",
+		L"Save",
+		L"Cancel",
+		L"Select directory:",
+		L"Application Folder",
+		L"Total elements: ",
+		L"Counting elements...",
+		L"Empty folder",
+		L"Internal Memory",
+		L"Storage Card",
+		L"Enter filename:",
+		L"%uKb  Last modified: %ls",
+		L"Create",
+		L"Enter directory name to be created:",
+		L"Enter directory name",
+		L"You can't create directory without a name!",
+		L"Error",
+		L"You must enter file name or select file from the list!",
+		L"Are you sure you want to overwrite existing file?",
+		L"Warning",
+		L"Back",
+		L"Create folder",
+		L"Save as...",
+		L"date",
+		L"title",
+		L"type",
+		L"You can't create empty note!",
+		L"Save",
+		L"Create",
+		L"Cancel",
+		L"Enter text here:",
+		L"Last modified on:",
+		L"Enter title:",
+		L"Edit note",
+		L"Create note"
+	},
+	{
+		L"Не удалось сохранить файл метрик",
+		L"Сохранено в ",
+		L"Диагностика",
+		L"Сортировка по ",
+		L"Показать ещё...",
+		L"Диагностика",
+		L"Искать по...",
+		L"Содержимому",
+		L"Заголовкам",
+		L"Упорядочить по...",
+		L"Датам",
+		L"Заголовкам",
+		L"Типам",
+		L"Изменить файл данных...",
+		L"Поиск по ",
+		L"тексту...",
+		L"заголовкам...",
+		L"Очистить",
+		L"Поиск",
+		L"Добавить",
+		L"Открытие хранилища заметок...",
+		L"Смена хранилища",
+		L"Не удалось открыть выбранный файл как хранилище заметок",
+		L"Ошибка",
+		L"Все Notes",
+		L"Аудиозаписи",
+		L"Фотографии",
+		L"Тексты",
+		L"Сохранить",
+		L"Отмена",
+		L"Выберите директорию:",
+		L"Папка приложения",
+		L"Всего элементов: ",
+		L"Подсчёт элементов...",
+		L"Пустая папка",
+		L"Память устройства",
+		L"Карта памяти",
+		L"Введите имя файла:",
+		L"%uКБ  Изменен: %ls",
+		L"Создать",
+		L"Введите имя папки для создания:",
+		L"Введите имя папки",
+		L"Нельзя создать директорию с пустым наименованием!",
+		L"Ошибка",
+		L"Вы должны указать имя файла или выбрать файл из списка!",
+		L"Вы уверены, что хотите перезаписать существующий файл?",
+		L"Внимание",
+		L"Назад",
+		L"Создать папку",
+		L"Сохранить как...",
+		L"датам",
+		L"заголовкам",
+		L"типам",
+		L"Нельзя создать пустую заметку!",
+		L"Сохранить",
+		L"Создать",
+		L"Отмена",
+		L"Введите текст Notes:",
+		L"Последнее изменение:",
+		L"Введите заголовок:",
+		L"Редактирование Notes",
+		L"Создание Notes"
+	}
+};
+
+const ResContainerStrings RES_CONTAINERS[RES_CONTAINER_COUNT] = {
+	{ IDF_MAINFORM, -1, { -1, -1 }, 0, null },
+	{ IDF_SAVEFORM, -1, { -1, -1 }, 0, null },
+	{ IDF_TEXTNOTE_FORM, -1, { -1, -1 }, 0, null },
+	{ IDP_INPUT_POPUP, -1, { -1, -1 }, 0, null }
+};
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string.h>
+
+#include "ResultSetCache.h"
+
+bool ResultSetKey::Equals(const ResultSetKey &other) const {
+	return sorting == other.sorting && order == other.order && typeFilter == other.typeFilter &&
+		   filterMode == other.filterMode && filter.Equals(other.filter, true);
+}
+
+ResultSetCache::ResultSetCache(void) {
+	__pEntries = null;
+	__maxEntries = 0;
+	__maxKeys = 0;
+	__keyCount = 0;
+}
+
+ResultSetCache::~ResultSetCache(void) {
+	if (__pEntries) {
+		Clear();
+		delete __pEntries;
+	}
+}
+
+result ResultSetCache::Construct(int maxEntries, int maxKeys) {
+	if (maxEntries <= 0 || maxKeys <= 0) {
+		return E_INVALID_ARG;
+	}
+
+	__pEntries = new ArrayListT<Entry *>;
+	result res = __pEntries->Construct(maxEntries);
+	if (IsFailed(res)) {
+		AppLogException("Failed to construct result set list, error: [%s]", GetErrorMessage(res));
+
+		delete __pEntries;
+		__pEntries = null;
+		return res;
+	}
+
+	__maxEntries = maxEntries;
+	__maxKeys = maxKeys;
+	return E_SUCCESS;
+}
+
+const NoteSortKey *ResultSetCache::Find(const ResultSetKey &key, unsigned int epoch, int &count) {
+	count = 0;
+	if (!__pEntries) {
+		return null;
+	}
+
+	for (int i = 0; i < __pEntries->GetCount(); i++) {
+		Entry *pEntry = null;
+		__pEntries->GetAt(i, pEntry);
+		if (!pEntry->key.Equals(key)) {
+			continue;
+		}
+
+		//keys of a stale set may point into notes that changed since
+		if (pEntry->epoch != epoch) {
+			RemoveAt(i);
+			return null;
+		}
+
+		if (i > 0) {
+			__pEntries->RemoveAt(i);
+			__pEntries->InsertAt(pEntry, 0);
+		}
+		count = pEntry->count;
+		return pEntry->pKeys;
+	}
+	return null;
+}
+
+result ResultSetCache::Put(const ResultSetKey &key, unsigned int epoch, const NoteSortKey *pKeys, int count) {
+	if (!__pEntries) {
+		return E_INVALID_STATE;
+	}
+	if (count > __maxKeys) {
+		return E_OVERFLOW;
+	}
+
+	for (int i = 0; i < __pEntries->GetCount(); i++) {
+		Entry *pEntry = null;
+		__pEntries->GetAt(i, pEntry);
+		if (pEntry->key.Equals(key)) {
+			RemoveAt(i);
+			break;
+		}
+	}
+
+	while (__pEntries->GetCount() > 0 && (__pEntries->GetCount() >= __maxEntries || __keyCount + count > __maxKeys)) {
+		RemoveAt(__pEntries->GetCount() - 1);
+	}
+
+	NoteSortKey *pCopy = null;
+	if (count > 0) {
+		pCopy = new NoteSortKey[count];
+		if (!pCopy) {
+			return E_OUT_OF_MEMORY;
+		}
+		memcpy(pCopy, pKeys, count * sizeof(NoteSortKey));
+	}
+
+	Entry *pEntry = new Entry;
+	pEntry->pKeys = pCopy;
+	pEntry->key = key;
+	pEntry->epoch = epoch;
+	pEntry->count = count;
+
+	result res = __pEntries->InsertAt(pEntry, 0);
+	if (IsFailed(res)) {
+		if (pEntry->pKeys) delete[] pEntry->pKeys;
+		delete pEntry;
+		return res;
+	}
+	__keyCount += count;
+
+	return E_SUCCESS;
+}
+
+void ResultSetCache::Clear(void) {
+	if (__pEntries) {
+		while (__pEntries->GetCount() > 0) {
+			RemoveAt(__pEntries->GetCount() - 1);
+		}
+	}
+}
+
+void ResultSetCache::RemoveAt(int index) {
+	Entry *pEntry = null;
+	if (IsFailed(__pEntries->GetAt(index, pEntry))) {
+		return;
+	}
+	__pEntries->RemoveAt(index);
+
+	__keyCount -= pEntry->count;
+	if (pEntry->pKeys) delete[] pEntry->pKeys;
+	delete pEntry;
+}
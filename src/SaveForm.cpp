@@ -23,6 +23,25 @@
 using namespace Osp::Io;
 using namespace Osp::Base::Utility;
 
+static const int ROOT_DIR_COUNT = 3;
+static const mchar *ROOT_DIR_PATHS[ROOT_DIR_COUNT] = {
+	L"/Home/",
+	L"/Media/Others/",
+	L"/Storagecard/Media/Others/"
+};
+static const StringId ROOT_DIR_NAMES[ROOT_DIR_COUNT] = {
+	STR_SAVEFORM_DIR_ENTRY_APPFOLDER,
+	STR_SAVEFORM_DIR_ENTRY_INTMEM,
+	STR_SAVEFORM_DIR_ENTRY_STORAGECARD
+};
+static const mchar *ICON_NAMES[] = {
+	L"folder_icon.png",
+	L"folder_icon_intm.png",
+	L"folder_icon_mc.png",
+	L"file_icon.png",
+	L"dir_up_icon.png"
+};
+
 SaveForm::SaveForm(CallbackInfo cbInfo, const String &startingPath) {
 	__pFilenameField = null;
 	__pDirListCaption = null;
@@ -34,6 +53,13 @@ SaveForm::SaveForm(CallbackInfo cbInfo, const String &startingPath) {
 	__pCurrentDirList = null;
 	__pCurrentFileList = null;
 	__pNavigationHistory = null;
+	__rootListed = false;
+
+	for (int i = 0; i < ICON_COUNT; i++) {
+		__pIcons[i] = null;
+	}
+	__pCounter = null;
+	__pListings = null;
 
 	__cbInfo = cbInfo;
 	__startingPath = startingPath;
@@ -46,6 +72,23 @@ SaveForm::~SaveForm(void) {
 	if (__pCurrentDirList) delete __pCurrentDirList;
 	if (__pCurrentFileList) delete __pCurrentFileList;
 	if (__pNavigationHistory) delete __pNavigationHistory;
+
+	if (__pCounter) {
+		__pCounter->Stop();
+		__pCounter->Join();
+		delete __pCounter;
+	}
+	for (int i = 0; i < ICON_COUNT; i++) {
+		if (__pIcons[i]) delete __pIcons[i];
+	}
+	if (__pListings) {
+		for (int i = 0; i < __pListings->GetCount(); i++) {
+			DirListing *pListing = null;
+			__pListings->GetAt(i, pListing);
+			DeleteListing(pListing);
+		}
+		delete __pListings;
+	}
 }
 
 result SaveForm::Construct(void) {
@@ -53,15 +96,15 @@ result SaveForm::Construct(void) {
 		AppLogException("Attempt to construct dialog form without callback handler, callback will not be sent!");
 	}
 
-	result res = Form::Construct(L"IDF_SAVEFORM");
+	result res = Form::Construct(IDF_SAVEFORM);
 	if (IsFailed(res)) {
 		AppLogException("Failed to construct form's XML structure, error [%s]", GetErrorMessage(res));
 		return res;
 	}
 
-	__pFilenameField = static_cast<EditField*>(GetControl(L"IDC_SAVEFORM_FILENAME_FIELD"));
-	__pDirListCaption = static_cast<Label*>(GetControl(L"IDC_SAVEFORM_DIRLIST_CAPTION"));
-	__pDirList = static_cast<CustomList*>(GetControl(L"IDC_SAVEFORM_DIRLIST"));
+	__pFilenameField = static_cast<EditField*>(GetControl(IDC_SAVEFORM_FILENAME_FIELD));
+	__pDirListCaption = static_cast<Label*>(GetControl(IDC_SAVEFORM_DIRLIST_CAPTION));
+	__pDirList = static_cast<CustomList*>(GetControl(IDC_SAVEFORM_DIRLIST));
 
 	if (!CheckControls()) {
 		AppLogException("Failed to initialize custom form structure");
@@ -74,7 +117,7 @@ result SaveForm::Construct(void) {
 		AppLogException("Failed to construct option menu, error: [%s]", GetErrorMessage(res));
 		return E_INIT_FAILED;
 	}
-	__pOptionMenu->AddItem(GetString(L"SAVEFORM_OPTIONMENU_CREATE_FOLDER"),ID_OPTION_CREATE_FOLDER_CLICKED);
+	__pOptionMenu->AddItem(GetString(STR_SAVEFORM_OPTIONMENU_CREATE_FOLDER),ID_OPTION_CREATE_FOLDER_CLICKED);
 
 	__pDirListItemFormat = new CustomListItemFormat;
 	res = __pDirListItemFormat->Construct();
@@ -91,6 +134,30 @@ result SaveForm::Construct(void) {
 	__pCurrentDirList = new LinkedList;
 	__pCurrentFileList = new LinkedList;
 	__pNavigationHistory = new Stack;
+	__pListings = new ArrayListT<DirListing *>;
+	__pListings->Construct(MAX_CACHED_LISTINGS);
+
+	for (int i = 0; i < ICON_COUNT; i++) {
+		__pIcons[i] = GetBitmapN(ICON_NAMES[i]);
+		res = GetLastResult();
+		if (IsFailed(res)) {
+			AppLogException("Failed to acquire icons for directory list items, error [%s]", GetErrorMessage(res));
+			return res;
+		}
+	}
+
+	__pCounter = new DirectoryCounter;
+	res = __pCounter->Construct(DirectoryCounter::DEFAULT_MAX_ENTRIES, this);
+	if (!IsFailed(res)) {
+		res = __pCounter->Start();
+	}
+	if (IsFailed(res)) {
+		//directories are then counted in place, as slow as it is
+		AppLogException("Failed to start directory counter, error: [%s]", GetErrorMessage(res));
+
+		delete __pCounter;
+		__pCounter = null;
+	}
 
 	return E_SUCCESS;
 }
@@ -101,168 +168,107 @@ bool SaveForm::CheckControls(void) const {
 	} else return false;
 }
 
-int SaveForm::GetDirectoryElementsCount(const String &dir) const {
-	Directory *pDir = new Directory;
-	result res = pDir->Construct(dir);
-	if (IsFailed(res)) {
-		AppLogException("Failed to construct directory object for path [%S], error: [%s]", dir.GetPointer(), GetErrorMessage(res));
-
-		delete pDir;
-
-		SetLastResult(res);
-		return -1;
+String SaveForm::GetElementsInfo(int count, bool counted) {
+	if (count > 0) {
+		String elements = GetString(STR_SAVEFORM_DIR_ENTRY_INFO); elements.Append(count);
+		return elements;
+	} else if (count == 0) {
+		return GetString(STR_SAVEFORM_DIR_ENTRY_INFO_EMPTY);
+	} else if (!counted) {
+		return GetString(STR_SAVEFORM_DIR_ENTRY_INFO_COUNTING);
 	}
+	return L"";
+}
 
-	DirEnumerator *pDirEnum = pDir->ReadN();
-	res = GetLastResult();
+CustomListItem *SaveForm::CreateDirItemN(int itemId, const String &path, int count, bool counted) {
+	CustomListItem *pItem = new CustomListItem;
+	result res = pItem->Construct(90);
 	if (IsFailed(res)) {
-		AppLogException("Failed to construct directory enumerator for path [%S], error: [%s]", dir.GetPointer(), GetErrorMessage(res));
-
-		delete pDir;
+		AppLogException("Failed to construct directory list item, error: [%s]", GetErrorMessage(res));
 
+		delete pItem;
 		SetLastResult(res);
-		return -1;
+		return null;
 	}
 
-	int count = 0;
-	while (!IsFailed(pDirEnum->MoveNext())) {
-		DirEntry entry = pDirEnum->GetCurrentDirEntry();
-		if (entry.GetName().Equals(String(L".")) || entry.GetName().Equals(String(L".."))) {
-			continue;
-		}
-		count++;
-	}
+	pItem->SetItemFormat(*__pDirListItemFormat);
+	if (__rootListed) {
+		Bitmap *pIcon = __pIcons[itemId == 2 ? ICON_FOLDER_MC : (itemId == 1 ? ICON_FOLDER_INTM : ICON_FOLDER)];
+		pItem->SetElement(ID_DIRLIST_FORMAT_BITMAP, *pIcon, pIcon);
+		pItem->SetElement(ID_DIRLIST_FORMAT_NAME, GetString(ROOT_DIR_NAMES[itemId]));
+	} else {
+		//path always ends with a slash, name is whatever precedes it
+		int slash = -1;
+		path.LastIndexOf('/', path.GetLength() - 2, slash);
 
-	delete pDir;
-	delete pDirEnum;
+		String name;
+		path.SubString(slash + 1, path.GetLength() - slash - 2, name);
 
-	return count;
+		pItem->SetElement(ID_DIRLIST_FORMAT_BITMAP, *__pIcons[ICON_FOLDER], __pIcons[ICON_FOLDER]);
+		pItem->SetElement(ID_DIRLIST_FORMAT_NAME, name);
+	}
+	pItem->SetElement(ID_DIRLIST_FORMAT_ELEMENTS, GetElementsInfo(count, counted));
+
+	return pItem;
 }
 
 result SaveForm::FillRootDirList(void) {
+	if (__pCounter) {
+		__pCounter->CancelPending();
+	}
 	__pCurrentDirList->RemoveAll(true);
 	__pCurrentFileList->RemoveAll(true);
 	__pDirList->RemoveAllItems();
+	__rootListed = true;
 
-	Bitmap *pFolder = GetBitmapN(L"folder_icon.png");
-	result res = GetLastResult();
-	if (IsFailed(res)) {
-		AppLogException("Failed to acquire icons for directory list items, error [%s]", GetErrorMessage(res));
-		return res;
-	}
-
-	Bitmap *pFolderMC = GetBitmapN(L"folder_icon_mc.png");
-
-	res = GetLastResult();
-	if (IsFailed(res)) {
-		AppLogException("Failed to acquire icons for directory list items, error [%s]", GetErrorMessage(res));
-		delete pFolder;
-		return res;
-	}
-
-	Bitmap *pFolderIntM = GetBitmapN(L"folder_icon_intm.png");
-
-	res = GetLastResult();
-	if (IsFailed(res)) {
-		AppLogException("Failed to acquire icons for directory list items, error [%s]", GetErrorMessage(res));
-		delete pFolder;
-		delete pFolderMC;
-		return res;
-	}
-
-	String *paths[3] = {
-		new String(L"/Home/"),
-		new String(L"/Media/Others/"),
-		new String(L"/Storagecard/Media/Others/")
-	};
-
-	String path_names[3] = {
-		GetString(L"SAVEFORM_DIR_ENTRY_APPFOLDER"),
-		GetString(L"SAVEFORM_DIR_ENTRY_INTMEM"),
-		GetString(L"SAVEFORM_DIR_ENTRY_STORAGECARD")
-	};
-
-	for(int i = 0; i < 3; i++) {
-		CustomListItem *pItem = new CustomListItem;
-		res = pItem->Construct(90);
-		if (IsFailed(res)) {
-			AppLogException("Failed to construct directory list item, error: [%s]", GetErrorMessage(res));
-			delete pItem;
-			break;
+	result res = E_SUCCESS;
+	for(int i = 0; i < ROOT_DIR_COUNT; i++) {
+		//item IDs index this list, so it keeps paths of missing roots too
+		__pCurrentDirList->Add(*(new String(ROOT_DIR_PATHS[i])));
+		if (!File::IsFileExist(ROOT_DIR_PATHS[i])) {
+			continue;
 		}
 
-		pItem->SetItemFormat(*__pDirListItemFormat);
-		if (i == 2) {
-			pItem->SetElement(ID_DIRLIST_FORMAT_BITMAP, *pFolderMC, pFolderMC);
-		} else if (i == 1) {
-			pItem->SetElement(ID_DIRLIST_FORMAT_BITMAP, *pFolderIntM, pFolderIntM);
-		} else {
-			pItem->SetElement(ID_DIRLIST_FORMAT_BITMAP, *pFolder, pFolder);
-		}
-		pItem->SetElement(ID_DIRLIST_FORMAT_NAME, path_names[i]);
+		//counts of slow media are filled in once the counter gets to them
+		int count = __pCounter ? __pCounter->GetCount(ROOT_DIR_PATHS[i]) : DirectoryCounter::CountElements(ROOT_DIR_PATHS[i]);
 
-		int count = GetDirectoryElementsCount(*paths[i]);
-		if (count < 0) {
-			AppLogException("Failed to enumerate directory elements for path [%S], error: [%s]", paths[i]->GetPointer(), GetErrorMessage(res));
+		CustomListItem *pItem = CreateDirItemN(i, ROOT_DIR_PATHS[i], count, !__pCounter || count >= 0);
+		if (!pItem) {
 			res = GetLastResult();
-
-			delete pItem;
 			break;
-		} else if (count > 0) {
-			String elements = GetString(L"SAVEFORM_DIR_ENTRY_INFO"); elements.Append(count);
-			pItem->SetElement(ID_DIRLIST_FORMAT_ELEMENTS, elements);
-		} else {
-			pItem->SetElement(ID_DIRLIST_FORMAT_ELEMENTS, GetString(L"SAVEFORM_DIR_ENTRY_INFO_EMPTY"));
 		}
-
 		__pDirList->AddItem(*pItem, i);
-		__pCurrentDirList->Add(*paths[i]);
 	}
 
-	delete pFolder;
-	delete pFolderMC;
-	delete pFolderIntM;
-
 	SetFormStyle(GetFormStyle() & ~FORM_STYLE_OPTIONKEY);
 	RefreshForm();
 	return res;
 }
 
-result SaveForm::FillDirList(const String &dir) {
-	if (dir.Equals(String(L"/"))) {
-		return FillRootDirList();
-	}
-
-	__pCurrentDirList->RemoveAll(true);
-	__pCurrentFileList->RemoveAll(true);
-	__pDirList->RemoveAllItems();
-
-	Bitmap *pFile = GetBitmapN(L"file_icon.png");
-	result res = GetLastResult();
+SaveForm::DirListing *SaveForm::GetListing(const String &dir) {
+	FileAttributes attr;
+	result res = File::GetAttributes(dir, attr);
 	if (IsFailed(res)) {
-		AppLogException("Failed to acquire icons for directory list items, error [%s]", GetErrorMessage(res));
-		return res;
-	}
-
-	Bitmap *pFolder = GetBitmapN(L"folder_icon.png");
+		AppLogException("Failed to get attributes of directory [%S], error: [%s]", dir.GetPointer(), GetErrorMessage(res));
 
-	res = GetLastResult();
-	if (IsFailed(res)) {
-		AppLogException("Failed to acquire icons for directory list items, error [%s]", GetErrorMessage(res));
-		delete pFile;
-		return res;
+		SetLastResult(res);
+		return null;
 	}
 
-	Bitmap *pBack = GetBitmapN(L"dir_up_icon.png");
-
-	res = GetLastResult();
-	if (IsFailed(res)) {
-		AppLogException("Failed to acquire icons for directory list items, error [%s]", GetErrorMessage(res));
-
-		delete pFile;
-		delete pFolder;
+	for (int i = 0; i < __pListings->GetCount(); i++) {
+		DirListing *pListing = null;
+		__pListings->GetAt(i, pListing);
+		if (!pListing->path.Equals(dir, true)) {
+			continue;
+		}
 
-		return res;
+		__pListings->RemoveAt(i);
+		if (pListing->modified == attr.GetLastModifiedTime()) {
+			__pListings->InsertAt(pListing, 0);
+			return pListing;
+		}
+		DeleteListing(pListing);
+		break;
 	}
 
 	Directory *pDir = new Directory;
@@ -270,12 +276,9 @@ result SaveForm::FillDirList(const String &dir) {
 	if (IsFailed(res)) {
 		AppLogException("Failed to construct directory object for path [%S], error: [%s]", dir.GetPointer(), GetErrorMessage(res));
 
-		delete pFile;
-		delete pFolder;
-		delete pBack;
 		delete pDir;
-
-		return res;
+		SetLastResult(res);
+		return null;
 	}
 
 	DirEnumerator *pEnum = pDir->ReadN();
@@ -283,81 +286,146 @@ result SaveForm::FillDirList(const String &dir) {
 	if (IsFailed(res)) {
 		AppLogException("Failed to construct directory enumerator for path [%S], error: [%s]", dir.GetPointer(), GetErrorMessage(res));
 
-		delete pFile;
-		delete pFolder;
-		delete pBack;
 		delete pDir;
-
-		return res;
+		SetLastResult(res);
+		return null;
 	}
 
-	int i = 0;
-	int j = -2;
+	DirListing *pListing = new DirListing;
+	pListing->path = dir;
+	pListing->modified = attr.GetLastModifiedTime();
+	pListing->hasParent = false;
+
 	while (!IsFailed(pEnum->MoveNext())) {
 		DirEntry entry = pEnum->GetCurrentDirEntry();
 		if (entry.GetName().Equals(String(L"."))) {
 			continue;
 		}
 
+		if (entry.GetName().Equals(String(L".."))) {
+			pListing->hasParent = true;
+		} else if (entry.IsDirectory()) {
+			String *pPath = new String(dir);
+			pPath->Append(entry.GetName());
+			pPath->Append('/');
+
+			pListing->dirs.Add(*pPath);
+		} else {
+			String *pInfo = new String;
+			pInfo->Format(60, GetString(STR_SAVEFORM_FILE_ENTRY_INFO_FORMAT).GetPointer(), (entry.GetFileSize() / 1024), entry.GetDateTime().ToString().GetPointer());
+
+			pListing->fileNames.Add(*(new String(entry.GetName())));
+			pListing->fileInfos.Add(*pInfo);
+		}
+	}
+
+	delete pEnum;
+	delete pDir;
+
+	while (__pListings->GetCount() >= MAX_CACHED_LISTINGS) {
+		DirListing *pLast = null;
+		__pListings->GetAt(__pListings->GetCount() - 1, pLast);
+		__pListings->RemoveAt(__pListings->GetCount() - 1);
+		DeleteListing(pLast);
+	}
+	__pListings->InsertAt(pListing, 0);
+
+	return pListing;
+}
+
+void SaveForm::DropListing(const String &dir) {
+	for (int i = 0; i < __pListings->GetCount(); i++) {
+		DirListing *pListing = null;
+		__pListings->GetAt(i, pListing);
+		if (pListing->path.Equals(dir, true)) {
+			__pListings->RemoveAt(i);
+			DeleteListing(pListing);
+			return;
+		}
+	}
+}
+
+void SaveForm::DeleteListing(DirListing *pListing) {
+	pListing->dirs.RemoveAll(true);
+	pListing->fileNames.RemoveAll(true);
+	pListing->fileInfos.RemoveAll(true);
+	delete pListing;
+}
+
+result SaveForm::FillDirList(const String &dir) {
+	if (dir.Equals(String(L"/"))) {
+		return FillRootDirList();
+	}
+
+	DirListing *pListing = GetListing(dir);
+	if (!pListing) {
+		return GetLastResult();
+	}
+
+	if (__pCounter) {
+		__pCounter->CancelPending();
+	}
+	__pCurrentDirList->RemoveAll(true);
+	__pCurrentFileList->RemoveAll(true);
+	__pDirList->RemoveAllItems();
+	__rootListed = false;
+
+	result res = E_SUCCESS;
+	if (pListing->hasParent) {
 		CustomListItem *pItem = new CustomListItem;
 		res = pItem->Construct(90);
 		if (IsFailed(res)) {
 			AppLogException("Failed to construct directory list item, error: [%s]", GetErrorMessage(res));
 			delete pItem;
-			break;
-		}
-
-		pItem->SetItemFormat(*__pDirListItemFormat);
-
-		if (entry.GetName().Equals(String(L".."))) {
-			pItem->SetElement(ID_DIRLIST_FORMAT_NAME, GetString(L"SAVEFORM_NAVIGATE_BACK"));
-			pItem->SetElement(ID_DIRLIST_FORMAT_BITMAP, *pBack, pBack);
+		} else {
+			pItem->SetItemFormat(*__pDirListItemFormat);
+			pItem->SetElement(ID_DIRLIST_FORMAT_NAME, GetString(STR_SAVEFORM_NAVIGATE_BACK));
+			pItem->SetElement(ID_DIRLIST_FORMAT_BITMAP, *__pIcons[ICON_BACK], __pIcons[ICON_BACK]);
 			pItem->SetElement(ID_DIRLIST_FORMAT_ELEMENTS, *(static_cast<const String*>(__pNavigationHistory->Peek())));
 
 			__pDirList->AddItem(*pItem, -1);
-		} else if (entry.IsDirectory()) {
-			pItem->SetElement(ID_DIRLIST_FORMAT_NAME, entry.GetName());
-			pItem->SetElement(ID_DIRLIST_FORMAT_BITMAP, *pFolder, pFolder);
-
-			String path = dir;
-			path.Append(entry.GetName());
-			path.Append('/');
-
-			int count = GetDirectoryElementsCount(path);
-			if (count < 0) {
-				AppLogException("Failed to enumerate directory elements for path [%S], error: [%s]", path.GetPointer(), GetErrorMessage(res));
-				res = GetLastResult();
-
-				delete pItem;
-				break;
-			} else if (count > 0) {
-				String elements = GetString(L"SAVEFORM_DIR_ENTRY_INFO"); elements.Append(count);
-				pItem->SetElement(ID_DIRLIST_FORMAT_ELEMENTS, elements);
-			} else {
-				pItem->SetElement(ID_DIRLIST_FORMAT_ELEMENTS, GetString(L"SAVEFORM_DIR_ENTRY_INFO_EMPTY"));
-			}
-
-			__pCurrentDirList->Add(*(new String(path)));
-			__pDirList->AddItem(*pItem, i++);
-		} else {
-			pItem->SetElement(ID_DIRLIST_FORMAT_NAME, entry.GetName());
-			pItem->SetElement(ID_DIRLIST_FORMAT_BITMAP, *pFile, pFile);
+		}
+	}
 
-			String info;
-			info.Format(60, GetString(L"SAVEFORM_FILE_ENTRY_INFO_FORMAT").GetPointer(), (entry.GetFileSize() / 1024), entry.GetDateTime().ToString().GetPointer());
+	IEnumerator *pDirs = pListing->dirs.GetEnumeratorN();
+	for (int i = 0; !IsFailed(res) && pDirs && !IsFailed(pDirs->MoveNext()); i++) {
+		const String *pPath = static_cast<const String*>(pDirs->GetCurrent());
+		__pCurrentDirList->Add(*(new String(*pPath)));
 
-			pItem->SetElement(ID_DIRLIST_FORMAT_ELEMENTS, info);
+		int count = __pCounter ? __pCounter->GetCount(*pPath) : DirectoryCounter::CountElements(*pPath);
 
-			__pCurrentFileList->Add(*(new String(entry.GetName())));
-			__pDirList->AddItem(*pItem, j--);
+		CustomListItem *pItem = CreateDirItemN(i, *pPath, count, !__pCounter || count >= 0);
+		if (!pItem) {
+			res = GetLastResult();
+			break;
 		}
+		__pDirList->AddItem(*pItem, i);
 	}
+	if (pDirs) delete pDirs;
 
-	delete pFile;
-	delete pFolder;
-	delete pBack;
-	delete pEnum;
-	delete pDir;
+	IEnumerator *pNames = pListing->fileNames.GetEnumeratorN();
+	IEnumerator *pInfos = pListing->fileInfos.GetEnumeratorN();
+	for (int j = -2; !IsFailed(res) && pNames && pInfos && !IsFailed(pNames->MoveNext()) && !IsFailed(pInfos->MoveNext()); j--) {
+		const String *pName = static_cast<const String*>(pNames->GetCurrent());
+
+		CustomListItem *pItem = new CustomListItem;
+		res = pItem->Construct(90);
+		if (IsFailed(res)) {
+			AppLogException("Failed to construct directory list item, error: [%s]", GetErrorMessage(res));
+			delete pItem;
+			break;
+		}
+
+		pItem->SetItemFormat(*__pDirListItemFormat);
+		pItem->SetElement(ID_DIRLIST_FORMAT_NAME, *pName);
+		pItem->SetElement(ID_DIRLIST_FORMAT_BITMAP, *__pIcons[ICON_FILE], __pIcons[ICON_FILE]);
+		pItem->SetElement(ID_DIRLIST_FORMAT_ELEMENTS, *(static_cast<const String*>(pInfos->GetCurrent())));
+
+		__pCurrentFileList->Add(*(new String(*pName)));
+		__pDirList->AddItem(*pItem, j);
+	}
+	if (pNames) delete pNames;
+	if (pInfos) delete pInfos;
 
 	if (dir.StartsWith(L"/Home", 0)) {
 		SetFormStyle(GetFormStyle() | FORM_STYLE_OPTIONKEY);
@@ -371,43 +439,50 @@ result SaveForm::NavigateToPath(const String &path) {
 		return E_INVALID_ARG;
 	}
 
-	delete __pCurrentDir;
-	__pNavigationHistory->RemoveAll(true);
+	String target = path;
+	if (!path.EndsWith(L"/")) {
+		int slash = -1;
+		path.LastIndexOf('/', path.GetLength() - 1, slash);
 
-	StringTokenizer strTok(path, L"/");
+		String name;
+		path.SubString(slash + 1, name);
+		__pFilenameField->SetText(name);
 
-	String token;
-	String *dir = new String(L"/");
-	if (path.EndsWith(L"/")) {
-		while (strTok.HasMoreTokens()) {
-			__pNavigationHistory->Push(*(new String(*dir)));
+		path.SubString(0, slash + 1, target);
+	}
 
-			strTok.GetNextToken(token);
-			token.Append('/');
+	//history already holds every parent up to the current directory, only the part that differs is replaced
+	String *dir = new String(__pCurrentDir ? *__pCurrentDir : String(L"/"));
+	while (!target.StartsWith(*dir, 0) && __pNavigationHistory->GetCount() > 0) {
+		delete dir;
+		dir = static_cast<String*>(__pNavigationHistory->Pop());
+	}
+	if (!target.StartsWith(*dir, 0)) {
+		*dir = L"/";
+	}
 
-			dir->Append(token);
-		}
-	} else {
-		int count = strTok.GetTokenCount();
-		for(int i = 0; i < count - 1; i++) {
-			__pNavigationHistory->Push(*(new String(*dir)));
+	String rest;
+	target.SubString(dir->GetLength(), rest);
 
-			strTok.GetNextToken(token);
-			token.Append('/');
+	StringTokenizer strTok(rest, L"/");
+	String token;
+	while (strTok.HasMoreTokens()) {
+		__pNavigationHistory->Push(*(new String(*dir)));
 
-			dir->Append(token);
-		}
 		strTok.GetNextToken(token);
-		__pFilenameField->SetText(token);
+		token.Append('/');
+
+		dir->Append(token);
 	}
 
+	if (__pCurrentDir) delete __pCurrentDir;
 	__pCurrentDir = dir;
 	return FillDirList(*__pCurrentDir);
 }
 
 result SaveForm::OnLeftSoftkeyClicked(const Control &src) {
 	if (__pFilenameField->GetTextLength() == 0) {
-		ShowMessageBox(GetString(L"SAVEFORM_MBOX_DIR_TITLE"), GetString(L"SAVEFORM_MBOX_FILE_MSG"),MSGBOX_STYLE_OK);
+		ShowMessageBox(GetString(STR_SAVEFORM_MBOX_DIR_TITLE), GetString(STR_SAVEFORM_MBOX_FILE_MSG),MSGBOX_STYLE_OK);
 		return E_SUCCESS;
 	}
 
@@ -422,7 +497,7 @@ result SaveForm::OnLeftSoftkeyClicked(const Control &src) {
 		}
 
 		if (File::IsFileExist(*pCbData)) {
-			int mres = ShowMessageBox(GetString(L"SAVEFORM_MBOX_TITLE"), GetString(L"SAVEFORM_MBOX_TEXT"), MSGBOX_STYLE_YESNO);
+			int mres = ShowMessageBox(GetString(STR_SAVEFORM_MBOX_TITLE), GetString(STR_SAVEFORM_MBOX_TEXT), MSGBOX_STYLE_YESNO);
 
 			res = GetLastResult();
 			if (IsFailed(res)) {
@@ -459,8 +534,8 @@ result SaveForm::OnOptionKeyClicked(const Control &src) {
 
 result SaveForm::OnCreateFolderClicked(const Control &src) {
 	if (__pCurrentDir) {
-		result res = ShowInputBox(CALLBACK(ID_INPUT_DIRECTORY_NAME), KEYPAD_MODE_ALPHA, GetString(L"SAVEFORM_INPUT_DIRNAME_TITLE"), GetString(L"SAVEFORM_INPUT_DIRNAME_MSG"),
-				GetString(L"SAVEFORM_INPUT_DIRNAME_ACCEPT_BUTTON"), GetString(L"SAVEFORM_CANCEL_BUTTON"));
+		result res = ShowInputBox(CALLBACK(ID_INPUT_DIRECTORY_NAME), KEYPAD_MODE_ALPHA, GetString(STR_SAVEFORM_INPUT_DIRNAME_TITLE), GetString(STR_SAVEFORM_INPUT_DIRNAME_MSG),
+				GetString(STR_SAVEFORM_INPUT_DIRNAME_ACCEPT_BUTTON), GetString(STR_SAVEFORM_CANCEL_BUTTON));
 		if (IsFailed(res)) {
 			AppLogException("Failed to request user input, error: [%s]", GetErrorMessage(res));
 		}
@@ -469,7 +544,7 @@ result SaveForm::OnCreateFolderClicked(const Control &src) {
 }
 
 result SaveForm::Initialize(void) {
-	SetTitleText(GetString(L"SAVEFORM_TITLE"), ALIGNMENT_CENTER);
+	SetTitleText(GetString(STR_SAVEFORM_TITLE), ALIGNMENT_CENTER);
 
 	RegisterAction(ID_SOFTKEY0_CLICKED, HANDLER(SaveForm::OnLeftSoftkeyClicked));
 	RegisterAction(ID_SOFTKEY1_CLICKED, HANDLER(SaveForm::OnRightSoftkeyClicked));
@@ -478,8 +553,8 @@ result SaveForm::Initialize(void) {
 	AddSoftkeyActionListener(SOFTKEY_0, *this);
 	AddSoftkeyActionListener(SOFTKEY_1, *this);
 
-	SetSoftkeyText(SOFTKEY_0, GetString(L"SAVEFORM_ACCEPT_BUTTON"));
-	SetSoftkeyText(SOFTKEY_1, GetString(L"SAVEFORM_CANCEL_BUTTON"));
+	SetSoftkeyText(SOFTKEY_0, GetString(STR_SAVEFORM_ACCEPT_BUTTON));
+	SetSoftkeyText(SOFTKEY_1, GetString(STR_SAVEFORM_CANCEL_BUTTON));
 
 	RegisterAction(ID_OPTION_KEY_CLICKED, HANDLER(SaveForm::OnOptionKeyClicked));
 	RegisterAction(ID_OPTION_CREATE_FOLDER_CLICKED, HANDLER(SaveForm::OnCreateFolderClicked));
@@ -487,9 +562,9 @@ result SaveForm::Initialize(void) {
 	SetOptionkeyActionId(ID_OPTION_KEY_CLICKED);
 	AddOptionkeyActionListener(*this);
 
-	__pFilenameField->SetTitleText(GetString(L"SAVEFORM_FILENAME_FIELD_TITLE"));
+	__pFilenameField->SetTitleText(GetString(STR_SAVEFORM_FILENAME_FIELD_TITLE));
 
-	__pDirListCaption->SetText(GetString(L"SAVEFORM_DIRLIST_TITLE"));
+	__pDirListCaption->SetText(GetString(STR_SAVEFORM_DIRLIST_TITLE));
 	__pDirList->AddCustomItemEventListener(*this);
 
 	if (!__startingPath.IsEmpty()) {
@@ -526,11 +601,34 @@ void SaveForm::OnItemStateChanged(const Control &source, int index, int itemId,
 	}
 }
 
+void SaveForm::OnUserEventReceivedN(RequestId requestId, IList *pArgs) {
+	if (requestId == DirectoryCounter::COUNT_READY && pArgs && pArgs->GetCount() > 1) {
+		const String *pPath = static_cast<const String *>(pArgs->GetAt(0));
+		int count = static_cast<const Integer *>(pArgs->GetAt(1))->ToInt();
+
+		//listing may have changed since the count was requested
+		int itemId = -1;
+		if (!IsFailed(__pCurrentDirList->IndexOf(*pPath, itemId))) {
+			int index = __pDirList->GetItemIndexFromItemId(itemId);
+			CustomListItem *pItem = index >= 0 ? CreateDirItemN(itemId, *pPath, count, true) : null;
+			if (pItem) {
+				__pDirList->SetItemAt(index, *pItem, itemId);
+				RefreshForm();
+			}
+		}
+	}
+
+	if (pArgs) {
+		pArgs->RemoveAll(true);
+		delete pArgs;
+	}
+}
+
 void SaveForm::DialogCallback(int taskId, BaseForm *sender, DialogResult ret, void *dataN) {
 	if (taskId == ID_INPUT_DIRECTORY_NAME && ret == DIALOG_RESULT_OK && dataN) {
 		String *pCbData = (String*)dataN;
 		if (pCbData->IsEmpty()) {
-			ShowMessageBox(GetString(L"SAVEFORM_MBOX_DIR_TITLE"), GetString(L"SAVEFORM_MBOX_DIR_MSG"),MSGBOX_STYLE_OK);
+			ShowMessageBox(GetString(STR_SAVEFORM_MBOX_DIR_TITLE), GetString(STR_SAVEFORM_MBOX_DIR_MSG),MSGBOX_STYLE_OK);
 		}
 
 		String *dir = new String(*__pCurrentDir);
@@ -538,6 +636,8 @@ void SaveForm::DialogCallback(int taskId, BaseForm *sender, DialogResult ret, vo
 		dir->Append('/');
 
 		Directory::Create(*dir, true);
+		//not every file system touches the parent when a directory is created
+		DropListing(*__pCurrentDir);
 		FillDirList(*__pCurrentDir);
 
 		delete pCbData;
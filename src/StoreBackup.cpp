@@ -0,0 +1,955 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <FText.h>
+
+#include "Note.h"
+#include "StoreBackup.h"
+
+using namespace Osp::Text;
+
+static const byte DELTA_MAGIC[4] = { 'N', 'B', 'D', '1' };
+
+static const byte RECORD_UPSERT = 'U';
+static const byte RECORD_DELETE = 'D';
+static const byte RECORD_END = 'E';
+
+StoreBackup::StoreBackup(void) {
+	__dataPath = L"";
+	__dir = L"";
+}
+
+StoreBackup::~StoreBackup(void) {
+}
+
+result StoreBackup::Construct(const String &dataPath, const String &backupRoot) {
+	__dataPath = dataPath;
+
+	int slash = -1;
+	String name = dataPath;
+	if (!IsFailed(dataPath.LastIndexOf('/', dataPath.GetLength() - 1, slash))) {
+		dataPath.SubString(slash + 1, name);
+	}
+
+	//stores with the same file name in different folders must not share backups
+	__dir = backupRoot;
+	if (!__dir.EndsWith(L"/")) {
+		__dir.Append('/');
+	}
+	__dir.Append(name);
+	__dir.Append('_');
+	__dir.Append(Integer::ToHexString(dataPath.GetHashCode()));
+	__dir.Append('/');
+
+	result res = Directory::Create(__dir, true);
+	if (IsFailed(res) && res != E_FILE_ALREADY_EXIST) {
+		AppLogException("Failed to create backup directory [%S], error: [%s]", __dir.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+	return E_SUCCESS;
+}
+
+String StoreBackup::GetBasePath(long long gen) const {
+	String path = __dir;
+	path.Append(L"base_");
+	path.Append(gen);
+	path.Append(L".bin");
+	return path;
+}
+
+String StoreBackup::GetDeltaPath(long long fromGen, long long toGen) const {
+	String path = __dir;
+	path.Append(L"delta_");
+	path.Append(fromGen);
+	path.Append('_');
+	path.Append(toGen);
+	path.Append(L".bin");
+	return path;
+}
+
+bool StoreBackup::ParseBaseName(const String &name, long long &gen) {
+	if (!name.StartsWith(L"base_", 0) || !name.EndsWith(L".bin")) {
+		return false;
+	}
+	String num;
+	name.SubString(5, name.GetLength() - 9, num);
+	return !IsFailed(LongLong::Parse(num, gen));
+}
+
+bool StoreBackup::ParseDeltaName(const String &name, long long &fromGen, long long &toGen) {
+	if (!name.StartsWith(L"delta_", 0) || !name.EndsWith(L".bin")) {
+		return false;
+	}
+	String range;
+	name.SubString(6, name.GetLength() - 10, range);
+
+	int sep = -1;
+	if (IsFailed(range.IndexOf('_', 0, sep))) {
+		return false;
+	}
+	String from, to;
+	range.SubString(0, sep, from);
+	range.SubString(sep + 1, to);
+
+	return !IsFailed(LongLong::Parse(from, fromGen)) && !IsFailed(LongLong::Parse(to, toGen));
+}
+
+result StoreBackup::ReadGeneration(Database *pDb, long long &gen) {
+	DbEnumerator *pEnum = pDb->QueryN(L"SELECT generation FROM db_info");
+	result res = GetLastResult();
+	if (IsFailed(res)) {
+		return res;
+	}
+	if (!pEnum) {
+		return E_INVALID_FORMAT;
+	}
+	res = E_INVALID_FORMAT;
+	if (!IsFailed(pEnum->MoveNext())) {
+		res = pEnum->GetInt64At(0, gen);
+	}
+	delete pEnum;
+	return res;
+}
+
+result StoreBackup::GetState(long long &baseGen, long long &lastGen, int &deltaCount) const {
+	baseGen = -1;
+	lastGen = -1;
+	deltaCount = 0;
+
+	Directory dir;
+	result res = dir.Construct(__dir);
+	if (IsFailed(res)) {
+		AppLogException("Failed to open backup directory [%S], error: [%s]", __dir.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+	DirEnumerator *pEnum = dir.ReadN();
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to read backup directory [%S], error: [%s]", __dir.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	//two passes, since deltas are only meaningful relative to the newest base
+	long long gen = 0;
+	while (!IsFailed(pEnum->MoveNext())) {
+		if (ParseBaseName(pEnum->GetCurrentDirEntry().GetName(), gen) && gen > baseGen) {
+			baseGen = gen;
+		}
+	}
+	lastGen = baseGen;
+
+	if (baseGen >= 0) {
+		pEnum->Reset();
+
+		long long from = 0, to = 0;
+		while (!IsFailed(pEnum->MoveNext())) {
+			if (ParseDeltaName(pEnum->GetCurrentDirEntry().GetName(), from, to) && from >= baseGen) {
+				deltaCount++;
+				if (to > lastGen) {
+					lastGen = to;
+				}
+			}
+		}
+	}
+
+	delete pEnum;
+	return E_SUCCESS;
+}
+
+void StoreBackup::Prune(long long baseGen) const {
+	Directory dir;
+	if (IsFailed(dir.Construct(__dir))) {
+		return;
+	}
+	DirEnumerator *pEnum = dir.ReadN();
+	if (!pEnum) {
+		return;
+	}
+
+	while (!IsFailed(pEnum->MoveNext())) {
+		String name = pEnum->GetCurrentDirEntry().GetName();
+
+		long long gen = 0, from = 0, to = 0;
+		bool stale = false;
+		if (ParseBaseName(name, gen)) {
+			stale = gen < baseGen;
+		} else if (ParseDeltaName(name, from, to)) {
+			stale = from < baseGen;
+		} else if (name.EndsWith(L".tmp")) {
+			//leftovers of an interrupted backup
+			stale = true;
+		}
+
+		if (stale) {
+			String path = __dir;
+			path.Append(name);
+			File::Remove(path);
+		}
+	}
+	delete pEnum;
+}
+
+result StoreBackup::TakeBase(void) {
+	String tmp = __dir;
+	tmp.Append(L"base.tmp");
+	if (File::IsFileExist(tmp)) {
+		File::Remove(tmp);
+	}
+
+	result res = File::Copy(__dataPath, tmp, true);
+	if (IsFailed(res)) {
+		AppLogException("Failed to copy store [%S] to backup, error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	//generation is read from the copy itself, so it matches copied data exactly
+	long long gen = 0;
+	Database *pDb = new Database;
+	res = pDb->Construct(tmp, false);
+	if (!IsFailed(res)) {
+		res = ReadGeneration(pDb, gen);
+	}
+	if (IsFailed(res)) {
+		AppLogException("Failed to read generation of backup base, error: [%s]", GetErrorMessage(res));
+	} else {
+		//base is only finalized once everything it references is backed up too
+		res = SaveMedia(pDb, L"SELECT path FROM attachments WHERE refs > 0");
+	}
+	delete pDb;
+
+	if (IsFailed(res)) {
+		File::Remove(tmp);
+		return res;
+	}
+
+	res = File::Move(tmp, GetBasePath(gen));
+	if (IsFailed(res)) {
+		AppLogException("Failed to finalize backup base, error: [%s]", GetErrorMessage(res));
+		File::Remove(tmp);
+		return res;
+	}
+
+	Prune(gen);
+	PruneMedia(GetBasePath(gen));
+
+	//tombstones covered by the base are of no use to anyone anymore
+	pDb = new Database;
+	if (!IsFailed(pDb->Construct(__dataPath, false))) {
+		String sql = L"DELETE FROM removed_entries WHERE generation <= ";
+		sql.Append(gen);
+		pDb->ExecuteSql(sql, true);
+	}
+	delete pDb;
+
+	return E_SUCCESS;
+}
+
+result StoreBackup::Backup(void) {
+	long long base_gen = -1, last_gen = -1;
+	int deltas = 0;
+
+	result res = GetState(base_gen, last_gen, deltas);
+	if (IsFailed(res)) {
+		return res;
+	}
+	if (base_gen < 0 || deltas >= MAX_DELTAS) {
+		return TakeBase();
+	}
+
+	Database *pDb = new Database;
+	res = pDb->Construct(__dataPath, false);
+	if (IsFailed(res)) {
+		AppLogException("Failed to load database file at [%S], error: [%s]", __dataPath.GetPointer(), GetErrorMessage(res));
+
+		delete pDb;
+		return res;
+	}
+
+	//read transaction keeps generation and rows consistent with each other
+	res = pDb->BeginTransaction();
+	if (IsFailed(res)) {
+		delete pDb;
+		return res;
+	}
+
+	long long cur_gen = 0;
+	res = ReadGeneration(pDb, cur_gen);
+	if (!IsFailed(res) && cur_gen > last_gen) {
+		res = WriteDelta(pDb, last_gen, cur_gen);
+	}
+
+	pDb->CommitTransaction();
+	delete pDb;
+
+	return res;
+}
+
+result StoreBackup::WriteDelta(Database *pDb, long long fromGen, long long toGen) {
+	String tmp = __dir;
+	tmp.Append(L"delta.tmp");
+
+	BufferedFileWriter writer;
+	result res = writer.Construct(tmp);
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	writer.Write(DELTA_MAGIC, sizeof(DELTA_MAGIC));
+	WriteInt64(writer, fromGen);
+	WriteInt64(writer, toGen);
+
+	int records = 0;
+
+	String gen_str = L"";
+	gen_str.Append(fromGen);
+
+	DbEnumerator *pEnum = pDb->QueryN(L"SELECT entry_id FROM removed_entries WHERE generation > " + gen_str);
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to query removed notes for backup, error: [%s]", GetErrorMessage(res));
+		writer.Close();
+		File::Remove(tmp);
+		return res;
+	}
+	if (pEnum) {
+		int entry_id = -1;
+		while (!IsFailed(pEnum->MoveNext())) {
+			if (!IsFailed(pEnum->GetIntAt(0, entry_id))) {
+				writer.WriteByte(RECORD_DELETE);
+				WriteInt32(writer, entry_id);
+				records++;
+			}
+		}
+		delete pEnum;
+	}
+
+	pEnum = pDb->QueryN(L"SELECT entries.entry_id,entries.type,entries.timestamp,entries.marked,entries.title,entries.text, CASE "
+		"WHEN (entries.type = 2) OR (entries.type = 3) THEN (SELECT res_path FROM resource_entries WHERE resource_entries.entry_id = entries.entry_id) "
+		"ELSE '' "
+		"END FROM entries WHERE entries.generation > " + gen_str);
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to query modified notes for backup, error: [%s]", GetErrorMessage(res));
+		writer.Close();
+		File::Remove(tmp);
+		return res;
+	}
+	if (pEnum) {
+		int entry_id = -1;
+		int type = -1;
+		long long timestamp = 0;
+		int marked = 0;
+		String title;
+		String text;
+		String res_path;
+
+		while (!IsFailed(pEnum->MoveNext())) {
+			pEnum->GetIntAt(0, entry_id);
+			pEnum->GetIntAt(1, type);
+			pEnum->GetInt64At(2, timestamp);
+			pEnum->GetIntAt(3, marked);
+			pEnum->GetStringAt(4, title);
+			pEnum->GetStringAt(5, text);
+			res_path = L"";
+			if (type != NOTE_TYPE_TEXT) {
+				pEnum->GetStringAt(6, res_path);
+			}
+
+			writer.WriteByte(RECORD_UPSERT);
+			WriteInt32(writer, entry_id);
+			WriteInt32(writer, type);
+			WriteInt64(writer, timestamp);
+			writer.WriteByte(marked ? 1 : 0);
+			WriteString(writer, title);
+			WriteString(writer, text);
+			WriteString(writer, res_path);
+			records++;
+		}
+		delete pEnum;
+	}
+
+	writer.WriteByte(RECORD_END);
+	WriteInt32(writer, records);
+
+	res = writer.Flush(true);
+	writer.Close();
+	if (IsFailed(res)) {
+		AppLogException("Failed to write backup delta, error: [%s]", GetErrorMessage(res));
+		File::Remove(tmp);
+		return res;
+	}
+
+	res = SaveMedia(pDb, L"SELECT attachments.path FROM attachments, resource_entries, entries WHERE attachments.hash = resource_entries.hash "
+						 "AND resource_entries.entry_id = entries.entry_id AND entries.generation > " + gen_str);
+	if (IsFailed(res)) {
+		File::Remove(tmp);
+		return res;
+	}
+
+	res = File::Move(tmp, GetDeltaPath(fromGen, toGen));
+	if (IsFailed(res)) {
+		AppLogException("Failed to finalize backup delta, error: [%s]", GetErrorMessage(res));
+		File::Remove(tmp);
+	}
+	return res;
+}
+
+result StoreBackup::Restore(const String &destPath) const {
+	if (File::IsFileExist(destPath)) {
+		return E_FILE_ALREADY_EXIST;
+	}
+
+	long long base_gen = -1, last_gen = -1;
+	int deltas = 0;
+	result res = GetState(base_gen, last_gen, deltas);
+	if (IsFailed(res)) {
+		return res;
+	}
+	if (base_gen < 0) {
+		AppLogException("There is no backup base in [%S] to restore from", __dir.GetPointer());
+		return E_OBJ_NOT_FOUND;
+	}
+
+	String tmp = destPath;
+	tmp.Append(L".tmp");
+	if (File::IsFileExist(tmp)) {
+		File::Remove(tmp);
+	}
+
+	res = File::Copy(GetBasePath(base_gen), tmp, true);
+	if (IsFailed(res)) {
+		AppLogException("Failed to copy backup base to [%S], error: [%s]", tmp.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	Database *pDb = new Database;
+	res = pDb->Construct(tmp, false);
+	if (IsFailed(res)) {
+		AppLogException("Failed to open restored database at [%S], error: [%s]", tmp.GetPointer(), GetErrorMessage(res));
+
+		delete pDb;
+		File::Remove(tmp);
+		return res;
+	}
+
+	//deltas chain by generation, each one starting where previous ended
+	long long gen = base_gen;
+	while (gen < last_gen) {
+		Directory dir;
+		dir.Construct(__dir);
+		DirEnumerator *pEnum = dir.ReadN();
+
+		String next = L"";
+		long long from = 0, to = 0;
+		while (pEnum && !IsFailed(pEnum->MoveNext())) {
+			String name = pEnum->GetCurrentDirEntry().GetName();
+			if (ParseDeltaName(name, from, to) && from == gen) {
+				next = __dir;
+				next.Append(name);
+				break;
+			}
+		}
+		if (pEnum) delete pEnum;
+
+		if (next.IsEmpty()) {
+			AppLogException("Backup delta chain in [%S] is broken after generation [%lld]", __dir.GetPointer(), gen);
+			res = E_INVALID_FORMAT;
+			break;
+		}
+
+		res = ApplyDelta(pDb, next, gen, gen);
+		if (IsFailed(res)) {
+			break;
+		}
+	}
+	if (!IsFailed(res)) {
+		res = RestoreMedia(pDb, destPath);
+	}
+	delete pDb;
+
+	if (IsFailed(res)) {
+		File::Remove(tmp);
+		return res;
+	}
+
+	res = File::Move(tmp, destPath);
+	if (IsFailed(res)) {
+		AppLogException("Failed to move restored database to [%S], error: [%s]", destPath.GetPointer(), GetErrorMessage(res));
+		File::Remove(tmp);
+	}
+	return res;
+}
+
+result StoreBackup::ApplyDelta(Database *pDb, const String &path, long long expectedFrom, long long &toGen) const {
+	FileAttributes attr;
+	result res = File::GetAttributes(path, attr);
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	File file;
+	res = file.Construct(path, L"r");
+	if (IsFailed(res)) {
+		AppLogException("Failed to open backup delta [%S], error: [%s]", path.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	ByteBuffer buf;
+	res = buf.Construct((int)attr.GetFileSize());
+	if (IsFailed(res)) {
+		return res;
+	}
+	res = file.Read(buf);
+	if (IsFailed(res)) {
+		AppLogException("Failed to read backup delta [%S], error: [%s]", path.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+	buf.Flip();
+
+	int pos = 0;
+	byte magic[4];
+	for (int i = 0; i < 4; i++) {
+		if (IsFailed(buf.GetByte(pos++, magic[i])) || magic[i] != DELTA_MAGIC[i]) {
+			return E_INVALID_FORMAT;
+		}
+	}
+
+	long long from = 0;
+	if (!ReadInt64(buf, pos, from) || !ReadInt64(buf, pos, toGen) || from != expectedFrom) {
+		return E_INVALID_FORMAT;
+	}
+
+	DbStatement *pInsert = pDb->CreateStatementN(L"INSERT INTO entries (entry_id, type, timestamp, marked, title, text, generation) VALUES (?, ?, ?, ?, ?, ?, ?)");
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		return res;
+	}
+	DbStatement *pInsertRes = pDb->CreateStatementN(L"INSERT INTO resource_entries (entry_id, res_path) VALUES (?, ?)");
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		delete pInsert;
+		return res;
+	}
+
+	res = pDb->BeginTransaction();
+
+	int records = 0;
+	bool complete = false;
+	while (!IsFailed(res) && pos < buf.GetLimit()) {
+		byte tag = 0;
+		buf.GetByte(pos++, tag);
+
+		if (tag == RECORD_END) {
+			int expected = 0;
+			complete = ReadInt32(buf, pos, expected) && expected == records;
+			break;
+		}
+
+		int entry_id = -1;
+		if (!ReadInt32(buf, pos, entry_id)) {
+			break;
+		}
+
+		String id = L""; id.Append(entry_id);
+		res = pDb->ExecuteSql(L"DELETE FROM entries WHERE entry_id=" + id, false);
+		if (!IsFailed(res)) {
+			res = pDb->ExecuteSql(L"DELETE FROM resource_entries WHERE entry_id=" + id, false);
+		}
+		if (IsFailed(res)) {
+			break;
+		}
+
+		if (tag == RECORD_UPSERT) {
+			int type = 0;
+			long long timestamp = 0;
+			byte marked = 0;
+			String title, text, res_path;
+
+			if (!ReadInt32(buf, pos, type) || !ReadInt64(buf, pos, timestamp) || IsFailed(buf.GetByte(pos++, marked))
+					|| !ReadString(buf, pos, title) || !ReadString(buf, pos, text) || !ReadString(buf, pos, res_path)) {
+				break;
+			}
+
+			pInsert->BindInt(0, entry_id);
+			pInsert->BindInt(1, type);
+			pInsert->BindInt64(2, timestamp);
+			pInsert->BindInt(3, (int)marked);
+			pInsert->BindString(4, title);
+			pInsert->BindString(5, text);
+			pInsert->BindInt64(6, toGen);
+			pDb->ExecuteStatementN(*pInsert); res = GetLastResult();
+
+			if (!IsFailed(res) && !res_path.IsEmpty()) {
+				pInsertRes->BindInt(0, entry_id);
+				pInsertRes->BindString(1, res_path);
+				pDb->ExecuteStatementN(*pInsertRes); res = GetLastResult();
+			}
+		} else if (tag != RECORD_DELETE) {
+			break;
+		}
+		records++;
+	}
+
+	if (!IsFailed(res) && !complete) {
+		AppLogException("Backup delta [%S] is truncated or corrupted", path.GetPointer());
+		res = E_INVALID_FORMAT;
+	}
+
+	if (!IsFailed(res)) {
+		String sql = L"UPDATE db_info SET generation = ";
+		sql.Append(toGen);
+		res = pDb->ExecuteSql(sql, false);
+	}
+
+	if (IsFailed(res)) {
+		pDb->RollbackTransaction();
+	} else {
+		res = pDb->CommitTransaction();
+	}
+
+	delete pInsert;
+	delete pInsertRes;
+	return res;
+}
+
+String StoreBackup::GetMediaDir(void) const {
+	String dir = __dir;
+	dir.Append(L"media/");
+	return dir;
+}
+
+result StoreBackup::SaveMedia(Database *pDb, const String &query) const {
+	DbEnumerator *pEnum = pDb->QueryN(query);
+	result res = GetLastResult();
+	if (IsFailed(res)) {
+		AppLogException("Failed to query media for backup, error: [%s]", GetErrorMessage(res));
+		return res;
+	}
+	if (!pEnum) {
+		return E_SUCCESS;
+	}
+
+	String src_root = __dataPath;
+	src_root.Append(L".media/");
+	String dest_root = GetMediaDir();
+
+	while (!IsFailed(res) && !IsFailed(pEnum->MoveNext())) {
+		String relative;
+		if (IsFailed(pEnum->GetStringAt(0, relative))) {
+			continue;
+		}
+
+		//files are content addressed, so one already in the backup is the same file
+		String dest = dest_root + relative;
+		if (File::IsFileExist(dest)) {
+			continue;
+		}
+		String src = src_root + relative;
+		if (!File::IsFileExist(src)) {
+			//nothing to do about it now, and failing would stop every later backup
+			AppLogException("Media [%S] is missing from the store, backup won't have it", src.GetPointer());
+			continue;
+		}
+
+		int slash = -1;
+		if (!IsFailed(relative.LastIndexOf('/', relative.GetLength() - 1, slash))) {
+			String dir;
+			relative.SubString(0, slash + 1, dir);
+			res = Directory::Create(dest_root + dir, true);
+			if (res == E_FILE_ALREADY_EXIST) {
+				res = E_SUCCESS;
+			}
+		}
+
+		if (!IsFailed(res)) {
+			String tmp = dest + L".tmp";
+			if (File::IsFileExist(tmp)) {
+				File::Remove(tmp);
+			}
+			res = File::Copy(src, tmp, true);
+			if (!IsFailed(res)) {
+				res = File::Move(tmp, dest);
+			}
+			if (IsFailed(res)) {
+				File::Remove(tmp);
+			}
+		}
+		if (IsFailed(res)) {
+			AppLogException("Failed to copy media [%S] to backup, error: [%s]", src.GetPointer(), GetErrorMessage(res));
+		}
+	}
+	delete pEnum;
+	return res;
+}
+
+void StoreBackup::PruneMedia(const String &basePath) const {
+	ArrayListT<String> relatives;
+	relatives.Construct();
+	if (IsFailed(ListMedia(GetMediaDir(), relatives)) || relatives.GetCount() == 0) {
+		return;
+	}
+
+	Database *pDb = new Database;
+	if (IsFailed(pDb->Construct(basePath, false))) {
+		delete pDb;
+		return;
+	}
+	DbStatement *pFind = pDb->CreateStatementN(L"SELECT refs FROM attachments WHERE path = ? AND refs > 0");
+	if (IsFailed(GetLastResult())) {
+		delete pDb;
+		return;
+	}
+
+	//chain is just the new base now, so whatever it doesn't reference no restore can need
+	String root = GetMediaDir();
+	for (int i = 0; i < relatives.GetCount(); i++) {
+		String relative;
+		relatives.GetAt(i, relative);
+		if (IsFailed(pFind->BindString(0, relative))) {
+			continue;
+		}
+
+		DbEnumerator *pEnum = pDb->ExecuteStatementN(*pFind);
+		if (IsFailed(GetLastResult())) {
+			continue;
+		}
+		if (pEnum) {
+			delete pEnum;
+		} else {
+			File::Remove(root + relative);
+		}
+	}
+
+	delete pFind;
+	delete pDb;
+}
+
+result StoreBackup::RestoreMedia(Database *pDb, const String &destPath) const {
+	ArrayListT<String> relatives;
+	relatives.Construct();
+	result res = ListMedia(GetMediaDir(), relatives);
+	if (IsFailed(res)) {
+		AppLogException("Failed to list backed up media in [%S], error: [%s]", GetMediaDir().GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	AttachmentStore media;
+	res = media.Construct(destPath);
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	//rows copied from deltas carry no hash, registering the files lets the store count their references when it's opened
+	DbStatement *pAttach = pDb->CreateStatementN(L"INSERT OR IGNORE INTO attachments (hash, path, size, refs) VALUES (?, ?, ?, 0)");
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	String src_root = GetMediaDir();
+	res = pDb->BeginTransaction();
+	for (int i = 0; i < relatives.GetCount() && !IsFailed(res); i++) {
+		String relative, rel, hash;
+		relatives.GetAt(i, relative);
+
+		String dest = media.GetAbsolutePath(relative);
+		if (!media.ParsePath(dest, rel, hash)) {
+			continue;
+		}
+
+		int slash = -1;
+		relative.LastIndexOf('/', relative.GetLength() - 1, slash);
+		String dir;
+		relative.SubString(0, slash + 1, dir);
+		res = Directory::Create(media.GetAbsolutePath(dir), true);
+		if (res == E_FILE_ALREADY_EXIST) {
+			res = E_SUCCESS;
+		}
+		if (!IsFailed(res) && !File::IsFileExist(dest)) {
+			res = File::Copy(src_root + relative, dest, true);
+		}
+
+		FileAttributes attr;
+		if (!IsFailed(res)) {
+			res = File::GetAttributes(dest, attr);
+		}
+		if (!IsFailed(res)) {
+			result bind_res[3];
+			bind_res[0] = pAttach->BindString(0, hash);
+			bind_res[1] = pAttach->BindString(1, relative);
+			bind_res[2] = pAttach->BindInt64(2, attr.GetFileSize());
+			for (int j = 0; j < 3 && !IsFailed(res); j++) {
+				res = bind_res[j];
+			}
+		}
+		if (!IsFailed(res)) {
+			pDb->ExecuteStatementN(*pAttach); res = GetLastResult();
+		}
+		if (IsFailed(res)) {
+			AppLogException("Failed to restore media [%S], error: [%s]", relative.GetPointer(), GetErrorMessage(res));
+		}
+	}
+	delete pAttach;
+
+	if (!IsFailed(res)) {
+		//paths still point at the media of the backed up store, the restored one has its own
+		String old_root = __dataPath;
+		old_root.Append(L".media/");
+
+		DbStatement *pMove = pDb->CreateStatementN(L"UPDATE resource_entries SET res_path = ? || substr(res_path, ?) WHERE substr(res_path, 1, ?) = ?");
+		res = GetLastResult();
+		if (!IsFailed(res)) {
+			result bind_res[4];
+			bind_res[0] = pMove->BindString(0, media.GetRoot());
+			bind_res[1] = pMove->BindInt(1, old_root.GetLength() + 1);
+			bind_res[2] = pMove->BindInt(2, old_root.GetLength());
+			bind_res[3] = pMove->BindString(3, old_root);
+			for (int j = 0; j < 4 && !IsFailed(res); j++) {
+				res = bind_res[j];
+			}
+			if (!IsFailed(res)) {
+				pDb->ExecuteStatementN(*pMove); res = GetLastResult();
+			}
+			delete pMove;
+		}
+	}
+
+	if (IsFailed(res)) {
+		pDb->RollbackTransaction();
+	} else {
+		res = pDb->CommitTransaction();
+	}
+	return res;
+}
+
+result StoreBackup::ListMedia(const String &root, ArrayListT<String> &relatives) {
+	if (!File::IsFileExist(root)) {
+		return E_SUCCESS;
+	}
+
+	Directory dir;
+	result res = dir.Construct(root);
+	if (IsFailed(res)) {
+		return res;
+	}
+	DirEnumerator *pDirs = dir.ReadN();
+	res = GetLastResult();
+	if (IsFailed(res)) {
+		return res;
+	}
+
+	//files sit one level down, in directories named after first digits of their hash
+	while (pDirs && !IsFailed(pDirs->MoveNext())) {
+		DirEntry entry = pDirs->GetCurrentDirEntry();
+		String name = entry.GetName();
+		if (!entry.IsDirectory() || name.Equals(String(L".")) || name.Equals(String(L".."))) {
+			continue;
+		}
+
+		Directory sub;
+		if (IsFailed(sub.Construct(root + name))) {
+			continue;
+		}
+		DirEnumerator *pFiles = sub.ReadN();
+		while (pFiles && !IsFailed(pFiles->MoveNext())) {
+			DirEntry file = pFiles->GetCurrentDirEntry();
+			if (file.IsDirectory() || file.GetName().EndsWith(L".tmp")) {
+				continue;
+			}
+			String relative = name;
+			relative.Append('/');
+			relative.Append(file.GetName());
+			relatives.Add(relative);
+		}
+		if (pFiles) delete pFiles;
+	}
+	if (pDirs) delete pDirs;
+	return E_SUCCESS;
+}
+
+result StoreBackup::WriteInt32(BufferedFileWriter &writer, int val) {
+	byte buf[4];
+	for (int i = 0; i < 4; i++) {
+		buf[i] = (byte)((unsigned int)val >> (i * 8));
+	}
+	return writer.Write(buf, 4);
+}
+
+result StoreBackup::WriteInt64(BufferedFileWriter &writer, long long val) {
+	byte buf[8];
+	for (int i = 0; i < 8; i++) {
+		buf[i] = (byte)((unsigned long long)val >> (i * 8));
+	}
+	return writer.Write(buf, 8);
+}
+
+result StoreBackup::WriteString(BufferedFileWriter &writer, const String &str) {
+	WriteInt32(writer, BufferedFileWriter::GetUtf8Length(str.GetPointer(), str.GetLength()));
+	return writer.WriteUtf8(str);
+}
+
+bool StoreBackup::ReadInt32(const ByteBuffer &buf, int &pos, int &val) {
+	if (pos + 4 > buf.GetLimit()) {
+		return false;
+	}
+	unsigned int uval = 0;
+	for (int i = 0; i < 4; i++) {
+		byte b = 0;
+		buf.GetByte(pos++, b);
+		uval |= (unsigned int)b << (i * 8);
+	}
+	val = (int)uval;
+	return true;
+}
+
+bool StoreBackup::ReadInt64(const ByteBuffer &buf, int &pos, long long &val) {
+	if (pos + 8 > buf.GetLimit()) {
+		return false;
+	}
+	unsigned long long uval = 0;
+	for (int i = 0; i < 8; i++) {
+		byte b = 0;
+		buf.GetByte(pos++, b);
+		uval |= (unsigned long long)b << (i * 8);
+	}
+	val = (long long)uval;
+	return true;
+}
+
+bool StoreBackup::ReadString(const ByteBuffer &buf, int &pos, String &str) {
+	int len = 0;
+	if (!ReadInt32(buf, pos, len) || len < 0 || pos + len > buf.GetLimit()) {
+		return false;
+	}
+
+	str = L"";
+	if (len == 0) {
+		return true;
+	}
+
+	ByteBuffer bytes;
+	if (IsFailed(bytes.Construct(len + 1))) {
+		return false;
+	}
+	bytes.SetArray(buf.GetPointer(), pos, len);
+	bytes.SetByte('\0');
+	bytes.Flip();
+	pos += len;
+
+	Utf8Encoding utf8;
+	return !IsFailed(utf8.GetString(bytes, str));
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "StoreOpener.h"
+#include "Trace.h"
+
+StoreOpener::StoreOpener(void) {
+	__path = L"";
+	__backupRoot = L"";
+	__pTarget = null;
+	__pManager = null;
+	__result = E_SUCCESS;
+	__lastPercent = -1;
+}
+
+StoreOpener::~StoreOpener(void) {
+	if (__pManager) delete __pManager;
+}
+
+result StoreOpener::Construct(const String &path, const String &backupRoot, Control *pTarget) {
+	if (path.IsEmpty()) {
+		return E_INVALID_ARG;
+	}
+
+	__path = path;
+	__backupRoot = backupRoot;
+	__pTarget = pTarget;
+
+	return Thread::Construct(THREAD_TYPE_WORKER);
+}
+
+CachingNotesManager *StoreOpener::DetachManagerN(void) {
+	CachingNotesManager *pManager = __pManager;
+	__pManager = null;
+	return pManager;
+}
+
+void StoreOpener::OnLoadProgress(int loaded, int total) {
+	//opening the file and upgrading it come before the first row, loading the rows takes the rest up to 95%
+	int percent = total > 0 ? 5 + (int)((long long)loaded * 90 / total) : 5;
+	ReportProgress(percent > 95 ? 95 : percent);
+}
+
+void StoreOpener::ReportProgress(int percent) {
+	//the same value again would only cost the UI a redraw
+	if (!__pTarget || percent == __lastPercent) {
+		return;
+	}
+	__lastPercent = percent;
+
+	ArrayList *pArgs = new ArrayList;
+	pArgs->Construct();
+	pArgs->Add(*(new Integer(percent)));
+
+	result res = __pTarget->SendUserEvent(STORE_OPEN_PROGRESS, pArgs);
+	if (IsFailed(res)) {
+		pArgs->RemoveAll(true);
+		delete pArgs;
+	}
+}
+
+Object *StoreOpener::Run(void) {
+	TRACE_SCOPE("store.open");
+
+	ReportProgress(0);
+
+	//a file that isn't a notes database fails right here, before anything is swapped
+	CachingNotesManager *pManager = new CachingNotesManager;
+	result res = pManager->Construct(__path, this);
+	if (IsFailed(res)) {
+		AppLogException("Failed to open notes store at [%S], error: [%s]", __path.GetPointer(), GetErrorMessage(res));
+
+		delete pManager;
+		pManager = null;
+	} else {
+		if (!__backupRoot.IsEmpty()) {
+			//store is usable without backups
+			pManager->EnableBackup(__backupRoot);
+		}
+		ReportProgress(100);
+	}
+
+	__pManager = pManager;
+	__result = res;
+
+	if (__pTarget) {
+		res = __pTarget->SendUserEvent(STORE_OPENED, null);
+		if (IsFailed(res)) {
+			AppLogException("Failed to notify about opened store, error: [%s]", GetErrorMessage(res));
+		}
+	}
+	return null;
+}
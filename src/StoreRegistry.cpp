@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "StoreRegistry.h"
+#include "Trace.h"
+
+void MergedNotesCursor::Reset(void) {
+	for (int s = 0; s < NoteSorter::MAX_MERGE_RUNS; s++) {
+		__stores[s].Reset();
+	}
+}
+
+StoreRegistry::StoreRegistry(void) {
+	for (int s = 0; s < MAX_STORES; s++) {
+		__pStores[s] = null;
+	}
+	__backupRoot = L"";
+}
+
+StoreRegistry::~StoreRegistry(void) {
+	for (int s = 0; s < MAX_STORES; s++) {
+		if (__pStores[s]) delete __pStores[s];
+	}
+}
+
+result StoreRegistry::Construct(const String &backupRoot) {
+	__backupRoot = backupRoot;
+	return E_SUCCESS;
+}
+
+result StoreRegistry::Mount(const String &path, int &storeId) {
+	storeId = FindStore(path);
+	if (storeId >= 0) {
+		return E_SUCCESS;
+	}
+
+	CachingNotesManager *pStore = new CachingNotesManager;
+	result res = pStore->Construct(path);
+	if (IsFailed(res)) {
+		AppLogException("Failed to mount store [%S], error: [%s]", path.GetPointer(), GetErrorMessage(res));
+
+		delete pStore;
+		return res;
+	}
+
+	if (!__backupRoot.IsEmpty()) {
+		pStore->EnableBackup(__backupRoot);
+	}
+	return Attach(pStore, storeId);
+}
+
+result StoreRegistry::Attach(CachingNotesManager *pStore, int &storeId) {
+	storeId = FindStore(pStore->GetPath());
+	if (storeId >= 0) {
+		//two caches over one database would overwrite each other's changes
+		delete pStore;
+		return E_SUCCESS;
+	}
+
+	for (int s = 0; s < MAX_STORES; s++) {
+		if (!__pStores[s]) {
+			storeId = s;
+			break;
+		}
+	}
+	if (storeId < 0) {
+		AppLogException("Failed to mount store [%S], all %d slots are taken", pStore->GetPath().GetPointer(), MAX_STORES);
+
+		delete pStore;
+		return E_OVERFLOW;
+	}
+
+	__pStores[storeId] = pStore;
+	return E_SUCCESS;
+}
+
+result StoreRegistry::Unmount(int storeId) {
+	CachingNotesManager *pStore = GetStore(storeId);
+	if (!pStore) {
+		return E_INVALID_ARG;
+	}
+
+	result res = pStore->Flush();
+	if (IsFailed(res)) {
+		//store stays mounted, its journal still holds the changes
+		AppLogException("Failed to flush store [%S] before unmounting, error: [%s]", pStore->GetPath().GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	delete pStore;
+	__pStores[storeId] = null;
+
+	return E_SUCCESS;
+}
+
+CachingNotesManager *StoreRegistry::GetStore(int storeId) const {
+	if (storeId < 0 || storeId >= MAX_STORES) {
+		return null;
+	}
+	return __pStores[storeId];
+}
+
+int StoreRegistry::FindStore(const String &path) const {
+	for (int s = 0; s < MAX_STORES; s++) {
+		if (__pStores[s] && __pStores[s]->GetPath().Equals(path, true)) {
+			return s;
+		}
+	}
+	return -1;
+}
+
+int StoreRegistry::GetMountedCount(void) const {
+	int count = 0;
+	for (int s = 0; s < MAX_STORES; s++) {
+		if (__pStores[s]) count++;
+	}
+	return count;
+}
+
+result StoreRegistry::AddNote(int storeId, Note *val) {
+	CachingNotesManager *pStore = GetStore(storeId);
+	if (!pStore) {
+		return E_INVALID_ARG;
+	}
+
+	result res = pStore->AddNote(val);
+	if (!IsFailed(res)) {
+		val->SetStoreId(storeId);
+	}
+	return res;
+}
+
+result StoreRegistry::UpdateNote(Note *val) {
+	CachingNotesManager *pStore = GetStore(val->GetStoreId());
+	if (!pStore) {
+		AppLogException("Attempt to update note which doesn't belong to any mounted store");
+		return E_INVALID_ARG;
+	}
+	return pStore->UpdateNote(val);
+}
+
+result StoreRegistry::RemoveNote(Note *val) {
+	CachingNotesManager *pStore = GetStore(val->GetStoreId());
+	if (!pStore) {
+		AppLogException("Attempt to remove note which doesn't belong to any mounted store");
+		return E_INVALID_ARG;
+	}
+	return pStore->RemoveNote(val);
+}
+
+result StoreRegistry::Flush(void) {
+	result res = E_SUCCESS;
+	for (int s = 0; s < MAX_STORES; s++) {
+		if (!__pStores[s]) {
+			continue;
+		}
+
+		//one failing store doesn't keep the others from being written
+		result flush_res = __pStores[s]->Flush();
+		if (IsFailed(flush_res) && !IsFailed(res)) {
+			res = flush_res;
+		}
+	}
+	return res;
+}
+
+void StoreRegistry::ReleaseCachedResults(void) {
+	for (int s = 0; s < MAX_STORES; s++) {
+		if (__pStores[s]) {
+			__pStores[s]->ReleaseCachedResults();
+		}
+	}
+}
+
+void StoreRegistry::FillSortKey(NoteSortKey &key, Note *val, SortType sorting) {
+	key.pNote = val;
+	key.marked = val->GetMarked();
+	key.primary = sorting == SORT_BY_TYPE ? (long long)val->GetType() : val->GetDate();
+
+	//notes in the cache got their keys when loaded, so this never builds one
+	const ByteBuffer *pKey = val->GetTitleKey();
+	key.pTitleKey = pKey ? pKey->GetPointer() : null;
+	key.titleKeyLength = pKey ? pKey->GetLimit() : 0;
+}
+
+void StoreRegistry::SetCursor(NotesCursor &cursor, Note *val, SortType sorting, SortOrder order) {
+	const ByteBuffer *pKey = sorting == SORT_BY_TITLE ? val->GetTitleKey() : null;
+	long long primary = sorting == SORT_BY_TYPE ? (long long)val->GetType() : val->GetDate();
+
+	cursor.Set(sorting, order, val->GetMarked(), primary, pKey, val->GetEntryId());
+}
+
+LinkedListT<Note *> *StoreRegistry::MergeN(LinkedListT<Note *> **ppLists, int skip, int limit, bool &hasMore, Note **ppLastTaken, SortType sorting, SortOrder order) const {
+	TRACE_SCOPE("registry.merge");
+
+	hasMore = false;
+
+	const NoteSortKey *pRuns[MAX_STORES];
+	int counts[MAX_STORES];
+	int runs = 0;
+	int total = 0;
+
+	for (int s = 0; s < MAX_STORES; s++) {
+		if (!ppLists[s]) {
+			continue;
+		}
+
+		int count = ppLists[s]->GetCount();
+		NoteSortKey *pKeys = new NoteSortKey[count > 0 ? count : 1];
+
+		IEnumeratorT<Note *> *pEnum = ppLists[s]->GetEnumeratorN();
+		int i = 0;
+		while (pEnum && !IsFailed(pEnum->MoveNext()) && i < count) {
+			Note *pNote = null;
+			pEnum->GetCurrent(pNote);
+			pNote->SetStoreId(s);
+			FillSortKey(pKeys[i++], pNote, sorting);
+		}
+		if (pEnum) delete pEnum;
+
+		delete ppLists[s];
+		ppLists[s] = null;
+
+		pRuns[runs] = pKeys;
+		counts[runs] = i;
+		runs++;
+		total += i;
+	}
+
+	NoteSortKey *pMerged = new NoteSortKey[total > 0 ? total : 1];
+	NoteSorter::MergeRuns(pRuns, counts, runs, pMerged, sorting, order == SORT_ORDER_ASCENDING);
+
+	for (int r = 0; r < runs; r++) {
+		delete[] pRuns[r];
+	}
+
+	int end = total;
+	if (limit >= 0 && skip + limit < total) {
+		end = skip + limit;
+		hasMore = true;
+	}
+
+	LinkedListT<Note *> *pNotes = new LinkedListT<Note *>;
+	result res = E_SUCCESS;
+	for (int i = skip; i < end; i++) {
+		Note *pNote = pMerged[i].pNote;
+		res = pNotes->Add(pNote);
+		if (IsFailed(res)) {
+			break;
+		}
+
+		if (ppLastTaken) ppLastTaken[pNote->GetStoreId()] = pNote;
+	}
+	delete[] pMerged;
+
+	if (IsFailed(res)) {
+		AppLogException("Failed to build merged notes list, error: [%s]", GetErrorMessage(res));
+
+		delete pNotes;
+		SetLastResult(res);
+		return null;
+	}
+	return pNotes;
+}
+
+LinkedListT<Note *> *StoreRegistry::GetNotesN(SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter) {
+	LinkedListT<Note *> *pLists[MAX_STORES];
+	for (int s = 0; s < MAX_STORES; s++) {
+		pLists[s] = null;
+		if (!__pStores[s]) {
+			continue;
+		}
+
+		pLists[s] = __pStores[s]->GetNotesN(sorting, order, type_filter, filter_mode, filter);
+		if (!pLists[s]) {
+			result res = GetLastResult();
+			AppLogException("Failed to query store [%S], error: [%s]", __pStores[s]->GetPath().GetPointer(), GetErrorMessage(res));
+
+			for (int p = 0; p < s; p++) {
+				if (pLists[p]) delete pLists[p];
+			}
+			SetLastResult(res);
+			return null;
+		}
+	}
+
+	bool has_more = false;
+	return MergeN(pLists, 0, -1, has_more, null, sorting, order);
+}
+
+LinkedListT<Note *> *StoreRegistry::GetNotesPageN(int offset, int limit, bool &hasMore, SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter) {
+	hasMore = false;
+	if (offset < 0 || limit <= 0) {
+		SetLastResult(E_INVALID_ARG);
+		return null;
+	}
+
+	//any store may contribute the whole page, so each is asked for everything up to its end
+	bool store_more = false;
+	LinkedListT<Note *> *pLists[MAX_STORES];
+	for (int s = 0; s < MAX_STORES; s++) {
+		pLists[s] = null;
+		if (!__pStores[s]) {
+			continue;
+		}
+
+		bool more = false;
+		pLists[s] = __pStores[s]->GetNotesPageN(0, offset + limit, more, sorting, order, type_filter, filter_mode, filter);
+		if (!pLists[s]) {
+			result res = GetLastResult();
+			AppLogException("Failed to query store [%S], error: [%s]", __pStores[s]->GetPath().GetPointer(), GetErrorMessage(res));
+
+			for (int p = 0; p < s; p++) {
+				if (pLists[p]) delete pLists[p];
+			}
+			SetLastResult(res);
+			return null;
+		}
+		store_more = store_more || more;
+	}
+
+	LinkedListT<Note *> *pNotes = MergeN(pLists, offset, limit, hasMore, null, sorting, order);
+	hasMore = hasMore || store_more;
+	return pNotes;
+}
+
+LinkedListT<Note *> *StoreRegistry::GetNotesAfterN(MergedNotesCursor &cursor, int limit, bool &hasMore, SortType sorting, SortOrder order, NoteType type_filter, FilterType filter_mode, const String &filter) {
+	hasMore = false;
+	if (limit <= 0) {
+		SetLastResult(E_INVALID_ARG);
+		return null;
+	}
+
+	for (int s = 0; s < MAX_STORES; s++) {
+		if (!cursor.__stores[s].Matches(sorting, order)) {
+			cursor.Reset();
+			break;
+		}
+	}
+
+	bool store_more = false;
+	LinkedListT<Note *> *pLists[MAX_STORES];
+	for (int s = 0; s < MAX_STORES; s++) {
+		pLists[s] = null;
+		if (!__pStores[s]) {
+			continue;
+		}
+
+		//store advances the cursor it's given past everything it returns, but only notes which make it into the page count
+		const NotesCursor &stored = cursor.__stores[s];
+		NotesCursor scratch;
+		if (!stored.IsAtStart()) {
+			scratch.Set(sorting, order, stored.GetMarked(), stored.GetPrimary(), stored.GetTitleKey(), stored.GetEntryId());
+		}
+
+		bool more = false;
+		pLists[s] = __pStores[s]->GetNotesAfterN(scratch, limit, more, sorting, order, type_filter, filter_mode, filter);
+		if (!pLists[s]) {
+			result res = GetLastResult();
+			AppLogException("Failed to query store [%S], error: [%s]", __pStores[s]->GetPath().GetPointer(), GetErrorMessage(res));
+
+			for (int p = 0; p < s; p++) {
+				if (pLists[p]) delete pLists[p];
+			}
+			SetLastResult(res);
+			return null;
+		}
+		store_more = store_more || more;
+	}
+
+	Note *pLastTaken[MAX_STORES];
+	for (int s = 0; s < MAX_STORES; s++) {
+		pLastTaken[s] = null;
+	}
+
+	LinkedListT<Note *> *pNotes = MergeN(pLists, 0, limit, hasMore, pLastTaken, sorting, order);
+	if (pNotes) {
+		for (int s = 0; s < MAX_STORES; s++) {
+			if (pLastTaken[s]) {
+				SetCursor(cursor.__stores[s], pLastTaken[s], sorting, order);
+			}
+		}
+	}
+	hasMore = hasMore || store_more;
+	return pNotes;
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <FApp.h>
+
+#include "StringTable.h"
+
+using namespace Osp::App;
+using namespace Osp::Ui::Controls;
+
+StringTable::Entry *StringTable::__pEntries = null;
+int StringTable::__capacity = 0;
+int StringTable::__count = 0;
+ArrayListT<ContainerKeys *> *StringTable::__pContainers = null;
+int StringTable::__language = -1;
+
+ResourceLanguage StringTable::GetLanguage(void) {
+	if (__language < 0) {
+		__language = RES_LANGUAGE_ENG;
+
+		//device language and system locale may differ, so the table follows whatever AppResource resolves
+		AppResource *pRes = Application::GetInstance()->GetAppResource();
+		for (int id = 0; id < STRING_COUNT; id++) {
+			String value;
+			if (IsFailed(pRes->GetString(RES_STRING_IDS[id], value))) {
+				continue;
+			}
+
+			//strings spelled the same in several languages don't tell anything, the next one is tried then
+			int match = -1;
+			int matches = 0;
+			for (int i = 0; i < RES_LANGUAGE_COUNT; i++) {
+				if (value.Equals(RES_STRINGS[i][id], true)) {
+					match = i;
+					matches++;
+				}
+			}
+			if (matches == 1) {
+				__language = match;
+				break;
+			}
+		}
+	}
+	return (ResourceLanguage)__language;
+}
+
+String StringTable::Get(StringId id) {
+	if (id < 0 || id >= STRING_COUNT) {
+		SetLastResult(E_INVALID_ARG);
+		return String(L"");
+	}
+
+	SetLastResult(E_SUCCESS);
+	return String(RES_STRINGS[GetLanguage()][id]);
+}
+
+int StringTable::FindSlot(const String &id, int hash) {
+	int mask = __capacity - 1;
+	int slot = hash & mask;
+	while (__pEntries[slot].used) {
+		if (__pEntries[slot].hash == hash && __pEntries[slot].id.Equals(id, true)) {
+			break;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+void StringTable::Grow(void) {
+	Entry *pOld = __pEntries;
+	int old_capacity = __capacity;
+
+	__capacity = old_capacity > 0 ? old_capacity * 2 : INITIAL_CAPACITY;
+	__pEntries = new Entry[__capacity];
+	for (int i = 0; i < __capacity; i++) {
+		__pEntries[i].used = false;
+	}
+
+	for (int i = 0; i < old_capacity; i++) {
+		if (pOld[i].used) {
+			__pEntries[FindSlot(pOld[i].id, pOld[i].hash)] = pOld[i];
+		}
+	}
+	if (pOld) delete[] pOld;
+}
+
+String StringTable::Get(const String &id) {
+	if ((__count + 1) * 2 > __capacity) {
+		Grow();
+	}
+
+	int hash = id.GetHashCode();
+	Entry &entry = __pEntries[FindSlot(id, hash)];
+	if (!entry.used) {
+		entry.used = true;
+		entry.hash = hash;
+		entry.id = id;
+		entry.value = id;
+		entry.res = Application::GetInstance()->GetAppResource()->GetString(id, entry.value);
+		if (IsFailed(entry.res)) {
+			AppLogDebug("Could not retrieve string by id [%S]", id.GetPointer());
+		}
+		__count++;
+	}
+
+	SetLastResult(entry.res);
+	return entry.value;
+}
+
+ContainerKeys *StringTable::BuildContainerKeysN(const Container &cont) {
+	ContainerKeys *pKeys = new ContainerKeys;
+	pKeys->name = cont.GetName();
+	pKeys->titleKey = pKeys->name + L"_TITLE";
+	pKeys->softkeyKeys[0] = pKeys->name + L"_SOFTKEY0_TEXT";
+	pKeys->softkeyKeys[1] = pKeys->name + L"_SOFTKEY1_TEXT";
+
+	pKeys->controlCount = cont.GetControlCount();
+	pKeys->pControlKeys = new String[pKeys->controlCount > 0 ? pKeys->controlCount : 1];
+	for (int i = 0; i < pKeys->controlCount; i++) {
+		const Control *pCtrl = cont.GetControl(i);
+		if (pCtrl) {
+			pKeys->pControlKeys[i] = pCtrl->GetName() + L"_TEXT";
+		}
+	}
+	return pKeys;
+}
+
+const ContainerKeys *StringTable::GetContainerKeys(const Container &cont) {
+	String name = cont.GetName();
+	if (name.IsEmpty()) {
+		return null;
+	}
+
+	if (!__pContainers) {
+		__pContainers = new ArrayListT<ContainerKeys *>;
+		__pContainers->Construct(MAX_CONTAINERS);
+	}
+
+	int count = __pContainers->GetCount();
+	for (int i = 0; i < count; i++) {
+		ContainerKeys *pKeys = null;
+		__pContainers->GetAt(i, pKeys);
+		//same resource always yields the same controls, a different count means controls were added in code
+		if (pKeys->name.Equals(name, true) && pKeys->controlCount == cont.GetControlCount()) {
+			return pKeys;
+		}
+	}
+
+	ContainerKeys *pKeys = BuildContainerKeysN(cont);
+	if (count >= MAX_CONTAINERS) {
+		ContainerKeys *pOldest = null;
+		__pContainers->GetAt(0, pOldest);
+		__pContainers->RemoveAt(0);
+		delete[] pOldest->pControlKeys;
+		delete pOldest;
+	}
+	__pContainers->Add(pKeys);
+
+	return pKeys;
+}
+
+void StringTable::Shutdown(void) {
+	if (__pEntries) {
+		delete[] __pEntries;
+		__pEntries = null;
+	}
+	__capacity = __count = 0;
+
+	if (__pContainers) {
+		int count = __pContainers->GetCount();
+		for (int i = 0; i < count; i++) {
+			ContainerKeys *pKeys = null;
+			__pContainers->GetAt(i, pKeys);
+			delete[] pKeys->pControlKeys;
+			delete pKeys;
+		}
+		delete __pContainers;
+		__pContainers = null;
+	}
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <FText.h>
+
+#include "TextFolderImporter.h"
+#include "TextUtils.h"
+
+using namespace Osp::Text;
+
+TextFolderImporter::TextFolderImporter(void) {
+	__rootDir = L"";
+	__currentDir = L"";
+	__pPendingDirs = null;
+	__pDir = null;
+	__pDirEnum = null;
+	__pCurrent = null;
+}
+
+TextFolderImporter::~TextFolderImporter(void) {
+	if (__pCurrent) delete __pCurrent;
+	if (__pDirEnum) delete __pDirEnum;
+	if (__pDir) delete __pDir;
+	if (__pPendingDirs) {
+		__pPendingDirs->RemoveAll(true);
+		delete __pPendingDirs;
+	}
+}
+
+result TextFolderImporter::Construct(const String &dir) {
+	__rootDir = dir;
+	if (!__rootDir.EndsWith(L"/")) {
+		__rootDir.Append('/');
+	}
+
+	__pPendingDirs = new Stack;
+	return Reset();
+}
+
+result TextFolderImporter::Reset(void) {
+	if (__pCurrent) {
+		delete __pCurrent;
+		__pCurrent = null;
+	}
+	__pPendingDirs->RemoveAll(true);
+	__pPendingDirs->Push(*(new String(__rootDir)));
+
+	return OpenNextDirectory();
+}
+
+result TextFolderImporter::OpenNextDirectory(void) {
+	if (__pDirEnum) {
+		delete __pDirEnum;
+		__pDirEnum = null;
+	}
+	if (__pDir) {
+		delete __pDir;
+		__pDir = null;
+	}
+
+	while (__pPendingDirs->GetCount() > 0) {
+		String *pPath = static_cast<String*>(__pPendingDirs->Pop());
+		__currentDir = *pPath;
+		delete pPath;
+
+		__pDir = new Directory;
+		result res = __pDir->Construct(__currentDir);
+		if (!IsFailed(res)) {
+			__pDirEnum = __pDir->ReadN();
+			res = GetLastResult();
+			if (!IsFailed(res) && __pDirEnum) {
+				return E_SUCCESS;
+			}
+		}
+
+		AppLogException("Failed to read import directory [%S], skipping it, error: [%s]", __currentDir.GetPointer(), GetErrorMessage(res));
+		delete __pDir;
+		__pDir = null;
+	}
+	return E_OBJ_NOT_FOUND;
+}
+
+result TextFolderImporter::MoveNext(void) {
+	if (__pCurrent) {
+		delete __pCurrent;
+		__pCurrent = null;
+	}
+
+	while (__pDirEnum) {
+		if (IsFailed(__pDirEnum->MoveNext())) {
+			if (IsFailed(OpenNextDirectory())) {
+				return E_OUT_OF_RANGE;
+			}
+			continue;
+		}
+
+		DirEntry entry = __pDirEnum->GetCurrentDirEntry();
+		String name = entry.GetName();
+		if (name.Equals(String(L".")) || name.Equals(String(L".."))) {
+			continue;
+		}
+
+		String path = __currentDir;
+		path.Append(name);
+
+		if (entry.IsDirectory()) {
+			path.Append('/');
+			__pPendingDirs->Push(*(new String(path)));
+			continue;
+		}
+
+		String lower;
+		name.ToLowerCase(lower);
+
+		bool markdown = lower.EndsWith(L".md") || lower.EndsWith(L".markdown");
+		if (!markdown && !lower.EndsWith(L".txt")) {
+			continue;
+		}
+		if (entry.GetFileSize() > MAX_FILE_SIZE) {
+			AppLogException("File [%S] is too large to be imported as a note, skipping it", path.GetPointer());
+			continue;
+		}
+
+		__pCurrent = ReadNoteN(path, markdown);
+		if (!__pCurrent) {
+			continue;
+		}
+		__pCurrent->SetDate(ToUnixSeconds(entry.GetDateTime()));
+
+		return E_SUCCESS;
+	}
+	return E_OUT_OF_RANGE;
+}
+
+result TextFolderImporter::GetCurrent(Note *&obj) const {
+	if (!__pCurrent) {
+		return E_INVALID_STATE;
+	}
+	obj = __pCurrent;
+	return E_SUCCESS;
+}
+
+Note *TextFolderImporter::ReadNoteN(const String &path, bool markdown) const {
+	FileAttributes attr;
+	result res = File::GetAttributes(path, attr);
+	if (IsFailed(res)) {
+		AppLogException("Failed to get attributes of file [%S], error: [%s]", path.GetPointer(), GetErrorMessage(res));
+		return null;
+	}
+
+	File file;
+	res = file.Construct(path, L"r");
+	if (IsFailed(res)) {
+		AppLogException("Failed to open file [%S] for import, error: [%s]", path.GetPointer(), GetErrorMessage(res));
+		return null;
+	}
+
+	int size = (int)attr.GetFileSize();
+
+	ByteBuffer buf;
+	res = buf.Construct(size + 1);
+	if (IsFailed(res)) {
+		AppLogException("Failed to allocate buffer for file [%S], error: [%s]", path.GetPointer(), GetErrorMessage(res));
+		return null;
+	}
+
+	if (size > 0) {
+		res = file.Read(buf);
+		if (IsFailed(res)) {
+			AppLogException("Failed to read file [%S] for import, error: [%s]", path.GetPointer(), GetErrorMessage(res));
+			return null;
+		}
+	}
+	buf.SetByte('\0');
+	buf.Flip();
+
+	//skip UTF-8 byte order mark
+	if (buf.GetLimit() > 3) {
+		byte b0, b1, b2;
+		buf.GetByte(0, b0); buf.GetByte(1, b1); buf.GetByte(2, b2);
+		if (b0 == 0xEF && b1 == 0xBB && b2 == 0xBF) {
+			buf.SetPosition(3);
+		}
+	}
+
+	String text;
+	Utf8Encoding utf8;
+	res = utf8.GetString(buf, text);
+	if (IsFailed(res)) {
+		AppLogException("Failed to decode file [%S] as UTF-8, error: [%s]", path.GetPointer(), GetErrorMessage(res));
+		return null;
+	}
+
+	text.Trim();
+	if (text.IsEmpty()) {
+		return null;
+	}
+
+	Note *pNote = new Note;
+	pNote->Construct(NOTE_TYPE_TEXT);
+	pNote->SetTitle(ExtractTitle(text, markdown));
+	pNote->SetText(text);
+
+	return pNote;
+}
+
+String TextFolderImporter::ExtractTitle(const String &text, bool markdown) {
+	int eol = -1;
+	String line;
+	if (IsFailed(text.IndexOf('\n', 0, eol))) {
+		line = text;
+	} else {
+		text.SubString(0, eol, line);
+	}
+	line.Trim();
+
+	if (markdown) {
+		int start = 0;
+		mchar ch = 0;
+		while (start < line.GetLength() && !IsFailed(line.GetCharAt(start, ch)) && ch == '#') {
+			start++;
+		}
+		if (start > 0) {
+			line.Remove(0, start);
+			line.Trim();
+		}
+	}
+
+	//same limit TextNoteForm uses for automatic titles
+	return TextUtils::Truncate(line, TextUtils::AUTO_TITLE_LENGTH);
+}
+
+long long TextFolderImporter::ToUnixSeconds(const DateTime &dt) {
+	DateTime epoch;
+	epoch.SetValue(1970, 1, 1, 0, 0, 0);
+
+	return (dt.GetTime().GetTicks() - epoch.GetTime().GetTicks()) / 1000;
+}
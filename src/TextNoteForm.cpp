@@ -17,6 +17,14 @@
  */
 #include "TextNoteForm.h"
 #include "FormManager.h"
+#include "TextUtils.h"
+
+static const mchar *MARK_BITMAP_NAMES[] = {
+	L"button_marked_unpressed.png",
+	L"button_marked_pressed.png",
+	L"button_unmarked_unpressed.png",
+	L"button_unmarked_pressed.png"
+};
 
 TextNoteForm::TextNoteForm(CallbackInfo cbInfo, Note *note) {
 	__pTitleField = null;
@@ -30,31 +38,40 @@ TextNoteForm::TextNoteForm(CallbackInfo cbInfo, Note *note) {
 	__pNote = note;
 	__isMarked = false;
 
+	for (int i = 0; i < MARK_BITMAP_COUNT; i++) {
+		__pMarkBitmaps[i] = null;
+	}
+
 	__cbInfo = cbInfo;
 }
 
 TextNoteForm::~TextNoteForm(void) {
 	if (__pOptionMenu) delete __pOptionMenu;
+	for (int i = 0; i < MARK_BITMAP_COUNT; i++) {
+		if (__pMarkBitmaps[i]) delete __pMarkBitmaps[i];
+	}
 }
 
 result TextNoteForm::Construct(void) {
-	result res = Form::Construct(L"IDF_TEXTNOTE_FORM");
+	result res = Form::Construct(IDF_TEXTNOTE_FORM);
 	if (IsFailed(res)) {
 		AppLogException("Failed to construct form's XML structure, error [%s]", GetErrorMessage(res));
 		return res;
 	}
 
-	__pTitleField = static_cast<EditField*>(GetControl(L"IDC_TEXTNOTE_FORM_TITLEFIELD"));
-	__pMarkButton = static_cast<Button*>(GetControl(L"IDC_TEXTNOTE_FORM_MARK_BUTTON"));
-	__pTextCaption = static_cast<Label*>(GetControl(L"IDC_TEXTNOTE_FORM_CAPTION"));
-	__pTextArea = static_cast<EditArea*>(GetControl(L"IDC_TEXTNOTE_FORM_EDITAREA"));
-	__pTimeCaption = static_cast<Label*>(GetControl(L"IDC_TEXTNOTE_FORM_TIMECAPTION"));
-	__pTimeLabel = static_cast<Label*>(GetControl(L"IDC_TEXTNOTE_FORM_TIMELABEL"));
+	__pTitleField = static_cast<EditField*>(GetControl(IDC_TEXTNOTE_FORM_TITLEFIELD));
+	__pMarkButton = static_cast<Button*>(GetControl(IDC_TEXTNOTE_FORM_MARK_BUTTON));
+	__pTextCaption = static_cast<Label*>(GetControl(IDC_TEXTNOTE_FORM_CAPTION));
+	__pTextArea = static_cast<EditArea*>(GetControl(IDC_TEXTNOTE_FORM_EDITAREA));
+	__pTimeCaption = static_cast<Label*>(GetControl(IDC_TEXTNOTE_FORM_TIMECAPTION));
+	__pTimeLabel = static_cast<Label*>(GetControl(IDC_TEXTNOTE_FORM_TIMELABEL));
 
 	if (!CheckControls()) {
 		AppLogException("Failed to initialize custom form structure");
 		return E_INIT_FAILED;
 	}
+	//create mode enlarges text area, reused form needs the original size back
+	__textAreaSize = __pTextArea->GetSize();
 
 	__pOptionMenu = new OptionMenu;
 	res = __pOptionMenu->Construct();
@@ -72,37 +89,31 @@ bool TextNoteForm::CheckControls(void) const {
 	} else return false;
 }
 
-result TextNoteForm::UpdateMarkButton(void) {
-	String sNormal = L"button_marked_unpressed.png";
-	String sPressed = L"button_marked_pressed.png";
-	if (!__isMarked) {
-		sNormal = L"button_unmarked_unpressed.png";
-		sPressed = L"button_unmarked_pressed.png";
+Bitmap *TextNoteForm::GetMarkBitmap(MarkBitmap index) {
+	if (!__pMarkBitmaps[index]) {
+		__pMarkBitmaps[index] = GetBitmapN(MARK_BITMAP_NAMES[index]);
 	}
+	return __pMarkBitmaps[index];
+}
 
-	Bitmap *pNormal = GetBitmapN(sNormal);
-	result res1 = GetLastResult();
-	Bitmap *pPressed = GetBitmapN(sPressed);
-	result res2 = GetLastResult();
-
-	if (IsFailed(res1) || IsFailed(res2)) {
-		AppLogException("Failed to update mark button icon, error1: [%s], error2: [%s]", GetErrorMessage(res1), GetErrorMessage(res2));
-		if (pNormal) delete pNormal;
-		if (pPressed) delete pPressed;
+result TextNoteForm::UpdateMarkButton(void) {
+	Bitmap *pNormal = GetMarkBitmap(__isMarked ? MARK_BITMAP_MARKED_NORMAL : MARK_BITMAP_UNMARKED_NORMAL);
+	Bitmap *pPressed = GetMarkBitmap(__isMarked ? MARK_BITMAP_MARKED_PRESSED : MARK_BITMAP_UNMARKED_PRESSED);
+	if (!pNormal || !pPressed) {
+		AppLogException("Failed to update mark button icon, error: [%s]", GetErrorMessage(GetLastResult()));
+		return E_FAILURE;
 	}
 
+	//button keeps its own copies
 	__pMarkButton->SetNormalBackgroundBitmap(*pNormal);
 	__pMarkButton->SetPressedBackgroundBitmap(*pPressed);
 
-	delete pNormal;
-	delete pPressed;
-
-	return RefreshForm();
+	return E_SUCCESS;
 }
 
 result TextNoteForm::OnLeftSoftkeyClicked(const Control &src) {
 	if (__pTextArea->GetTextLength() == 0) {
-		ShowMessageBox(GetString(L"SAVEFORM_MBOX_DIR_TITLE"), GetString(L"TEXTNOTE_FORM_MBOX_MSG"),MSGBOX_STYLE_OK);
+		ShowMessageBox(GetString(STR_SAVEFORM_MBOX_DIR_TITLE), GetString(STR_TEXTNOTE_FORM_MBOX_MSG),MSGBOX_STYLE_OK);
 		return E_SUCCESS;
 	}
 
@@ -116,18 +127,12 @@ result TextNoteForm::OnLeftSoftkeyClicked(const Control &src) {
 		pCbData->SetMarked(__isMarked);
 		pCbData->SetText(__pTextArea->GetText());
 
-		String title = L"";
+		//note keeps its own copy of the text, so it's cut from there instead of asking the area again
 		if (__pTitleField->GetTextLength() == 0) {
-			if (__pTextArea->GetTextLength() >= 57) {
-				__pTextArea->GetText().SubString(0, 57, title);
-				title.Append(L"...");
-			} else {
-				title = __pTextArea->GetText();
-			}
+			pCbData->SetTitle(TextUtils::Truncate(pCbData->GetText(), TextUtils::AUTO_TITLE_LENGTH));
 		} else {
-			title = __pTitleField->GetText();
+			pCbData->SetTitle(__pTitleField->GetText());
 		}
-		pCbData->SetTitle(title);
 
 		pCbData->SetSerialized(false);
 		__cbInfo.callbackHandler->DialogCallback(__cbInfo.taskID, this, DIALOG_RESULT_OK, (void*)pCbData);
@@ -144,40 +149,69 @@ result TextNoteForm::OnRightSoftkeyClicked(const Control &src) {
 
 result TextNoteForm::OnMarkButtonClicked(const Control &src) {
 	__isMarked = !__isMarked;
-	return UpdateMarkButton();
+
+	result res = UpdateMarkButton();
+	if (IsFailed(res)) {
+		return res;
+	}
+	return RefreshForm();
 }
 
-result TextNoteForm::Initialize(void) {
-	__pTitleField->SetTitleText(GetString(L"TEXTNOTE_FORM_TITLEFIELD_TITLE"));
-	__pTextCaption->SetText(GetString(L"TEXTNOTE_FORM_TEXT_CAPTION"));
-	__pTimeCaption->SetText(GetString(L"TEXTNOTE_FORM_TIME_CAPTION"));
+result TextNoteForm::Reset(CallbackInfo cbInfo, Note *note) {
+	__cbInfo = cbInfo;
+	__pNote = note;
 
-	SetSoftkeyText(SOFTKEY_1, GetString(L"TEXTNOTE_FORM_SOFTKEY_CANCEL"));
+	//form that wasn't shown yet applies the note in Initialize()
+	if (!IsInitialized()) {
+		return E_SUCCESS;
+	}
+	return ApplyNote();
+}
 
+result TextNoteForm::ApplyNote(void) {
 	result res = E_SUCCESS;
 	if (__pNote) {
 		//edit mode
-		SetTitleText(GetString(L"TEXTNOTE_FORM_TITLE_EDIT"), ALIGNMENT_LEFT);
-		SetSoftkeyText(SOFTKEY_0, GetString(L"TEXTNOTE_FORM_SOFTKEY_ACCEPT_EDIT"));
+		SetTitleText(GetString(STR_TEXTNOTE_FORM_TITLE_EDIT), ALIGNMENT_LEFT);
+		SetSoftkeyText(SOFTKEY_0, GetString(STR_TEXTNOTE_FORM_SOFTKEY_ACCEPT_EDIT));
 
 		__pTitleField->SetText(__pNote->GetTitle());
 		__pTextArea->SetText(__pNote->GetText());
+		__pTextArea->SetSize(__textAreaSize);
 		__pTimeLabel->SetText(GetLocaleSpecificDatetime(__pNote->GetDate()));
+		__pTimeCaption->SetShowState(true);
+		__pTimeLabel->SetShowState(true);
 		__isMarked = __pNote->GetMarked();
-
-		res = UpdateMarkButton();
-		if (IsFailed(res)) {
-			AppLogException("Failed to initialize form from existing note object, error: [%s]", GetErrorMessage(res));
-			return res;
-		}
 	} else {
 		//create mode
-		SetTitleText(GetString(L"TEXTNOTE_FORM_TITLE_NEW"), ALIGNMENT_LEFT);
-		SetSoftkeyText(SOFTKEY_0, GetString(L"TEXTNOTE_FORM_SOFTKEY_ACCEPT_NEW"));
+		SetTitleText(GetString(STR_TEXTNOTE_FORM_TITLE_NEW), ALIGNMENT_LEFT);
+		SetSoftkeyText(SOFTKEY_0, GetString(STR_TEXTNOTE_FORM_SOFTKEY_ACCEPT_NEW));
 
+		__pTitleField->SetText(L"");
+		__pTextArea->SetText(L"");
 		__pTextArea->SetSize(460,450);
 		__pTimeCaption->SetShowState(false);
 		__pTimeLabel->SetShowState(false);
+		__isMarked = false;
+	}
+
+	res = UpdateMarkButton();
+	if (IsFailed(res)) {
+		AppLogException("Failed to initialize form from note object, error: [%s]", GetErrorMessage(res));
+	}
+	return res;
+}
+
+result TextNoteForm::Initialize(void) {
+	__pTitleField->SetTitleText(GetString(STR_TEXTNOTE_FORM_TITLEFIELD_TITLE));
+	__pTextCaption->SetText(GetString(STR_TEXTNOTE_FORM_TEXT_CAPTION));
+	__pTimeCaption->SetText(GetString(STR_TEXTNOTE_FORM_TIME_CAPTION));
+
+	SetSoftkeyText(SOFTKEY_1, GetString(STR_TEXTNOTE_FORM_SOFTKEY_CANCEL));
+
+	result res = ApplyNote();
+	if (IsFailed(res)) {
+		return res;
 	}
 
 	RegisterButtonPressEvent(__pMarkButton, ID_MARK_BUTTON_CLICKED, HANDLER(TextNoteForm::OnMarkButtonClicked));
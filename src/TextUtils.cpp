@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string.h>
+
+#include "TextUtils.h"
+
+TextBuilder::TextBuilder(void) {
+	__pChars = __stack;
+	__length = 0;
+	__capacity = STACK_CAPACITY;
+	__failed = false;
+}
+
+TextBuilder::~TextBuilder(void) {
+	if (__pChars != __stack) delete[] __pChars;
+}
+
+result TextBuilder::Reserve(int extra) {
+	//one spare character is always kept for the terminator ToString() puts there
+	if (__failed) {
+		return E_OUT_OF_MEMORY;
+	}
+	if (__length + extra < __capacity) {
+		return E_SUCCESS;
+	}
+
+	int capacity = __capacity * 2;
+	while (capacity <= __length + extra) {
+		capacity *= 2;
+	}
+
+	mchar *pChars = new mchar[capacity];
+	if (!pChars) {
+		__failed = true;
+		return E_OUT_OF_MEMORY;
+	}
+	memcpy(pChars, __pChars, __length * sizeof(mchar));
+	if (__pChars != __stack) delete[] __pChars;
+
+	__pChars = pChars;
+	__capacity = capacity;
+	return E_SUCCESS;
+}
+
+result TextBuilder::Append(mchar ch) {
+	result res = Reserve(1);
+	if (!IsFailed(res)) {
+		__pChars[__length++] = ch;
+	}
+	return res;
+}
+
+result TextBuilder::Append(const mchar *pStr) {
+	int len = 0;
+	while (pStr[len]) {
+		len++;
+	}
+	return Append(TextView(pStr, len));
+}
+
+result TextBuilder::Append(const TextView &text) {
+	result res = Reserve(text.length);
+	if (!IsFailed(res) && text.length > 0) {
+		memcpy(__pChars + __length, text.pChars, text.length * sizeof(mchar));
+		__length += text.length;
+	}
+	return res;
+}
+
+result TextBuilder::Append(int value) {
+	//digits come out backwards, so they're gathered first
+	mchar digits[12];
+	int count = 0;
+	unsigned int abs_value = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+	do {
+		digits[count++] = (mchar)(L'0' + abs_value % 10);
+		abs_value /= 10;
+	} while (abs_value);
+
+	result res = Reserve(count + 1);
+	if (IsFailed(res)) {
+		return res;
+	}
+	if (value < 0) {
+		__pChars[__length++] = L'-';
+	}
+	while (count > 0) {
+		__pChars[__length++] = digits[--count];
+	}
+	return E_SUCCESS;
+}
+
+void TextBuilder::FoldCase(void) {
+	TextUtils::FoldCaseInPlace(__pChars, __length);
+}
+
+String TextBuilder::ToString(void) const {
+	__pChars[__length] = 0;
+	return String(__pChars);
+}
+
+mchar TextUtils::FoldCase(mchar ch, bool &upper) {
+	upper = false;
+	if (ch >= L'A' && ch <= L'Z') {
+		upper = true;
+		return ch + 0x20;
+	} else if (ch >= 0x00C0 && ch <= 0x00DE && ch != 0x00D7) {
+		upper = true;
+		return ch + 0x20;
+	} else if (ch >= 0x0100 && ch <= 0x017F) {
+		//Latin Extended-A alternates upper and lower case, but the parity shifts twice
+		if ((ch <= 0x0137 || (ch >= 0x014A && ch <= 0x0177)) && (ch % 2) == 0) {
+			upper = true;
+			return ch == 0x0130 ? L'i' : ch + 1;
+		} else if (((ch >= 0x0139 && ch <= 0x0148) || (ch >= 0x0179 && ch <= 0x017E)) && (ch % 2) == 1) {
+			upper = true;
+			return ch + 1;
+		} else if (ch == 0x0178) {
+			upper = true;
+			return 0x00FF;
+		}
+	} else if (ch >= 0x0410 && ch <= 0x042F) {
+		upper = true;
+		return ch + 0x20;
+	} else if (ch >= 0x0400 && ch <= 0x040F) {
+		upper = true;
+		return ch + 0x50;
+	} else if (ch >= 0x0180 && (ch < 0x0430 || ch > 0x045F)) {
+		//Greek, Armenian, Latin Extended-B and the rest are rare enough to go through the slow path
+		mchar lower = Character::ToLower(ch);
+		upper = lower != ch;
+		return lower;
+	}
+	return ch;
+}
+
+void TextUtils::FoldCaseInPlace(mchar *pChars, int length) {
+	for (int i = 0; i < length; i++) {
+		pChars[i] = FoldCase(pChars[i]);
+	}
+}
+
+bool TextUtils::ContainsFolded(const TextView &haystack, const mchar *pFoldedNeedle, int needleLength) {
+	if (needleLength <= 0) {
+		return true;
+	}
+
+	int last = haystack.length - needleLength;
+	mchar first = pFoldedNeedle[0];
+	for (int i = 0; i <= last; i++) {
+		if (FoldCase(haystack.pChars[i]) != first) {
+			continue;
+		}
+
+		int j = 1;
+		while (j < needleLength && FoldCase(haystack.pChars[i + j]) == pFoldedNeedle[j]) {
+			j++;
+		}
+		if (j == needleLength) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool TextUtils::Contains(const TextView &haystack, const TextView &needle) {
+	if (needle.length <= 0) {
+		return true;
+	}
+
+	int last = haystack.length - needle.length;
+	for (int i = 0; i <= last; i++) {
+		if (haystack.pChars[i] == needle.pChars[0] && !memcmp(haystack.pChars + i, needle.pChars, needle.length * sizeof(mchar))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int TextUtils::GetSafeCut(const TextView &text, int maxLength) {
+	if (maxLength >= text.length) {
+		return text.length;
+	}
+
+	int cut = maxLength;
+	while (cut > 0 && (IsLowSurrogate(text.pChars[cut]) || IsCombiningMark(text.pChars[cut]))) {
+		cut--;
+	}
+	return cut;
+}
+
+String TextUtils::Truncate(const String &text, int maxLength) {
+	TextView view(text);
+	if (view.length < maxLength) {
+		return text;
+	}
+
+	TextBuilder title;
+	title.Append(TextView(view.pChars, GetSafeCut(view, maxLength)));
+	title.Append(L"...");
+	return title.ToString();
+}
@@ -0,0 +1,374 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <FMedia.h>
+
+#include "ThumbnailCache.h"
+#include "Trace.h"
+
+using namespace Osp::Media;
+
+static const byte THUMBNAIL_MAGIC[4] = { 'T', 'H', 'B', '1' };
+static const int THUMBNAIL_HEADER_SIZE = 12;
+
+static void PutInt32(byte *pDst, int val) {
+	for (int i = 0; i < 4; i++) {
+		pDst[i] = (byte)((val >> (i * 8)) & 0xFF);
+	}
+}
+
+static int GetInt32(const byte *pSrc) {
+	int val = 0;
+	for (int i = 0; i < 4; i++) {
+		val |= (int)pSrc[i] << (i * 8);
+	}
+	return val;
+}
+
+ThumbnailCache::ThumbnailCache(void) {
+	__dir = L"";
+	__size = 0;
+	__maxEntries = 0;
+	__pTarget = null;
+	__pEntries = null;
+	__pLock = null;
+}
+
+ThumbnailCache::~ThumbnailCache(void) {
+	if (__pEntries) {
+		Clear();
+		delete __pEntries;
+	}
+	if (__pLock) delete __pLock;
+}
+
+result ThumbnailCache::Construct(const String &cacheDir, int size, int maxEntries, Control *pTarget) {
+	if (size <= 0 || maxEntries <= 0) {
+		return E_INVALID_ARG;
+	}
+
+	__dir = cacheDir;
+	if (!__dir.EndsWith(L"/")) {
+		__dir.Append('/');
+	}
+	__size = size;
+	__maxEntries = maxEntries;
+	__pTarget = pTarget;
+
+	result res = Directory::Create(__dir, true);
+	if (IsFailed(res) && res != E_FILE_ALREADY_EXIST) {
+		AppLogException("Failed to create thumbnail directory [%S], error: [%s]", __dir.GetPointer(), GetErrorMessage(res));
+		return res;
+	}
+
+	__pLock = new Mutex;
+	res = __pLock->Create();
+	if (IsFailed(res)) {
+		AppLogException("Failed to create thumbnail cache lock, error: [%s]", GetErrorMessage(res));
+		return res;
+	}
+
+	__pEntries = new ArrayListT<Entry *>;
+	res = __pEntries->Construct(maxEntries);
+	if (IsFailed(res)) {
+		AppLogException("Failed to construct thumbnail list, error: [%s]", GetErrorMessage(res));
+		return res;
+	}
+
+	return Thread::Construct(THREAD_TYPE_EVENT_DRIVEN);
+}
+
+bool ThumbnailCache::OnStart(void) {
+	return true;
+}
+
+void ThumbnailCache::OnStop(void) {
+}
+
+Bitmap *ThumbnailCache::GetThumbnail(const String &path) {
+	if (!__pEntries || path.IsEmpty()) {
+		return null;
+	}
+
+	__pLock->Acquire();
+	for (int i = 0; i < __pEntries->GetCount(); i++) {
+		Entry *pEntry = null;
+		__pEntries->GetAt(i, pEntry);
+		if (pEntry->path.Equals(path, true)) {
+			if (i > 0) {
+				__pEntries->RemoveAt(i);
+				__pEntries->InsertAt(pEntry, 0);
+			}
+			//null while decoding or if the photo couldn't be decoded at all
+			Bitmap *pBitmap = pEntry->pBitmap;
+			__pLock->Release();
+			return pBitmap;
+		}
+	}
+
+	//only this thread evicts, so a bitmap handed out above stays alive until the next call
+	while (__pEntries->GetCount() >= __maxEntries) {
+		RemoveAt(__pEntries->GetCount() - 1);
+	}
+
+	Entry *pEntry = new Entry;
+	pEntry->path = path;
+	pEntry->pBitmap = null;
+	__pEntries->InsertAt(pEntry, 0);
+	__pLock->Release();
+
+	ArrayList *pArgs = new ArrayList;
+	pArgs->Construct();
+	pArgs->Add(*(new String(path)));
+
+	result res = SendUserEvent(REQUEST_DECODE, pArgs);
+	if (IsFailed(res)) {
+		AppLogException("Failed to queue thumbnail decoding for [%S], error: [%s]", path.GetPointer(), GetErrorMessage(res));
+
+		pArgs->RemoveAll(true);
+		delete pArgs;
+	}
+	return null;
+}
+
+void ThumbnailCache::Clear(void) {
+	if (!__pEntries) {
+		return;
+	}
+
+	__pLock->Acquire();
+	while (__pEntries->GetCount() > 0) {
+		RemoveAt(__pEntries->GetCount() - 1);
+	}
+	__pLock->Release();
+}
+
+void ThumbnailCache::RemoveAt(int index) {
+	Entry *pEntry = null;
+	if (IsFailed(__pEntries->GetAt(index, pEntry))) {
+		return;
+	}
+	__pEntries->RemoveAt(index);
+
+	if (pEntry->pBitmap) delete pEntry->pBitmap;
+	delete pEntry;
+}
+
+void ThumbnailCache::OnUserEventReceivedN(RequestId requestId, IList *pArgs) {
+	if (requestId == REQUEST_DECODE && pArgs && pArgs->GetCount() > 0) {
+		String path = *static_cast<String *>(pArgs->GetAt(0));
+
+		Bitmap *pBitmap = LoadN(path);
+
+		bool stored = false;
+		__pLock->Acquire();
+		for (int i = 0; i < __pEntries->GetCount(); i++) {
+			Entry *pEntry = null;
+			__pEntries->GetAt(i, pEntry);
+			if (pEntry->path.Equals(path, true)) {
+				pEntry->pBitmap = pBitmap;
+				stored = true;
+				break;
+			}
+		}
+		__pLock->Release();
+
+		//entry was evicted or cleared while decoding
+		if (!stored && pBitmap) {
+			delete pBitmap;
+			pBitmap = null;
+		}
+
+		if (pBitmap && __pTarget) {
+			ArrayList *pReady = new ArrayList;
+			pReady->Construct();
+			pReady->Add(*(new String(path)));
+
+			result res = __pTarget->SendUserEvent(THUMBNAIL_READY, pReady);
+			if (IsFailed(res)) {
+				pReady->RemoveAll(true);
+				delete pReady;
+			}
+		}
+	}
+
+	if (pArgs) {
+		pArgs->RemoveAll(true);
+		delete pArgs;
+	}
+}
+
+Bitmap *ThumbnailCache::LoadN(const String &path) {
+	FileAttributes attr;
+	result res = File::GetAttributes(path, attr);
+	if (IsFailed(res)) {
+		return null;
+	}
+
+	String cachePath = GetCachePath(path, attr.GetLastModifiedTime());
+	Bitmap *pBitmap = ReadFileN(cachePath);
+	if (pBitmap) {
+		return pBitmap;
+	}
+
+	TRACE_SCOPE("thumbnail.decode");
+
+	Image img;
+	res = img.Construct();
+	if (IsFailed(res)) {
+		return null;
+	}
+
+	//decoder scales while decoding, full resolution image is never held in memory
+	pBitmap = img.DecodeN(path, BITMAP_PIXEL_FORMAT_RGB565, __size, __size);
+	res = GetLastResult();
+	if (!pBitmap) {
+		AppLogException("Failed to decode thumbnail for [%S], error: [%s]", path.GetPointer(), GetErrorMessage(res));
+		return null;
+	}
+
+	res = WriteFile(cachePath, *pBitmap);
+	if (IsFailed(res)) {
+		AppLogException("Failed to save thumbnail for [%S], error: [%s]", path.GetPointer(), GetErrorMessage(res));
+	}
+	return pBitmap;
+}
+
+String ThumbnailCache::GetCachePath(const String &path, const DateTime &modified) const {
+	//FNV-1a over the path is enough to tell files apart, modification time takes care of edited photos
+	unsigned long long hash = 14695981039346656037ULL;
+	for (int i = 0; i < path.GetLength(); i++) {
+		mchar ch = 0;
+		path.GetCharAt(i, ch);
+		hash ^= (unsigned long long)ch;
+		hash *= 1099511628211ULL;
+	}
+
+	static const mchar HEX[] = L"0123456789abcdef";
+	String name = __dir;
+	for (int i = 15; i >= 0; i--) {
+		name.Append(HEX[(hash >> (i * 4)) & 0x0F]);
+	}
+	name.Append('_');
+	name.Append(modified.GetTicks());
+	name.Append(L".thb");
+	return name;
+}
+
+Bitmap *ThumbnailCache::ReadFileN(const String &cachePath) const {
+	FileAttributes attr;
+	if (IsFailed(File::GetAttributes(cachePath, attr)) || attr.GetFileSize() < THUMBNAIL_HEADER_SIZE) {
+		return null;
+	}
+
+	File file;
+	result res = file.Construct(cachePath, L"r");
+	if (IsFailed(res)) {
+		return null;
+	}
+
+	ByteBuffer buf;
+	res = buf.Construct((int)attr.GetFileSize());
+	if (!IsFailed(res)) {
+		res = file.Read(buf);
+	}
+	if (IsFailed(res)) {
+		return null;
+	}
+	buf.Flip();
+
+	const byte *pData = buf.GetPointer();
+	for (int i = 0; i < 4; i++) {
+		if (pData[i] != THUMBNAIL_MAGIC[i]) {
+			return null;
+		}
+	}
+
+	int width = GetInt32(pData + 4);
+	int height = GetInt32(pData + 8);
+	int pixelBytes = width * height * 2;
+	if (width <= 0 || height <= 0 || buf.GetLimit() < THUMBNAIL_HEADER_SIZE + pixelBytes) {
+		return null;
+	}
+
+	ByteBuffer pixels;
+	res = pixels.Construct(pixelBytes);
+	if (!IsFailed(res)) {
+		res = pixels.SetArray(pData + THUMBNAIL_HEADER_SIZE, 0, pixelBytes);
+	}
+	if (IsFailed(res)) {
+		return null;
+	}
+	pixels.Flip();
+
+	Bitmap *pBitmap = new Bitmap;
+	res = pBitmap->Construct(pixels, Dimension(width, height), BITMAP_PIXEL_FORMAT_RGB565);
+	if (IsFailed(res)) {
+		delete pBitmap;
+		return null;
+	}
+	return pBitmap;
+}
+
+result ThumbnailCache::WriteFile(const String &cachePath, const Bitmap &bitmap) const {
+	BufferInfo info;
+	result res = const_cast<Bitmap &>(bitmap).Lock(info);
+	if (IsFailed(res)) {
+		return res;
+	}
+	if (info.bitsPerPixel != 16) {
+		const_cast<Bitmap &>(bitmap).Unlock();
+		return E_UNSUPPORTED_FORMAT;
+	}
+
+	String tmp = cachePath;
+	tmp.Append(L".tmp");
+
+	{
+		File file;
+		res = file.Construct(tmp, L"w");
+		if (!IsFailed(res)) {
+			byte header[THUMBNAIL_HEADER_SIZE];
+			for (int i = 0; i < 4; i++) {
+				header[i] = THUMBNAIL_MAGIC[i];
+			}
+			PutInt32(header + 4, info.width);
+			PutInt32(header + 8, info.height);
+			res = file.Write(header, THUMBNAIL_HEADER_SIZE);
+		}
+
+		//rows may be padded in memory, file holds them tightly packed
+		const byte *pRow = static_cast<const byte *>(info.pPixels);
+		for (int y = 0; y < info.height && !IsFailed(res); y++) {
+			res = file.Write(pRow, info.width * 2);
+			pRow += info.pitch;
+		}
+		if (!IsFailed(res)) {
+			res = file.Flush();
+		}
+	}
+	const_cast<Bitmap &>(bitmap).Unlock();
+
+	//file gets its final name only once completely written
+	if (!IsFailed(res)) {
+		res = File::Move(tmp, cachePath);
+	}
+	if (IsFailed(res)) {
+		File::Remove(tmp);
+	}
+	return res;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef ALLNOTES_TRACING
+
+#include <FIo.h>
+#include <FSystem.h>
+
+#include "BufferedFileWriter.h"
+#include "Trace.h"
+
+using namespace Osp::Io;
+using namespace Osp::System;
+
+TraceEvent *Tracer::__pEvents = null;
+int Tracer::__capacity = 0;
+int Tracer::__next = 0;
+int Tracer::__count = 0;
+Mutex *Tracer::__pLock = null;
+
+result Tracer::Initialize(int capacity) {
+	if (__pEvents) {
+		return E_SUCCESS;
+	}
+	if (capacity <= 0) {
+		return E_INVALID_ARG;
+	}
+
+	__pLock = new Mutex;
+	result res = __pLock->Create();
+	if (IsFailed(res)) {
+		AppLogException("Failed to create trace buffer lock, error: [%s]", GetErrorMessage(res));
+
+		delete __pLock;
+		__pLock = null;
+		return res;
+	}
+
+	__pEvents = new TraceEvent[capacity];
+	__capacity = capacity;
+	__next = 0;
+	__count = 0;
+
+	return E_SUCCESS;
+}
+
+void Tracer::Shutdown(void) {
+	if (__pEvents) {
+		delete[] __pEvents;
+		__pEvents = null;
+	}
+	if (__pLock) {
+		delete __pLock;
+		__pLock = null;
+	}
+	__capacity = __next = __count = 0;
+}
+
+long long Tracer::Now(void) {
+	long long ticks = 0;
+	SystemTime::GetTicks(ticks);
+	return ticks;
+}
+
+void Tracer::Record(const char *name, long long start, long long end) {
+	if (!__pEvents) {
+		return;
+	}
+
+	__pLock->Acquire();
+
+	TraceEvent &ev = __pEvents[__next];
+	ev.name = name;
+	ev.start = start;
+	ev.duration = end - start;
+	ev.threadId = (int)Thread::GetCurrentThread();
+
+	//oldest events are overwritten once the buffer wraps
+	__next = (__next + 1) % __capacity;
+	if (__count < __capacity) {
+		__count++;
+	}
+
+	__pLock->Release();
+}
+
+result Tracer::DumpToFile(const String &path) {
+	if (!__pEvents) {
+		AppLogException("Attempt to dump traces when tracing wasn't initialized");
+		return E_INVALID_STATE;
+	}
+
+	//copy under lock, so that file output doesn't stall traced threads
+	__pLock->Acquire();
+	int count = __count;
+	TraceEvent *pSnapshot = new TraceEvent[count > 0 ? count : 1];
+	int first = (__next - count + __capacity) % __capacity;
+	for (int i = 0; i < count; i++) {
+		pSnapshot[i] = __pEvents[(first + i) % __capacity];
+	}
+	__pLock->Release();
+
+	BufferedFileWriter writer;
+	result res = writer.Construct(path);
+	if (IsFailed(res)) {
+		AppLogException("Failed to open trace dump file [%S], error: [%s]", path.GetPointer(), GetErrorMessage(res));
+		delete[] pSnapshot;
+		return res;
+	}
+
+	writer.WriteUtf8(L"{\"traceEvents\":[", 16);
+	for (int i = 0; i < count && !IsFailed(res); i++) {
+		//ticks are milliseconds, trace viewer expects microseconds
+		String line = i > 0 ? L",\n" : L"\n";
+		line.Append(L"{\"name\":\"");
+		line.Append(String(pSnapshot[i].name));
+		line.Append(L"\",\"ph\":\"X\",\"pid\":1,\"tid\":");
+		line.Append(pSnapshot[i].threadId);
+		line.Append(L",\"ts\":");
+		line.Append(pSnapshot[i].start * 1000);
+		line.Append(L",\"dur\":");
+		line.Append(pSnapshot[i].duration * 1000);
+		line.Append(L"}");
+
+		res = writer.WriteUtf8(line);
+	}
+	if (!IsFailed(res)) {
+		res = writer.WriteUtf8(L"\n]}\n", 4);
+	}
+	if (!IsFailed(res)) {
+		res = writer.Flush(true);
+	}
+	writer.Close();
+
+	delete[] pSnapshot;
+
+	if (IsFailed(res)) {
+		AppLogException("Failed to write trace dump, error: [%s]", GetErrorMessage(res));
+	}
+	return res;
+}
+
+#endif
@@ -0,0 +1,247 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2016 Evgenii Dobrovidov
+# This file is part of "Notes".
+#
+# "Notes" is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# "Notes" is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+#
+"""Generates inc/ResourceIds.h and src/ResourceIds.cpp from UiBuilder resources.
+
+Reads string tables Res/*.xml and forms Res/480x800/*.xml and emits:
+  - StringId enum with one entry per string and per-language string tables,
+  - constants with names of every form, popup and control,
+  - per-container lists of controls which have a '<control>_TEXT' string, for BaseForm::Localize().
+
+Run it from any directory after editing resources in UiBuilder and commit the output:
+    python3 tools/gen_resources.py
+Pass --check to only verify the generated files are up to date.
+"""
+
+import argparse
+import glob
+import os
+import sys
+import xml.etree.ElementTree as ET
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+
+# first one is what the application falls back to for other system languages
+LANGUAGES = [
+	('eng', 'eng-US.xml'),
+	('rus', 'rus-RU.xml'),
+]
+
+CONTAINER_TAGS = ('Form', 'Popup')
+LOCALIZED_TAGS = ('Button', 'Label', 'CheckButton')
+
+BANNER = """/*
+ * Copyright (c) 2016 Evgenii Dobrovidov
+ * This file is part of "Notes".
+ *
+ * "Notes" is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * "Notes" is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with "Notes".  If not, see <http://www.gnu.org/licenses/>.
+ */
+//Generated by tools/gen_resources.py from Res/*.xml, do not edit by hand.
+"""
+
+
+def read_strings(path):
+	strings = {}
+	for node in ET.parse(path).getroot().iter('text'):
+		strings[node.get('id')] = node.text or ''
+	return strings
+
+
+def read_containers(paths):
+	containers = []
+	for path in sorted(paths):
+		root = ET.parse(path).getroot()
+		name = None
+		controls = []
+		for node in root:
+			if node.tag in CONTAINER_TAGS:
+				name = node.get('id')
+			elif node.get('id'):
+				controls.append((node.get('id'), node.tag))
+		if name:
+			containers.append((name, controls))
+	return containers
+
+
+def literal(text):
+	out = []
+	for ch in text:
+		if ch == '\\':
+			out.append('\\\\')
+		elif ch == '"':
+			out.append('\\"')
+		elif ch == '\n':
+			out.append('\\n')
+		elif ch == '\t':
+			out.append('\\t')
+		else:
+			out.append(ch)
+	return 'L"' + ''.join(out) + '"'
+
+
+def generate():
+	tables = [read_strings(os.path.join(ROOT, 'Res', file_name)) for _, file_name in LANGUAGES]
+	ids = sorted(set().union(*[set(t) for t in tables]))
+	index = dict((string_id, i) for i, string_id in enumerate(ids))
+
+	warnings = []
+	for (code, _), table in zip(LANGUAGES, tables):
+		for string_id in ids:
+			if string_id not in table:
+				warnings.append('%s: no string %s, using %s' % (code, string_id, LANGUAGES[0][0]))
+
+	containers = read_containers(glob.glob(os.path.join(ROOT, 'Res', '480x800', '*.xml')))
+
+	h = [BANNER, '#ifndef RESOURCEIDS_H_', '#define RESOURCEIDS_H_', '', '#include <FBase.h>', '']
+	h.append('enum StringId {')
+	for string_id in ids:
+		h.append('\tSTR_%s,' % string_id)
+	h.append('\tSTRING_COUNT')
+	h.append('};')
+	h.append('')
+	h.append('enum ResourceLanguage {')
+	for code, _ in LANGUAGES:
+		h.append('\tRES_LANGUAGE_%s,' % code.upper())
+	h.append('\tRES_LANGUAGE_COUNT')
+	h.append('};')
+	h.append('')
+	h.append('//control with the text it gets from BaseForm::Localize()')
+	h.append('struct ResControlString {')
+	h.append('\tconst mchar *pControl;')
+	h.append('\tStringId text;')
+	h.append('};')
+	h.append('')
+	h.append('//strings of a form or popup; missing title or softkey strings are -1')
+	h.append('struct ResContainerStrings {')
+	h.append('\tconst mchar *pName;')
+	h.append('\tint title;')
+	h.append('\tint softkeys[2];')
+	h.append('\tint controlCount;')
+	h.append('\tconst ResControlString *pControls;')
+	h.append('};')
+	h.append('')
+	h.append('//ISO 639 codes in ResourceLanguage order')
+	h.append('extern const mchar *const RES_LANGUAGE_CODES[RES_LANGUAGE_COUNT];')
+	h.append('//resource IDs in StringId order')
+	h.append('extern const mchar *const RES_STRING_IDS[STRING_COUNT];')
+	h.append('extern const mchar *const RES_STRINGS[RES_LANGUAGE_COUNT][STRING_COUNT];')
+	h.append('')
+	h.append('static const int RES_CONTAINER_COUNT = %d;' % len(containers))
+	h.append('extern const ResContainerStrings RES_CONTAINERS[RES_CONTAINER_COUNT];')
+	for name, controls in containers:
+		h.append('')
+		h.append('static const mchar %s[] = L"%s";' % (name, name))
+		for control, _ in controls:
+			h.append('static const mchar %s[] = L"%s";' % (control, control))
+	h.append('')
+	h.append('#endif')
+	h.append('')
+
+	c = [BANNER, '#include "ResourceIds.h"', '']
+	c.append('const mchar *const RES_LANGUAGE_CODES[RES_LANGUAGE_COUNT] = {')
+	c.append(',\n'.join('\tL"%s"' % code for code, _ in LANGUAGES))
+	c.append('};')
+	c.append('')
+	c.append('const mchar *const RES_STRING_IDS[STRING_COUNT] = {')
+	c.append(',\n'.join('\tL"%s"' % string_id for string_id in ids))
+	c.append('};')
+	c.append('')
+	c.append('const mchar *const RES_STRINGS[RES_LANGUAGE_COUNT][STRING_COUNT] = {')
+	blocks = []
+	for (code, _), table in zip(LANGUAGES, tables):
+		rows = []
+		for string_id in ids:
+			text = table.get(string_id, tables[0].get(string_id, ''))
+			rows.append('\t\t%s' % literal(text))
+		blocks.append('\t{\n' + ',\n'.join(rows) + '\n\t}')
+	c.append(',\n'.join(blocks))
+	c.append('};')
+
+	entries = []
+	for name, controls in containers:
+		localized = [control for control, tag in controls if tag in LOCALIZED_TAGS and control + '_TEXT' in index]
+		array = 'null'
+		if localized:
+			array = name + '_CONTROLS'
+			c.append('')
+			c.append('static const ResControlString %s[] = {' % array)
+			c.append(',\n'.join('\t{ %s, STR_%s_TEXT }' % (control, control) for control in localized))
+			c.append('};')
+
+		def string_ref(key):
+			return 'STR_' + key if key in index else '-1'
+
+		entries.append('\t{ %s, %s, { %s, %s }, %d, %s }' % (name, string_ref(name + '_TITLE'),
+			string_ref(name + '_SOFTKEY0_TEXT'), string_ref(name + '_SOFTKEY1_TEXT'), len(localized), array))
+
+	c.append('')
+	c.append('const ResContainerStrings RES_CONTAINERS[RES_CONTAINER_COUNT] = {')
+	c.append(',\n'.join(entries))
+	c.append('};')
+	c.append('')
+
+	return '\n'.join(h), '\n'.join(c), warnings
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+	parser.add_argument('--check', action='store_true', help='fail if generated files are out of date')
+	args = parser.parse_args()
+
+	header, source, warnings = generate()
+	for warning in warnings:
+		sys.stderr.write('warning: %s\n' % warning)
+
+	outputs = [
+		(os.path.join(ROOT, 'inc', 'ResourceIds.h'), header),
+		(os.path.join(ROOT, 'src', 'ResourceIds.cpp'), source),
+	]
+
+	stale = False
+	for path, content in outputs:
+		current = None
+		if os.path.exists(path):
+			with open(path, encoding='utf-8', newline='') as f:
+				current = f.read()
+		if current == content:
+			continue
+
+		stale = True
+		if args.check:
+			sys.stderr.write('%s is out of date\n' % os.path.relpath(path, ROOT))
+		else:
+			with open(path, 'w', encoding='utf-8', newline='') as f:
+				f.write(content)
+			print('wrote %s' % os.path.relpath(path, ROOT))
+
+	return 1 if args.check and stale else 0
+
+
+if __name__ == '__main__':
+	sys.exit(main())